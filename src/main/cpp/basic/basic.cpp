@@ -13,6 +13,7 @@
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
 #include <iostream>
+#include "../dsl/isolate.h"
 #include "parser.h"
 #include "builtins.h"
 
@@ -22,18 +23,21 @@ namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Basic::root_env() {
-  return init_natives(pushFrame("root"));
+  // laid out from the analyzed globals
+  return init_natives(pushFrame("root", symbols, DENV_NIL));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Basic::interpret() {
   BasicParser p(source);
-  root_env();
   dataSlots.clear();
   defs.clear();
   auto tree= p.parse();
   DEBUG("%s", PRN(tree));
-  return check(tree), eval(tree);
+  check(tree);
+  folded= d::Folder().run(tree);
+  root_env();
+  return eval(tree);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -64,15 +68,26 @@ d::DValue Basic::eval(d::DAst tree) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Basic::pushFrame(cstdstr& name) {
+  callers.push(stack);
   return (stack = d::Frame::make(name, stack));
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DFrame Basic::pushFrame(cstdstr& name, d::DTable scope, d::DFrame outer) {
+  callers.push(stack);
+  return (stack = d::Frame::make(name, scope, outer));
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Basic::popFrame() {
   if (stack) {
     auto f= stack;
     DEBUG("Frame: %s", PSTR(f));
-    stack= stack->getOuter();
+    if (callers.empty())
+      stack= stack->getOuter();
+    else
+    { stack= callers.top();
+      callers.pop(); }
     return f;
   } else {
     return DENV_NIL;
@@ -101,16 +116,49 @@ d::DValue Basic::getValue(cstdstr& name) const {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static StrVec TYPES {"INT", "REAL", "STRING"};
-static std::map<stdstr,d::DSymbol> BITS {
-  {TYPES[0], d::Symbol::make(TYPES[0])},
-  {TYPES[1], d::Symbol::make(TYPES[1])},
-  {TYPES[2], d::Symbol::make(TYPES[2])}
-};
+d::DValue Basic::setValue(cstdstr& name, d::DValue v, d::NameCache& c) {
+  ensure_data_type(name,v);
+  return stack ? stack->set(name, v, c) : DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Basic::getValue(cstdstr& name, d::NameCache& c) const {
+  return stack ? stack->get(name, c) : DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Basic::setValue(const d::LexAddr& a, d::DValue v) {
+  return stack ? stack->set(a.depth, a.slot, v) : DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Basic::getValue(const d::LexAddr& a) const {
+  return stack ? stack->get(a.depth, a.slot) : DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value Basic::load(const d::LexAddr& a) const {
+  return stack ? stack->load(a.depth, a.slot) : d::Value();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Basic::store(const d::LexAddr& a, const d::Value& v) {
+  if (stack) { stack->store(a.depth, a.slot, v); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// made per run, symbols are never shared across isolates
+static d::SymbolMap bits() {
+  return d::SymbolMap {
+    {"INT", d::Symbol::make("INT")},
+    {"REAL", d::Symbol::make("REAL")},
+    {"STRING", d::Symbol::make("STRING")}
+  };
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Basic::check(d::DAst tree) {
-  symbols= d::Table::make("root", BITS);
+  symbols= d::Table::make("root", bits());
   tree->visit(this);
 }
 
@@ -130,6 +178,11 @@ d::DSymbol Basic::define(d::DSymbol s) {
   return s;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::LexAddr Basic::resolve(cstdstr& n) const {
+  return symbols ? symbols->resolve(n) : d::LexAddr();
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DTable Basic::pushScope(cstdstr& name) {
   return (symbols= d::Table::make(name, symbols));
@@ -146,7 +199,7 @@ d::DTable Basic::popScope() {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Basic::readString() {
   // get the whole line
-  stdstr s; std::getline(std::cin,s); return s;
+  stdstr s; std::getline(d::Isolate::current()->in(),s); return s;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -162,21 +215,21 @@ llong Basic::readInt() {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::writeString(cstdstr& s) { std::cout << s; }
+void Basic::writeString(cstdstr& s) { d::Isolate::current()->out() << s; }
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::writeFloat(double d) { std::cout << d; }
+void Basic::writeFloat(double d) { d::Isolate::current()->out() << d; }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::writeInt(llong n) { std::cout << n; }
+void Basic::writeInt(llong n) { d::Isolate::current()->out() << n; }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::writeln() { std::cout << "\n"; }
+void Basic::writeln() { d::Isolate::current()->out() << "\n"; }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Basic::install(const std::map<int,int>& m) {
   // install the entire program, maps code lines
-  // to linear array positions.
+  // to where their statements start in the program.
   for (auto& x : m)
     lines[_1(x)] = _2(x);
 }
@@ -206,8 +259,7 @@ void Basic::init_lambdas() {
 void Basic::init_counters() {
   running=true;
   dataPtr=0;
-  progOffset=0;
-  progCounter= -1;
+  progCounter=0;
   init_lambdas();
   CLEAR_STACK(gosubReturns);
 }
@@ -216,70 +268,53 @@ void Basic::init_counters() {
 void Basic::finz_counters() {
   running=false;
   dataPtr=0;
-  progOffset=0;
-  progCounter= -1;
+  progCounter=0;
   CLEAR_STACK(gosubReturns);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-int Basic::retSub() {
+int Basic::at(int line) const {
+  auto it= lines.find(line);
+  return it == lines.end() ? -1 : _2_(it);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Basic::retSub() {
   if (gosubReturns.empty())
     RAISE(d::BadArg, "Bad gosub-return: %s", "no sub called");
-  auto r= gosubReturns.top();
+  // back to the statement after the gosub
+  progCounter= gosubReturns.top();
   gosubReturns.pop();
-  // return to the *next* offset
-  progOffset = _2(r) + 1;
-  // return to the line before since pc always increment.
-  return (progCounter = _1(r) - 1);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-int Basic::jumpSub(int target, int from, int off) {
-  auto it= lines.find(target);
-  if (it == lines.end())
-    RAISE(d::BadArg, "Bad gosub<%d>", target);
-
-  // must!
-  ASSERT1(progCounter == lines[from]);
-
-  gosubReturns.push(s__pair(int,int,progCounter,off));
-  auto pc = _2_(it);
-  progOffset=0;
-  // go one less since pc always increments.
-  return (progCounter = pc-1);
+void Basic::jumpSubTo(int pos) {
+  // the counter is already past the gosub
+  gosubReturns.push(progCounter);
+  progCounter=pos;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-int Basic::jump(int line) {
-  auto it= lines.find(line);
-  if (it == lines.end())
-    RAISE(d::BadArg, "Bad goto<%d>", line);
-  auto pos = _2_(it);
-  progOffset=0;
-  // go one less since pc always increments.
-  return (progCounter = pos-1);
+void Basic::jumpSub(int target) {
+  auto pos= at(target);
+  if (pos < 0)
+    RAISE(d::BadArg, "Bad gosub<%d>", target);
+  jumpSubTo(pos);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-int Basic::jumpFor(DslFLInfo f) {
-  auto it= lines.find(f->begin);
-  if (it == lines.end())
-    RAISE(d::BadArg, "Bad for-loop<%d>",  f->begin);
-  progOffset=f->beginOffset;
-  // always one less since pc always increments.
-  return (progCounter = _2_(it) - 1);
+void Basic::jump(int line) {
+  auto pos= at(line);
+  if (pos < 0)
+    RAISE(d::BadArg, "Bad goto<%d>", line);
+  progCounter=pos;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-int Basic::endFor(DslFLInfo f) {
-  auto it= lines.find(f->end);
-  if (it == lines.end())
-    RAISE(d::BadArg, "Bad end-for<%d>", f->end);
-  f->init=P_NIL;
-  // when done goto next offset.
-  progOffset=f->endOffset+1;
-  // one less since pc always increments.
-  return (progCounter = _2_(it) - 1);
+void Basic::endFor(DslFLInfo f) {
+  f->on=false;
+  // when done, on to the statement after the next.
+  progCounter= f->endAt+1;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -298,12 +333,12 @@ void Basic::addForLoop(DslFLInfo f) {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::xrefForNext(int n, int pos) {
-  xrefForNext("", n, pos);
+DslFLInfo Basic::xrefForNext(int n, int pos) {
+  return xrefForNext("", n, pos);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::xrefForNext(cstdstr& v, int n, int pos) {
+DslFLInfo Basic::xrefForNext(cstdstr& v, int n, int pos) {
   // make sure the next statement matches the current for loop.
   auto c = this->forLoop;
   // must!
@@ -317,35 +352,13 @@ void Basic::xrefForNext(cstdstr& v, int n, int pos) {
   c->endOffset=pos;
   c->end= n;
 
-  // find the corresponding counters
-  auto b= this->lines[c->begin];
-  auto e= this->lines[c->end];
-
-  // we need to handle multi next on same line
-  auto bkey= N_STR(b)+","+N_STR(c->beginOffset);
-  auto ekey= N_STR(e)+","+N_STR(pos);
-
-  //std::cout << "bkey= " << bkey << "\n";
-  //std::cout << "ekey= " << ekey << "\n";
-
-  this->forBegins[bkey] = c;
-  this->forEnds[ekey] = c;
+  // find the corresponding statements
+  c->beginAt= this->lines[c->begin] + c->beginOffset;
+  c->endAt= this->lines[c->end] + pos;
 
   // pop it
   forLoop=forLoop->outer;
-}
-
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-DslFLInfo Basic::getForLoop(int c, int offset) const {
-  auto k= N_STR(c)+","+N_STR(offset);
-
-  if (auto i = forBegins.find(k);
-      i != forBegins.end()) { return _2_(i); }
-
-  if (auto i = forEnds.find(k);
-      i != forEnds.end()) { return _2_(i); }
-
-  E_SEMANTIC("Unknown for-loop<%d>, offset[%d]", c, offset);
+  return c;
 }
 
 
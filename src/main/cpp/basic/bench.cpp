@@ -0,0 +1,125 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <chrono>
+#include "types.h"
+#include "lexer.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// bumped by the operator new below when built as a program
+size_t _allocs=0;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// one op is one pass of the loop body, more lines in tail, numbered
+// to go before or after the loop
+void bench(cstdstr& name, cstdstr& body, int n, cstdstr& tail="") {
+  stdstr src= "10 S=0\n"
+              "20 FOR I=1 TO " + N_STR(n) + "\n"
+              "30 " + body + "\n"
+              "40 NEXT I\n" + tail;
+  Basic p(src.c_str());
+  auto a0= _allocs;
+  auto t= std::chrono::steady_clock::now();
+  p.interpret();
+  std::chrono::duration<double,std::nano> d= std::chrono::steady_clock::now() - t;
+  std::cout << name
+            << " ns/op=" << d.count() / n
+            << " allocs/op=" << (double)(_allocs - a0) / n << "\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void bench(int n) {
+  bench("int-arith", "S=S+I*2-I", n);
+  bench("real-arith", "S=S+I*0.5-I/3.0", n);
+  bench("compare", "IF I>S THEN S=I", n);
+  bench("goto", "GOTO 36\n35 S=0\n36 S=S+1", n);
+  bench("gosub", "GOSUB 900", n, "50 END\n900 S=S+1: RETURN\n");
+  bench("array", "A(I)=A(I-1)+I", n, "5 DIM A(" + N_STR(n) + ")\n");
+  bench("array-2d", "B(I MOD 10,J)=B(J,I MOD 10)+1: J=9-J", n,
+        "5 DIM B(9,9)\n6 J=0\n");
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// lexer throughput, mostly keywords and names
+void lexBench(int n) {
+  stdstr src;
+  for (auto i=0; i < 1000; ++i) {
+    src += N_STR(10*(i+1)) +
+           " FOR I=1 TO 10 STEP 2: IF X>=I THEN GOSUB 900 ELSE PRINT A$;B%: NEXT I\n";
+  }
+  size_t count=0;
+  auto t= std::chrono::steady_clock::now();
+  for (auto k=0; k < n; ++k) {
+    Lexer x(src.c_str());
+    while (x.ctx().cur->type() != d::T_EOF) {
+      x.ctx().cur= x.getNextToken();
+      ++count;
+    }
+  }
+  std::chrono::duration<double> d= std::chrono::steady_clock::now() - t;
+  std::cout << "lexer tokens/sec=" << count / d.count() << "\n";
+}
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// an n x n product, by MAT and by three FOR loops
+void matBench(int n) {
+  auto N= N_STR(n);
+  stdstr head= "10 DIM A(" + N + "," + N + ")\n"
+               "11 DIM B(" + N + "," + N + ")\n"
+               "12 DIM C(" + N + "," + N + ")\n"
+               "13 MAT A = CON: MAT B = CON\n";
+  stdstr mat= head + "20 MAT C = A * B\n";
+  stdstr loops= head +
+                "20 FOR I=1 TO " + N + ": FOR J=1 TO " + N + ": S=0\n"
+                "21 FOR K=1 TO " + N + ": S=S+A(I,K)*B(K,J): NEXT K\n"
+                "22 C(I,J)=S: NEXT J: NEXT I\n";
+  for (auto& x : { std::make_pair("mat-mul", mat),
+                   std::make_pair("for-mul", loops) }) {
+    Basic p(x.second.c_str());
+    auto t= std::chrono::steady_clock::now();
+    p.interpret();
+    std::chrono::duration<double,std::nano> d= std::chrono::steady_clock::now() - t;
+    std::cout << x.first << " " << N << "x" << N
+              << " ns/madd=" << d.count() / ((double) n*n*n) << "\n";
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+#if 0
+void* operator new(size_t n) {
+  ++czlab::basic::_allocs;
+  if (auto p= ::malloc(n); p) { return p; }
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { ::free(p); }
+void operator delete(void* p, size_t) noexcept { ::free(p); }
+
+int main(int ac, char** av) {
+  czlab::basic::bench(1000000);
+  czlab::basic::lexBench(20);
+  czlab::basic::matBench(200);
+  return 0;
+}
+#endif
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
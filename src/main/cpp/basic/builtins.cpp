@@ -15,6 +15,7 @@
 #include <iostream>
 #include <cmath>
 #include <random>
+#include "../dsl/isolate.h"
 #include "builtins.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -193,10 +194,8 @@ static d::DValue native_fix(d::IEvaluator*, d::VSlice args) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 static d::DValue native_rand(d::IEvaluator*, d::VSlice args) {
   //d::preEqual(0, args.size(), "rnd");
-  std::random_device rd;
-  std::mt19937 gen(rd());
   std::uniform_real_distribution<> dis(0, 1);
-  return NUMBER_VAL(dis(gen));
+  return NUMBER_VAL(dis(d::Isolate::current()->rng()));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
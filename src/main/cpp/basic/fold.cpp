@@ -0,0 +1,146 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+
+#include "../dsl/fold.h"
+#include "parser.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic {
+namespace a = czlab::aeon;
+namespace d = czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Folding rules, see dsl/fold.h.  Statements look at their kids
+// as Ast nodes, so a constant here becomes a Num, not a Literal,
+// and lines and branches are left alone, GOTO can land anywhere.
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a Num for n if all its kids are, by n's own evalValue(),
+// left as is if that throws
+d::DAst constant(d::Folder* f, Ast* n, const d::AstVec& kids) {
+  if (!f->rewriting()) { return d::DAst(); }
+  for (auto& x : kids) {
+    if (!x || typeid(*x) != typeid(Num)) { return d::DAst(); }
+  }
+  d::Value v;
+  try {
+    // the kids are Nums, nothing reads the evaluator
+    v= n->evalValue(P_NIL);
+  } catch (...) {
+    return d::DAst();
+  }
+  return v.isNumber() ? Num::make(n->tok(), v) : d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BinOp::fold(d::Folder* f) {
+  f->fold(lhs);
+  f->fold(rhs);
+  return constant(f, this, {lhs, rhs});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst UnaryOp::fold(d::Folder* f) {
+  f->fold(expr);
+  return constant(f, this, {expr});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst NotFactor::fold(d::Folder* f) {
+  f->fold(expr);
+  return constant(f, this, {expr});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst RelationOp::fold(d::Folder* f) {
+  f->fold(lhs);
+  f->fold(rhs);
+  return constant(f, this, {lhs, rhs});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BoolTerm::fold(d::Folder* f) {
+  f->fold(terms);
+  return constant(f, this, terms);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BoolExpr::fold(d::Folder* f) {
+  f->fold(terms);
+  return constant(f, this, terms);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the function may be RND, only the args fold
+d::DAst FuncCall::fold(d::Folder* f) {
+  f->fold(args);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Assignment::fold(d::Folder* f) {
+  f->fold(rhs);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Print::fold(d::Folder* f) {
+  f->fold(exprs);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst IfThen::fold(d::Folder* f) {
+  f->fold(cond);
+  f->fold(then);
+  f->fold(elze);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst ForLoop::fold(d::Folder* f) {
+  f->fold(init);
+  f->fold(term);
+  f->fold(step);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the lambda shares the body, it is changed in place
+d::DAst Defun::fold(d::Folder* f) {
+  f->fold(body);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Compound::fold(d::Folder* f) {
+  f->fold(stmts);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the statements the lines hold, each once
+d::DAst Program::fold(d::Folder* f) {
+  f->fold(code);
+  return d::DAst();
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
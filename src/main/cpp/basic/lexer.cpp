@@ -20,7 +20,7 @@ namespace a = czlab::aeon;
 namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-std::map<int, stdstr> TOKENS {
+constexpr d::Keyword TOKENS[] {
   {T_ARRAYINDEX, "[]"},
   {T_FUNCALL, "()"},
   {T_REM, "REM"},
@@ -52,15 +52,16 @@ std::map<int, stdstr> TOKENS {
   {T_OR, "OR"},
   {T_XOR, "XOR"},
   {T_DIM, "DIM"},
-  {T_RESTORE, "RESTORE"}
+  {T_RESTORE, "RESTORE"},
+  {T_MAT, "MAT"}
 };
 
-auto KEYWORDS= a::map_reflect(TOKENS);
+constexpr d::KeywordTable KEYWORDS(TOKENS);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr typeToString(int t) {
-  return s__contains(TOKENS, t)
-         ? map__val(TOKENS, t) : ("token#" + N_STR(t));
+  auto s= KEYWORDS.name(t);
+  return s.size() ? stdstr(s) : ("token#" + N_STR(t));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -70,9 +71,15 @@ Lexer::Lexer(const Tchar* src) {
   _ctx.cur= getNextToken();
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Lexer::Lexer(d::Source* in) {
+  _ctx.open(in);
+  _ctx.cur= getNextToken();
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Lexer::isKeyword(cstdstr& k) const {
-  return s__contains(KEYWORDS, k);
+  return KEYWORDS.contains(k);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -137,17 +144,17 @@ void checkid(cstdstr& src, d::Addr m) {
 d::DToken Lexer::id() {
   auto res = d::identifier(_ctx, &filter);
   auto S= a::to_upper(_1(res));
-  auto b= isKeyword(S);
+  auto t= KEYWORDS.find(S);
 
-  if (!b)
+  if (t < 0)
     checkid(S, _2(res));
 
-  return d::Token::make(b ? KEYWORDS.at(S) : d::T_IDENT, S, _2(res));
+  return d::Token::make(t < 0 ? d::T_IDENT : t, S, _2(res));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Lexer::getNextToken() {
-  auto& tks= d::getStrTokens();
+  _ctx.trim();
   while (!_ctx.eof) {
     auto ch= d::peek(_ctx);
     // ORDER IS IMPORTANT !!!!
@@ -180,7 +187,7 @@ d::DToken Lexer::getNextToken() {
         ch == '-' ||
         ch == '(' ||
         ch == ')') {
-      return d::Token::make(tks.at(stdstr(1,ch)),
+      return d::Token::make(d::tokenType(std::string_view(&ch,1)),
                            ch,d::mark_advance(_ctx)); }
 
     if (filter(ch,true)) return id();
@@ -208,7 +215,7 @@ d::DToken Lexer::getNextToken() {
         ch == ',' ||
         ch == '\'' ||
         ch == '.') {
-      return d::Token::make(tks.at(stdstr(1,ch)),
+      return d::Token::make(d::tokenType(std::string_view(&ch,1)),
                            ch, d::mark_advance(_ctx)); }
 
     //else
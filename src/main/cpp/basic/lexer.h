@@ -59,6 +59,7 @@ enum TokenType {
   T_XOR,
   T_DIM,
   T_RESTORE,
+  T_MAT,
   T_PROGRAM,
 
   T_EOL
@@ -80,6 +81,8 @@ struct Lexer : public d::IScanner {
   virtual d::DToken string();
 
   Lexer(const Tchar* src);
+  // a window at a time, owns the source
+  Lexer(d::Source*);
   virtual ~Lexer() {}
 
   private:
@@ -0,0 +1,365 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <cmath>
+#include <thread>
+#include <type_traits>
+#include "mat.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic {
+namespace a= czlab::aeon;
+namespace d= czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+llong matThreaded= 1 << 21;
+
+// so a tile of A and the columns of the result it feeds stay in cache
+constexpr int ROWS_TILE=256;
+constexpr int INNER_TILE=128;
+constexpr int TRN_TILE=32;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+MatShape::MatShape(const BArray* a) {
+  dims= a->dims();
+  if (dims < 1 || dims > 2)
+    E_SEMANTIC("MAT wants 1 or 2 DIMs, got %d", dims);
+  ld= a->range(0);
+  rows= ld-1;
+  cols= dims == 2 ? a->range(1)-1 : 1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+IntVec MatShape::bounds() const {
+  return dims == 1 ? IntVec{rows} : IntVec{rows, cols};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a result, rows x cols, column major
+template<typename T>
+struct Dense {
+  Dense(int r, int c) : rows(r), cols(c), v((size_t) r*c) {}
+  T& operator()(int i, int j) { return v[i + (size_t) j*rows]; }
+  const T* col(int j) const { return &v[(size_t) j*rows]; }
+  int rows, cols;
+  std::vector<T> v;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// an operand, from A(1,1) on, its columns ld apart
+template<typename T>
+struct Cols {
+  Cols(const T* p, const MatShape& s) : at(p + s.at(1,1)), ld(s.ld) {}
+  const T* col(int j) const { return at + (size_t) j*ld; }
+  const T* at;
+  llong ld;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+BArray* nums(BArray* a) {
+  if (!a->isInts() && !a->isReals())
+    E_SEMANTIC("MAT wants numbers, got %s", C_STR(a->pr_str()));
+  return a;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the numbers as T, the array's own unless they have to be copied
+template<typename T>
+const T* data(BArray* a, std::vector<T>& copy) {
+  if constexpr (std::is_same<T,llong>::value) {
+    return a->intData();
+  } else {
+    if (a->isReals()) { return a->realData(); }
+    copy.assign(a->intData(), a->intData() + a->size());
+    return copy.data();
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T, typename S>
+void put(T* p, const MatShape& s, const Dense<S>& r) {
+  for (int j=0; j < r.cols; ++j) {
+    auto z= p + s.at(1, j+1);
+    auto x= r.col(j);
+    for (int i=0; i < r.rows; ++i) { z[i]= (T) x[i]; }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// into out, DIM'ed to s first unless it already is
+template<typename T>
+void commit(BArray* out, const MatShape& s, const Dense<T>& r) {
+  nums(out);
+  if (!(out->dims() == s.dims &&
+        out->range(0) == s.rows+1 &&
+        (s.dims == 1 || out->range(1) == s.cols+1)))
+    out->reshape(s.bounds());
+  MatShape t(out);
+  // reals stay reals unless the name says ints
+  auto reals= std::is_same<T,double>::value
+              ? out->toReals() : out->isReals();
+  if (reals) put(out->realData(), t, r);
+  else put(out->intData(), t, r);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void addCols(Dense<T>& r, Cols<T> a, Cols<T> b, T sign) {
+  for (int j=0; j < r.cols; ++j) {
+    auto x= a.col(j);
+    auto y= b.col(j);
+    auto z= &r(0,j);
+    for (int i=0; i < r.rows; ++i) { z[i]= x[i] + sign * y[i]; }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void scaleCols(Dense<T>& r, Cols<T> a, T k) {
+  for (int j=0; j < r.cols; ++j) {
+    auto x= a.col(j);
+    auto z= &r(0,j);
+    for (int i=0; i < r.rows; ++i) { z[i]= k * x[i]; }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a tile at a time, so neither side is walked across in full
+template<typename T>
+void trnCols(Dense<T>& r, Cols<T> a) {
+  auto rows= r.cols;
+  auto cols= r.rows;
+  for (int jj=0; jj < cols; jj += TRN_TILE)
+  for (int ii=0; ii < rows; ii += TRN_TILE) {
+    auto je= std::min(cols, jj+TRN_TILE);
+    auto ie= std::min(rows, ii+TRN_TILE);
+    for (int j=jj; j < je; ++j) {
+      auto x= a.col(j);
+      for (int i=ii; i < ie; ++i) { r(j,i)= x[i]; }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// columns j0 to j1 of the product, k the inner dim.  The innermost
+// loop runs down a column of A and of the result, contiguous in
+// both, which the compiler vectorizes.
+template<typename T>
+void mulCols(Dense<T>& r, Cols<T> a, Cols<T> b, int k, int j0, int j1) {
+  auto n= r.rows;
+  for (int ii=0; ii < n; ii += ROWS_TILE) {
+    auto ie= std::min(n, ii+ROWS_TILE);
+    for (int pp=0; pp < k; pp += INNER_TILE) {
+      auto pe= std::min(k, pp+INNER_TILE);
+      for (int j=j0; j < j1; ++j) {
+        auto y= b.col(j);
+        auto z= &r(0,j);
+        for (int p=pp; p < pe; ++p) {
+          auto t= y[p];
+          if (t == 0) { continue; }
+          auto x= a.col(p);
+          for (int i=ii; i < ie; ++i) { z[i] += x[i] * t; }
+        }
+      }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// big enough, the columns are split over the cores, each thread
+// writing only its own
+template<typename T>
+void mulCols(Dense<T>& r, Cols<T> a, Cols<T> b, int k) {
+  int m= r.cols;
+  int cores= std::thread::hardware_concurrency();
+  auto work= (llong) r.rows * k * m;
+  if (matThreaded <= 0 ||
+      work < matThreaded || cores < 2 || m < 2) {
+    return mulCols(r, a, b, k, 0, m);
+  }
+  auto parts= std::min(cores, m);
+  std::vector<std::thread> ts;
+  for (auto t=1; t < parts; ++t) {
+    int j0= (llong) m * t / parts;
+    int j1= (llong) m * (t+1) / parts;
+    s__conj(ts, std::thread([&r,a,b,k,j0,j1]() {
+      mulCols(r, a, b, k, j0, j1);
+    }));
+  }
+  mulCols(r, a, b, k, 0, m / parts);
+  for (auto& t : ts) { t.join(); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Gauss-Jordan with partial pivoting, r starts as the identity and
+// gets the same row ops that take x to it
+void invCols(Dense<double>& r, Cols<double> a) {
+  auto n= r.rows;
+  Dense<double> x(n, n);
+  std::vector<double> f(n);
+  for (int j=0; j < n; ++j) {
+    auto y= a.col(j);
+    for (int i=0; i < n; ++i) { x(i,j)= y[i]; }
+    r(j,j)= 1;
+  }
+  for (int c=0; c < n; ++c) {
+    auto p=c;
+    for (int i=c+1; i < n; ++i)
+      if (std::fabs(x(i,c)) > std::fabs(x(p,c))) { p=i; }
+    if (a::fuzzy_zero(x(p,c)))
+      RAISE(d::DivByZero, "MAT INV: %s", "singular matrix");
+    if (p != c) {
+      for (int j=0; j < n; ++j) {
+        std::swap(x(p,j), x(c,j));
+        std::swap(r(p,j), r(c,j)); }
+    }
+    auto piv= x(c,c);
+    for (int j=0; j < n; ++j) {
+      x(c,j) /= piv;
+      r(c,j) /= piv;
+    }
+    // what each other row takes away of row c
+    for (int i=0; i < n; ++i) { f[i]= i == c ? 0 : x(i,c); }
+    for (int j=0; j < n; ++j) {
+      auto s= x(c,j);
+      auto t= r(c,j);
+      auto xj= &x(0,j);
+      auto rj= &r(0,j);
+      for (int i=0; i < n; ++i) {
+        xj[i] -= f[i] * s;
+        rj[i] -= f[i] * t;
+      }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void add(BArray* out, BArray* a, BArray* b, bool sub) {
+  MatShape s(a);
+  std::vector<T> ca, cb;
+  Dense<T> r(s.rows, s.cols);
+  addCols(r, Cols<T>(data(a,ca), s),
+             Cols<T>(data(b,cb), MatShape(b)), (T) (sub ? -1 : 1));
+  commit(out, s, r);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void scale(BArray* out, T k, BArray* a) {
+  MatShape s(a);
+  std::vector<T> ca;
+  Dense<T> r(s.rows, s.cols);
+  scaleCols(r, Cols<T>(data(a,ca), s), k);
+  commit(out, s, r);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void mul(BArray* out, BArray* a, BArray* b) {
+  MatShape sa(a), sb(b);
+  std::vector<T> ca, cb;
+  Dense<T> r(sa.rows, sb.cols);
+  mulCols(r, Cols<T>(data(a,ca), sa), Cols<T>(data(b,cb), sb), sa.cols);
+  commit(out, MatShape(sa.rows, sb.cols, sb.dims), r);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void trn(BArray* out, BArray* a) {
+  MatShape s(a);
+  std::vector<T> ca;
+  Dense<T> r(s.cols, s.rows);
+  trnCols(r, Cols<T>(data(a,ca), s));
+  commit(out, MatShape(s.cols, s.rows, 2), r);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool ints(BArray* a, BArray* b=P_NIL) {
+  return nums(a)->isInts() && (!b || nums(b)->isInts());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matFill(BArray* out, int op, const IntVec& bounds) {
+  nums(out);
+  for (auto n : bounds)
+    if (n < 0) E_SEMANTIC("MAT wants bounds >= 0, got %d", n);
+  if (bounds.size() > 2)
+    E_SEMANTIC("MAT wants 1 or 2 DIMs, got %d", (int) bounds.size());
+  if (!bounds.empty())
+    out->reshape(bounds);
+  MatShape s(out);
+  if (op == MAT_IDN &&
+      (s.dims != 2 || s.rows != s.cols))
+    E_SEMANTIC("MAT IDN wants a square matrix, got %s", C_STR(out->pr_str()));
+  Dense<llong> r(s.rows, s.cols);
+  for (int j=0; j < s.cols; ++j)
+  for (int i=0; i < s.rows; ++i)
+    r(i,j)= op == MAT_CON ? 1 : op == MAT_IDN ? (i == j) : 0;
+  commit(out, s, r);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matCopy(BArray* out, BArray* a) {
+  // times one, the kernel is the same
+  ints(a) ? scale<llong>(out, 1, a) : scale<double>(out, 1.0, a);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matAdd(BArray* out, BArray* a, BArray* b, bool sub) {
+  auto i= ints(a,b);
+  if (!(MatShape(a) == MatShape(b)))
+    E_SEMANTIC("MAT shapes differ, %s and %s",
+               C_STR(a->pr_str()), C_STR(b->pr_str()));
+  i ? add<llong>(out, a, b, sub) : add<double>(out, a, b, sub);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matScale(BArray* out, const d::Value& k, BArray* a) {
+  ints(a) && k.isInt()
+  ? scale<llong>(out, k.getInt(), a) : scale<double>(out, k.getFloat(), a);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matMul(BArray* out, BArray* a, BArray* b) {
+  auto i= ints(a,b);
+  if (MatShape(a).cols != MatShape(b).rows)
+    E_SEMANTIC("MAT * wants the columns of %s to match the rows of %s",
+               C_STR(a->pr_str()), C_STR(b->pr_str()));
+  i ? mul<llong>(out, a, b) : mul<double>(out, a, b);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matTrn(BArray* out, BArray* a) {
+  ints(a) ? trn<llong>(out, a) : trn<double>(out, a);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matInv(BArray* out, BArray* a) {
+  MatShape s(nums(a));
+  if (s.dims != 2 || s.rows != s.cols)
+    E_SEMANTIC("MAT INV wants a square matrix, got %s", C_STR(a->pr_str()));
+  std::vector<double> ca;
+  Dense<double> r(s.rows, s.cols);
+  invCols(r, Cols<double>(data(a,ca), s));
+  commit(out, s, r);
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,73 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include "types.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic {
+namespace d= czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// An array as MAT sees it, rows x cols, a one dim array being a
+// column.  Subscripts run from 1 as in classic BASIC, row and
+// column 0 are left alone.  Throws for more than two dims.
+struct MatShape {
+
+  MatShape(const BArray*);
+  MatShape(int r, int c, int n) : rows(r), cols(c), dims(n) {}
+
+  // where A(i,j) is in the array's storage
+  llong at(int i, int j) const { return i + (dims == 2 ? j*ld : 0); }
+  IntVec bounds() const;
+  bool operator==(const MatShape& s) const {
+    return rows == s.rows && cols == s.cols && dims == s.dims;
+  }
+
+  int rows, cols, dims;
+  llong ld=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// The MAT statements, out= the rest.  out is DIM'ed again if the
+// result is of another shape, the operands are left as they were,
+// out may be one of them.  Done in ints if every operand holds
+// ints, else in reals, see BArray for how out takes them.
+enum {
+  MAT_COPY=1, MAT_ADD, MAT_SUB, MAT_MUL,
+  MAT_SCALE, MAT_TRN, MAT_INV, MAT_ZER, MAT_CON, MAT_IDN
+};
+
+// ZER, CON or IDN, DIM'ed to bounds first if any
+void matFill(BArray* out, int op, const IntVec& bounds);
+void matCopy(BArray* out, BArray* a);
+void matAdd(BArray* out, BArray* a, BArray* b, bool sub);
+void matScale(BArray* out, const d::Value& k, BArray* a);
+void matMul(BArray* out, BArray* a, BArray* b);
+void matTrn(BArray* out, BArray* a);
+void matInv(BArray* out, BArray* a);
+
+// products of this many multiply-adds or more are split by
+// columns over the cores, 0 for never
+extern llong matThreaded;
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
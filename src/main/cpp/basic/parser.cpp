@@ -12,7 +12,9 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include "../dsl/profiler.h"
 #include "parser.h"
+#include "mat.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::basic {
@@ -33,26 +35,27 @@ d::DAst mkvar(BasicParser* bp) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Program::Program(d::DToken k, const std::map<int,d::DAst>& lines) : Ast(k) {
   // lines are sorted, so we get the ordering
-  // now store them into a array for fast access.
-  auto pos=0;
+  // now store their statements into one array for fast access.
   for (auto i=lines.begin(), e=lines.end(); i!=e; ++i) {
-    mlines[_1_(i)] = pos;
-    ++pos;
+    mlines[_1_(i)] = code.size();
+    s__ccat(code, DCAST(Compound,_2_(i))->statements());
     s__conj(vlines, _2_(i)); }
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Program::eval(d::IEvaluator* e) {
   auto _e = s__cast(Basic,e);
-  auto len= vlines.size();
-  auto last= DVAL_NIL;
+  int len= code.size();
 
-  //std::cout << "len = " << len << "\n" << pr_str() << "\n";
-  while (_e->isOn() &&
-         _e->incr_pc() < len)
-    last = vlines[_e->pc()]->eval(e);
+  // a statement at a time, a jump just moves the counter
+  for (int pos; _e->isOn() && (pos= _e->next()) < len;)
+  { auto ps= DCAST(Ast,code[pos]);
+    d::Probe _p(e, ps, [&]() {
+      return d::Profiler::Site{ps->line(), d::Profiler::nameOf(ps)};
+    });
+    ps->eval(e); }
 
-  return last;
+  return DVAL_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -90,17 +93,8 @@ Compound::Compound(d::DToken k, int ln, const d::AstVec& vs) : Ast(k) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Compound::eval(d::IEvaluator* e) {
-  auto _e = s__cast(Basic,e);
-  auto len= stmts.size();
-  auto pos= _e->poffset();
-
-  //std::cout << "line = " << line() << "\n";
-  for (; pos < len; ++pos)
-  { auto ps= DCAST(Ast,stmts[pos]);
-    auto res= ps->eval(e);
-    auto n= vcast<d::Number>(res);
-    if (n && n->isZero()) {break;} }
-
+  // the line on its own, a program runs the statements itself
+  for (auto& s : stmts) s->eval(e);
   return DVAL_NIL;
 }
 
@@ -127,40 +121,48 @@ d::DValue OnXXX::eval(d::IEvaluator* e) {
   auto n= vcast<d::Number>(v,_A);
   auto x= n->getInt();
   auto tz= targets.size();
-  auto res= DVAL_NIL;
 
   //if x is 1, it jumps to the first line in the list;
   //if x is 2, it jumps to the second line, and so on.
   if (x > 0 && x <= tz) {
     // get the selected target
     auto t= tok()->type();
+    auto pos= dests[x-1];
     x= targets[x-1];
     if (t == T_GOTO)
-      _e->jump(x);
+      pos < 0 ? _e->jump(x) : _e->jumpTo(pos);
     else
     if (t== T_GOSUB)
-      _e->jumpSub(x, line(), offset());
-    res=NUMBER_VAL(0);
+      pos < 0 ? _e->jumpSub(x) : _e->jumpSubTo(pos);
   }
 
-  return res;
+  return DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void OnXXX::visit(d::IAnalyzer* a) {
+  auto _a= s__cast(Basic,a);
+  var->visit(a);
+  dests.clear();
+  for (auto t : targets)
+    s__conj(dests, _a->at(t));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue ForNext::eval(d::IEvaluator* e) {
-  auto _e = s__cast(Basic,e);
-  _e->jumpFor(_e->getForLoop(_e->pc(),offset()));
-  return NUMBER_VAL(0);
+  return s__cast(Basic,e)->jumpTo(info->beginAt), DVAL_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void ForNext::visit(d::IAnalyzer* a) {
   auto _e = s__cast(Basic,a);
+  DslFLInfo f;
   if (!var)
-    _e->xrefForNext(line(), offset());
+    f= _e->xrefForNext(line(), offset());
   else
   { var->visit(a);
-    _e->xrefForNext(PNAME(Var,var), line(), offset()); }
+    f= _e->xrefForNext(PNAME(Var,var), line(), offset()); }
+  info=f;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -175,55 +177,59 @@ stdstr ForNext::pr_str() const {
 d::DValue ForLoop::eval(d::IEvaluator* e) {
   auto _e = s__cast(Basic,e);
   auto _A= tok()->addr();
-  auto P = _e->pc();
   bool quit=1;
-  auto f= _e->getForLoop(P,offset());
 
   //calc step and term
-  auto _t= term->eval(e);
-  auto _s= step->eval(e);
-  auto s= vcast<d::Number>(_s,_A);
-  auto t= vcast<d::Number>(_t,_A);
-  auto i=t;
+  auto t= term->evalValue(e);
+  auto s= step->evalValue(e);
+  vnum(s,_A);
+  vnum(t,_A);
   auto z= 0.0;
 
+  auto pv= DCAST(Var,var);
   // first invoke
-  if (!f->init) {
-    f->init = init->eval(e);
-    i= vcast<d::Number>(f->init,_A);
-    z= i->getFloat();
-    e->setValue(f->var, f->init);
+  if (!info->on) {
+    auto v= init->evalValue(e);
+    z= vnum(v,_A).getFloat();
+    pv->store(e, v);
+    info->on=true;
   } else {
-    auto _v= e->getValue(f->var);
-    auto v= vcast<d::Number>(_v,_A);
-    // do var +/- step
-    z = v->getFloat() + s->getFloat();
-    // update the var
-    e->setValue(f->var,
-                v->isInt()
-                ? NUMBER_VAL((llong) z) : NUMBER_VAL(z)); }
+    auto v= pv->evalValue(e);
+    vnum(v,_A);
+    // do var +/- step, as ints if both are, nothing boxed
+    if (v.isInt() && s.isInt()) {
+      auto n= v.getInt() + s.getInt();
+      z= n;
+      pv->store(e, d::Value::of(n));
+    } else {
+      z = v.getFloat() + s.getFloat();
+      pv->store(e,
+                v.isInt()
+                ? d::Value::of((llong) z) : d::Value::of(z)); } }
 
   // test for loop termination
-  if (s->isPos())
-    quit = z > t->getFloat();
-  if (s->isNeg())
-    quit = z < t->getFloat();
+  if (s.isPos())
+    quit = z > t.getFloat();
+  if (s.isNeg())
+    quit = z < t.getFloat();
 
   if (quit)
-    _e->endFor(f);
+    _e->endFor(info);
 
-  return quit ? NUMBER_VAL(0) : DVAL_NIL;
+  return DVAL_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void ForLoop::visit(d::IAnalyzer* a) {
   auto vn= DCAST(Var,var)->name();
   auto _a= s__cast(Basic,a);
+  a->define(d::Symbol::make(vn));
   var->visit(a);
   init->visit(a);
   term->visit(a);
   step->visit(a);
-  _a->addForLoop(ForLoopInfo::make(vn, line(), offset()));
+  info= ForLoopInfo::make(vn, line(), offset());
+  _a->addForLoop(info);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -240,9 +246,8 @@ stdstr ForLoop::pr_str() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue IfThen::eval(d::IEvaluator* e) {
-  auto c= cond->eval(e);
-  auto n= vcast<d::Number>(c,tok()->addr());
-  return !n->isZero()
+  auto c= cond->evalValue(e);
+  return !vnum(c,tok()->addr()).isZero()
          ? then->eval(e) : (elze ? elze->eval(e) : DVAL_NIL);
 }
 
@@ -292,19 +297,35 @@ stdstr Data::pr_str() const {
   return b.empty() ? buf : (buf + " " + b);
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a literal line is looked up once, when analyzed, a computed
+// one as it runs, so a bad line is still caught there
+int jumpTarget(d::IAnalyzer* a, const d::DAst& x) {
+  return typeid(*x) == typeid(Num)
+         ? s__cast(Basic,a)->at(DCAST(Num,x)->value().getInt()) : -1;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue GoSubReturn::eval(d::IEvaluator* e) {
-  return s__cast(Basic,e)->retSub(), NUMBER_VAL(0);
+  return s__cast(Basic,e)->retSub(), DVAL_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue GoSub::eval(d::IEvaluator* e) {
   //std::cout << "Jumping to subroutine: " << "\n";
   auto _e= s__cast(Basic,e);
+  if (dest >= 0)
+    return _e->jumpSubTo(dest), DVAL_NIL;
   auto res= expr->eval(e);
   auto des= vcast<d::Number>(res,tok()->addr());
   //std::cout << "Jumping to subroutine: " << des << "\n";
-  return _e->jumpSub(des->getInt(), line(), offset()), NUMBER_VAL(0);
+  return _e->jumpSub(des->getInt()), DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void GoSub::visit(d::IAnalyzer* a) {
+  expr->visit(a);
+  dest= jumpTarget(a, expr);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -315,10 +336,18 @@ stdstr GoSub::pr_str() const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Goto::eval(d::IEvaluator* e) {
   auto _e= s__cast(Basic,e);
+  if (dest >= 0)
+    return _e->jumpTo(dest), DVAL_NIL;
   auto res= expr->eval(e);
   auto line= vcast<d::Number>(res,tok()->addr());
   //std::cout << "Jumping to line: " << line << "\n";
-  return _e->jump(line->getInt()), NUMBER_VAL(0);
+  return _e->jump(line->getInt()), DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Goto::visit(d::IAnalyzer* a) {
+  expr->visit(a);
+  dest= jumpTarget(a, expr);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -327,33 +356,67 @@ stdstr Goto::pr_str() const {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue FuncCall::eval(d::IEvaluator* e) {
+enum { CALL_ARRAY=1, CALL_LIB, CALL_LAMBDA };
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue FuncCall::resolve(d::IEvaluator* e) {
   auto pvar= DCAST(Var,fn);
-  auto _A=tok()->addr();
-  auto n= pvar->name();
-  auto f= e->getValue(n);
+  auto f= pvar->eval(e);
 
   if (!f)
-    RAISE(d::NoSuchVar, "Unknown function/array: %s", n.c_str());
+    RAISE(d::NoSuchVar,
+          "Unknown function/array: %s", pvar->name().c_str());
+
+  // the callee rarely changes, so type it once
+  if (f != callee) {
+    auto& t= typeid(*f);
+    kind= t == typeid(BArray) ? CALL_ARRAY
+          : t == typeid(LibFunc) ? CALL_LIB
+          : t == typeid(Lambda) ? CALL_LAMBDA : 0;
+    if (kind == 0)
+      expected("Array var or function", f, tok()->addr());
+    callee=f;
+  }
 
-  auto fv = vcast<LibFunc>(f);
-  auto fd = vcast<Lambda>(f);
-  auto fa = vcast<BArray>(f);
+  return f;
+}
 
-  if (E_NIL(fa) &&
-      E_NIL(fv) && E_NIL(fd))
-    expected("Array var or function", f, _A);
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+llong FuncCall::element(d::IEvaluator* e, const BArray* arr) {
+  int n= args.size();
+  if (n != arr->dims())
+    E_SEMANTIC("Mismatch DIMs, wanted %d, got %d", arr->dims(), n);
+  llong pos=0;
+  for (auto i=0; i < n; ++i)
+    pos += arr->at(i, args[i]->evalValue(e));
+  return pos;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value FuncCall::evalValue(d::IEvaluator* e) {
+  auto f= resolve(e);
+  if (kind == CALL_ARRAY) {
+    auto arr= s__cast(BArray, f.get());
+    return arr->load(element(e, arr));
+  }
+  return d::Value(eval(e));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue FuncCall::eval(d::IEvaluator* e) {
+  auto f= resolve(e);
+  if (kind == CALL_ARRAY) {
+    auto arr= s__cast(BArray, f.get());
+    return arr->load(element(e, arr)).box();
+  }
 
   d::ValVec pms;
   for (auto& a : args)
     s__conj(pms, a->eval(e));
 
   d::VSlice _args(pms);
-  auto ff = X_NIL(fd) ? (Function*) fd : (Function*) fv;
-
-  return fa
-    ? fa->get(_args)
-    : (pms.empty() ? ff->invoke(e) : ff->invoke(e,_args));
+  auto ff = s__cast(Function, f.get());
+  return pms.empty() ? ff->invoke(e) : ff->invoke(e,_args);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -367,24 +430,29 @@ stdstr FuncCall::pr_str() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue BoolTerm::eval(d::IEvaluator* e) {
+  return evalValue(e).box();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value BoolTerm::evalValue(d::IEvaluator* e) {
   auto _A=tok()->addr();
   auto z=terms.size();
   auto i=0;
   auto ti= terms[i];
-  auto lhs = ti->eval(e);
-  auto res= !vcast<d::Number>(lhs,_A)->isZero();
+  auto lhs = ti->evalValue(e);
+  auto res= !vnum(lhs,_A).isZero();
   //just one term?
   if (z==1) return lhs;
-  if (!res) return FALSE_VAL();
+  if (!res) return d::Value::of(0);
   //
   ++i;
   while (i < z)
   { auto ti= terms[i];
-    auto _t = ti->eval(e);
-    auto rhs = !vcast<d::Number>(_t,_A)->isZero();
+    auto _t = ti->evalValue(e);
+    auto rhs = !vnum(_t,_A).isZero();
     res= (res && rhs);
     if (res) break; else ++i; }
-  return res ? TRUE_VAL() : FALSE_VAL();
+  return d::Value::of(res ? 1 : 0);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -410,13 +478,18 @@ stdstr BoolExpr::pr_str() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue BoolExpr::eval(d::IEvaluator* e) {
+  return evalValue(e).box();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value BoolExpr::evalValue(d::IEvaluator* e) {
   auto _A=tok()->addr();
   int z1= terms.size();
   int t1= ops.size();
   auto i=0;
   auto ti= terms[i];
-  auto lhs= ti->eval(e);
-  auto res= !vcast<d::Number>(lhs,_A)->isZero();
+  auto lhs= ti->evalValue(e);
+  auto res= !vnum(lhs,_A).isZero();
   if (z1==1) { return lhs; }
   while (i < t1) {
     auto t= ops[i];
@@ -424,15 +497,15 @@ d::DValue BoolExpr::eval(d::IEvaluator* e) {
       break;
     }
     auto ti=terms[i+1];
-    auto _r= ti->eval(e);
-    auto rhs= !vcast<d::Number>(_r,_A)->isZero();
+    auto _r= ti->evalValue(e);
+    auto rhs= !vnum(_r,_A).isZero();
     if (t->type() == T_XOR)
       res= (res != rhs);
     else
     if (rhs) { res=true; }
     ++i;
   }
-  return res ? TRUE_VAL() : FALSE_VAL();
+  return d::Value::of(res ? 1 : 0);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -447,53 +520,58 @@ stdstr RelationOp::pr_str() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue RelationOp::eval(d::IEvaluator* e) {
+  return evalValue(e).box();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value RelationOp::evalValue(d::IEvaluator* e) {
   auto _A= tok()->addr();
   auto k= tok()->type();
-  auto x = lhs->eval(e);
-  auto y = rhs->eval(e);
-  auto s1= vcast<d::String>(x);
-  auto s2= vcast<d::String>(y);
+  auto x = lhs->evalValue(e);
+  auto y = rhs->evalValue(e);
+  auto s1= vcast<d::String>(x.heap);
+  auto s2= vcast<d::String>(y.heap);
   if (s1 && s2) {
     switch (k) {
-    case d::T_EQ: return NUMBER_VAL(s1->impl()==s2->impl()?1:0);
-    case T_NOTEQ: return NUMBER_VAL(s1->impl()==s2->impl()?0:1);
+    case d::T_EQ: return d::Value::of(s1->impl()==s2->impl()?1:0);
+    case T_NOTEQ: return d::Value::of(s1->impl()==s2->impl()?0:1);
     }
     E_SEMANTIC("Bad op on strings near %s", d::pr_addr(_A).c_str()); }
   // fall through to numbers
-  auto xn= vcast<d::Number>(x,_A);
-  auto yn= vcast<d::Number>(y,_A);
-  auto ints = xn->isInt() && yn->isInt();
+  vnum(x,_A);
+  vnum(y,_A);
+  auto ints = x.isInt() && y.isInt();
   bool b=0;
 
   switch (k) {
   case T_NOTEQ:
-    b= x->equals(y) ? 0 : 1;
+    b= x.equals(y) ? 0 : 1;
   break;
   case d::T_EQ:
-    b= x->equals(y) ? 1 : 0;
+    b= x.equals(y) ? 1 : 0;
   break;
   case T_GTEQ:
     b= ints
-         ? xn->getInt() >= yn->getInt()
-         : xn->getFloat() >= yn->getFloat();
+         ? x.getInt() >= y.getInt()
+         : x.getFloat() >= y.getFloat();
   break;
   case T_LTEQ:
     b= ints
-         ? xn->getInt() <= yn->getInt()
-         : xn->getFloat() <= yn->getFloat();
+         ? x.getInt() <= y.getInt()
+         : x.getFloat() <= y.getFloat();
   break;
   case d::T_GT:
     b= ints
-         ? xn->getInt() > yn->getInt()
-         : xn->getFloat() > yn->getFloat();
+         ? x.getInt() > y.getInt()
+         : x.getFloat() > y.getFloat();
   break;
   case d::T_LT:
   b= ints
-       ? xn->getInt() < yn->getInt()
-       : xn->getFloat() < yn->getFloat();
+       ? x.getInt() < y.getInt()
+       : x.getFloat() < y.getFloat();
   break;
   }
-  return b ? TRUE_VAL() : FALSE_VAL();
+  return d::Value::of(b ? 1 : 0);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -517,19 +595,14 @@ d::DValue Read::eval(d::IEvaluator* e) {
     stdstr pv;
     if (z==T_ARRAYINDEX) {
       auto fc= DCAST(FuncCall,v);
-      d::ValVec out;
-      auto& args= fc->funcArgs();
-      for (auto& x : args)
-        s__conj(out, x->eval(e));
       auto fcn=fc->funcName();
       pv=PNAME(Var,fcn);
-      auto vv= e->getValue(pv);
+      auto vv= fcn->eval(e);
       auto arr= vcast<BArray>(vv,_A);
       ensure_data_type(pv,res);
-      arr->set(d::VSlice(out), res);
+      arr->store(fc->element(e, arr), d::Value(res));
     } else {
-      pv= PNAME(Var,v);
-      e->setValue(pv, res); } }
+      DCAST(Var,v)->set(e, res); } }
   return DVAL_NIL;
 }
 
@@ -540,27 +613,35 @@ stdstr NotFactor::pr_str() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue NotFactor::eval(d::IEvaluator* e) {
-  auto res= expr->eval(e);
-  auto i= vcast<d::Number>(res,tok()->addr());
-  return i->isZero() ? TRUE_VAL() : FALSE_VAL();
+  return evalValue(e).box();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value NotFactor::evalValue(d::IEvaluator* e) {
+  auto res= expr->evalValue(e);
+  return d::Value::of(vnum(res,tok()->addr()).isZero() ? 1 : 0);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue BinOp::eval(d::IEvaluator* e) {
+  return evalValue(e).box();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value BinOp::evalValue(d::IEvaluator* e) {
   auto _A= tok()->addr();
   auto t= tok()->type();
-  auto lf= lhs->eval(e);
-  auto rt= rhs->eval(e);
-  auto s1= vcast<d::String>(lf);
-  auto s2= vcast<d::String>(rt);
-  auto n1= vcast<d::Number>(lf);
-  auto n2= vcast<d::Number>(rt);
-
-  if (n1 && n2)
+  auto lf= lhs->evalValue(e);
+  auto rt= rhs->evalValue(e);
+
+  // no boxing on the numeric path
+  if (lf.isNumber() && rt.isNumber())
     return op_math(lf, t, rt);
 
+  auto s1= vcast<d::String>(lf.heap);
+  auto s2= vcast<d::String>(rt.heap);
   if (s1 && s2 && t==d::T_PLUS)
-    return STRING_VAL(s1->impl() + s2->impl());
+    return d::Value(STRING_VAL(s1->impl() + s2->impl()));
 
   E_SEMANTIC("Bad op `%s` near %s",
                typeToString(t).c_str(), d::pr_addr(_A).c_str());
@@ -586,24 +667,42 @@ void Defun::visit(d::IAnalyzer* a) {
   var->visit(a);
   StrVec vs;
 
+  auto vn = PNAME(Var,var);
+  auto _a = s__cast(Basic, a);
+  // params shadow the globals inside the body
+  auto scope= a->pushScope(vn);
   for (auto& p : params)
-  { p->visit(a);
+  { a->define(d::Symbol::make(PNAME(Var,p)));
+    p->visit(a);
     s__conj(vs, PNAME(Var,p)); }
 
-  auto vn = PNAME(Var,var);
-  auto _a = s__cast(Basic, a);
   body->visit(a);
-  _a->addLambda(Lambda::make(vn, vs, body));
+  a->popScope();
+  _a->addLambda(Lambda::make(vn, vs, body, scope));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue Num::eval(d::IEvaluator* e) {
-  if (tok()->type() == d::T_INT) {
-    return NUMBER_VAL(tok()->getInt()); }
+Num::Num(d::DToken t) : Ast(t) {
+  if (t->type() == d::T_INT) {
+    lit= d::Value::of(t->getInt()); }
   else {
-    return NUMBER_VAL(tok()->getFloat()); }
+    lit= d::Value::of(t->getFloat()); }
+  boxed= lit.box();
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Num::eval(d::IEvaluator* e) { return boxed; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Num::pr_str() const {
+  // a folded one has the token of the expression it was
+  auto k= tok()->type();
+  return k == d::T_INT || k == d::T_REAL ? tok()->getStr() : boxed->pr_str();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value Num::evalValue(d::IEvaluator* e) { return lit; }
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr String::pr_str() const {
   return "\"" + tok()->pr_str() + "\"";
@@ -616,7 +715,32 @@ d::DValue String::eval(d::IEvaluator*) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Var::eval(d::IEvaluator* e) {
-  return e->getValue(tok()->getStr());
+  return addr.ok() ? e->getValue(addr) : e->getValue(_name, rcache);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Var::set(d::IEvaluator* e, d::DValue v) {
+  if (!addr.ok()) {
+    return e->setValue(_name, v, wcache);
+  }
+  ensure_data_type(name(), v);
+  return e->setValue(addr, v);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value Var::evalValue(d::IEvaluator* e) {
+  return addr.ok()
+         ? e->load(addr) : d::Value(e->getValue(_name, rcache));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Var::store(d::IEvaluator* e, const d::Value& v) {
+  if (!addr.ok()) {
+    e->setValue(_name, v.box(), wcache);
+  } else {
+    ensure_data_type(name(), v);
+    e->store(addr, v);
+  }
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -626,13 +750,18 @@ stdstr UnaryOp::pr_str() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue UnaryOp::eval(d::IEvaluator* e) {
-  auto res = expr->eval(e);
-  auto n = vcast<d::Number>(res,tok()->addr());
+  return evalValue(e).box();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value UnaryOp::evalValue(d::IEvaluator* e) {
+  auto res = expr->evalValue(e);
+  vnum(res,tok()->addr());
   if (tok()->type() == d::T_MINUS)
-  { if (n->isInt())
-      res = NUMBER_VAL(- n->getInt());
+  { if (res.isInt())
+      res = d::Value::of(- res.getInt());
     else
-      res = NUMBER_VAL(- n->getFloat()); }
+      res = d::Value::of(- res.getFloat()); }
   return res;
 }
 
@@ -675,24 +804,18 @@ d::DValue PrintSep::eval(d::IEvaluator* e) {
 d::DValue Assignment::eval(d::IEvaluator* e) {
   auto t= DCAST(Ast,lhs)->tok()->type();
   auto _A=tok()->addr();
-  auto res= rhs->eval(e);
+  auto res= rhs->evalValue(e);
 
   if (t == T_ARRAYINDEX) {
     auto fc = DCAST(FuncCall,lhs);
     auto fn = fc->funcName();
-    auto& args= fc->funcArgs();
-    d::ValVec out;
-
-    for (auto& x : args)
-      s__conj(out, x->eval(e));
-
     auto vn = PNAME(Var,fn);
-    auto vv= e->getValue(vn);
+    auto vv= fn->eval(e);
     auto arr= vcast<BArray>(vv,_A);
     ensure_data_type(vn,res);
-    arr->set(d::VSlice(out), res);
+    arr->store(fc->element(e, arr), res);
   } else {
-    e->setValue(PNAME(Var,lhs), res); }
+    DCAST(Var,lhs)->store(e, res); }
 
   return DVAL_NIL;
 }
@@ -718,11 +841,11 @@ void Assignment::visit(d::IAnalyzer* a) {
       E_SEMANTIC("Wanted array var %s near %s",
                    vn.c_str(), d::pr_addr(_A).c_str()); }
 
-  lhs->visit(a);
-  rhs->visit(a);
-
   if (t != T_ARRAYINDEX)
     a->define(d::Symbol::make(vn));
+
+  lhs->visit(a);
+  rhs->visit(a);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -744,8 +867,7 @@ stdstr ArrayDecl::pr_str() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue ArrayDecl::eval(d::IEvaluator* e) {
-  auto n= PNAME(Var,var);
-  return e->setValue(n, BArray::make(ranges));
+  return DCAST(Var,var)->set(e, BArray::make(PNAME(Var,var), ranges));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -756,6 +878,178 @@ void ArrayDecl::visit(d::IAnalyzer* a) {
     E_SEMANTIC("Duplicate array var %s near %s.",
                  n.c_str(), d::pr_addr(_A).c_str());
   a->define(d::Symbol::make(n, d::Symbol::make("ARRAY")));
+  var->visit(a);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the array a MAT operand names, held so it stays alive
+BArray* matArray(d::IEvaluator* e, d::DAst v, d::DValue& hold, d::Addr mark) {
+  hold= v->eval(e);
+  return vcast<BArray>(hold, mark);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void matVisit(d::IAnalyzer* a, d::DAst v, d::Addr mark) {
+  auto n= PNAME(Var,v);
+  if (!a->find(n))
+    E_SEMANTIC("Wanted array var %s near %s",
+               n.c_str(), d::pr_addr(mark).c_str());
+  v->visit(a);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue MatRead::eval(d::IEvaluator* e) {
+  auto _e = s__cast(Basic, e);
+  auto _A= tok()->addr();
+  for (auto& v : vars) {
+    d::DValue hold;
+    auto arr= matArray(e, v, hold, _A);
+    auto n= PNAME(Var,v);
+    MatShape s(arr);
+    for (int i=1; i <= s.rows; ++i)
+    for (int j=1; j <= s.cols; ++j) {
+      auto res= _e->readData();
+      if (!res)
+        E_SEMANTIC("Can't read data near %s", d::pr_addr(_A).c_str());
+      ensure_data_type(n, res);
+      arr->store(s.at(i,j), d::Value(res));
+    }
+  }
+  return DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void MatRead::visit(d::IAnalyzer* a) {
+  for (auto& v : vars) matVisit(a, v, tok()->addr());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr MatRead::pr_str() const {
+  stdstr b;
+  for (auto& v : vars)
+    b += stdstr(b.empty()?"":" , ") + PRN(v);
+  return stdstr(PRK(tok())) + " READ " + b;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue MatPrint::eval(d::IEvaluator* e) {
+  auto _e = s__cast(Basic, e);
+  auto _A= tok()->addr();
+  for (size_t k=0; k < vars.size(); ++k) {
+    if (DCAST(Ast,vars[k])->tok()->type() != d::T_IDENT) { continue; }
+    auto packed= k+1 < vars.size() &&
+                 DCAST(Ast,vars[k+1])->tok()->type() == d::T_SEMI;
+    d::DValue hold;
+    auto arr= matArray(e, vars[k], hold, _A);
+    MatShape s(arr);
+    for (int i=1; i <= s.rows; ++i) {
+      stdstr row;
+      for (int j=1; j <= s.cols; ++j) {
+        if (j > 1) row += packed ? " " : "\t";
+        row += arr->load(s.at(i,j)).box()->pr_str(0);
+      }
+      _e->writeString(row);
+      _e->writeln();
+    }
+    _e->writeln();
+  }
+  return DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void MatPrint::visit(d::IAnalyzer* a) {
+  for (auto& v : vars)
+    if (DCAST(Ast,v)->tok()->type() == d::T_IDENT)
+      matVisit(a, v, tok()->addr());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr MatPrint::pr_str() const {
+  stdstr b;
+  for (auto& v : vars)
+    b += stdstr(b.empty()?"":" ") + PRN(v);
+  return stdstr(PRK(tok())) + " PRINT " + b;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue MatAssign::eval(d::IEvaluator* e) {
+  auto _A= tok()->addr();
+  d::DValue ho, hl, hr;
+  auto out= matArray(e, var, ho, _A);
+  switch (op) {
+  case MAT_ZER:
+  case MAT_CON:
+  case MAT_IDN: {
+    IntVec b;
+    for (auto& x : dims)
+      s__conj(b, (int) vnum(x->evalValue(e), _A).getInt());
+    matFill(out, op, b);
+  }
+  break;
+  case MAT_COPY:
+    matCopy(out, matArray(e, lhs, hl, _A));
+  break;
+  case MAT_ADD:
+  case MAT_SUB:
+    matAdd(out, matArray(e, lhs, hl, _A),
+                matArray(e, rhs, hr, _A), op == MAT_SUB);
+  break;
+  case MAT_MUL:
+    matMul(out, matArray(e, lhs, hl, _A), matArray(e, rhs, hr, _A));
+  break;
+  case MAT_SCALE:
+    matScale(out, vnum(scalar->evalValue(e), _A),
+                  matArray(e, rhs, hr, _A));
+  break;
+  case MAT_TRN:
+    matTrn(out, matArray(e, lhs, hl, _A));
+  break;
+  case MAT_INV:
+    matInv(out, matArray(e, lhs, hl, _A));
+  break;
+  }
+  return DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void MatAssign::visit(d::IAnalyzer* a) {
+  auto _A= tok()->addr();
+  matVisit(a, var, _A);
+  if (lhs) matVisit(a, lhs, _A);
+  if (rhs) matVisit(a, rhs, _A);
+  if (scalar) scalar->visit(a);
+  for (auto& x : dims) x->visit(a);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr MatAssign::pr_str() const {
+  stdstr b, buf { PRK(tok()) };
+  buf += stdstr(" ") + PRN(var) + " = ";
+  switch (op) {
+  case MAT_ZER:
+  case MAT_CON:
+  case MAT_IDN:
+    buf += op == MAT_ZER ? "ZER" : op == MAT_CON ? "CON" : "IDN";
+    for (auto& x : dims)
+      b += stdstr(b.empty()?"":",") + PRN(x);
+    if (!dims.empty()) { buf += "(" + b + ")"; }
+  break;
+  case MAT_TRN:
+  case MAT_INV:
+    buf += stdstr(op == MAT_TRN ? "TRN(" : "INV(") + PRN(lhs) + ")";
+  break;
+  case MAT_SCALE:
+    buf += stdstr("(") + PRN(scalar) + ") * " + PRN(rhs);
+  break;
+  case MAT_COPY:
+    buf += PRN(lhs);
+  break;
+  default:
+    buf += stdstr(PRN(lhs)) +
+           (op == MAT_ADD ? " + " : op == MAT_SUB ? " - " : " * ") + PRN(rhs);
+  break;
+  }
+  return buf;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -785,7 +1079,7 @@ d::DValue Input::eval(d::IEvaluator* e) {
   else
     v= NUMBER_VAL(::atoi(cs));
 
-  return e->setValue(vn,v), DVAL_NIL;
+  return DCAST(Var,var)->set(e,v), DVAL_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -802,6 +1096,12 @@ BasicParser::BasicParser(const Tchar* src) {
   curLine=1;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+BasicParser::BasicParser(d::Source* in) {
+  lex=new Lexer(in);
+  curLine=1;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 BasicParser::~BasicParser() { DEL_PTR(lex); }
 
@@ -1184,6 +1484,80 @@ d::DAst declArray(BasicParser* bp) {
   return ArrayDecl::make(_t, Var::make(t), sizes);
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// MAT READ, MAT PRINT or MAT var = ..., ZER, CON, IDN, TRN and INV
+// are names anywhere else
+d::DAst matrix(BasicParser* bp) {
+  auto t= bp->eat(T_MAT);
+  d::AstVec v;
+
+  if (bp->isCur(T_READ)) {
+    bp->eat();
+    s__conj(v, mkvar(bp));
+    while (bp->isCur(d::T_COMMA))
+    { bp->eat();
+      s__conj(v, mkvar(bp)); }
+    return MatRead::make(t, v);
+  }
+
+  if (bp->isCur(T_PRINT)) {
+    bp->eat();
+    while (!(bp->isCur(d::T_COLON) ||
+             bp->isCur(T_EOL) ||
+             bp->isEof()))
+    { if (bp->isCur(d::T_SEMI) ||
+          bp->isCur(d::T_COMMA))
+        s__conj(v, PrintSep::make(bp->eat()));
+      else
+        s__conj(v, mkvar(bp)); }
+    return MatPrint::make(t, v);
+  }
+
+  auto var= mkvar(bp);
+  bp->eat(d::T_EQ);
+  d::DAst lhs, rhs, k;
+  int op= MAT_COPY;
+
+  if (bp->isCur(d::T_LPAREN)) {
+    bp->eat();
+    k= expr(bp);
+    bp->eat(d::T_RPAREN);
+    bp->eat(d::T_MULT);
+    return MatAssign::make(t, MAT_SCALE, var, lhs, mkvar(bp), k, v);
+  }
+
+  auto n= bp->eat(d::T_IDENT);
+  auto f= n->getStr();
+  if (f == "ZER" || f == "CON" || f == "IDN") {
+    op= f == "ZER" ? MAT_ZER : f == "CON" ? MAT_CON : MAT_IDN;
+    if (bp->isCur(d::T_LPAREN))
+    { bp->eat();
+      s__conj(v, expr(bp));
+      while (bp->isCur(d::T_COMMA))
+      { bp->eat();
+        s__conj(v, expr(bp)); }
+      bp->eat(d::T_RPAREN); }
+  }
+  else
+  if (f == "TRN" || f == "INV") {
+    op= f == "TRN" ? MAT_TRN : MAT_INV;
+    bp->eat(d::T_LPAREN);
+    lhs= mkvar(bp);
+    bp->eat(d::T_RPAREN);
+  }
+  else {
+    lhs= Var::make(n);
+    if (bp->isCur(d::T_PLUS) ||
+        bp->isCur(d::T_MINUS) ||
+        bp->isCur(d::T_MULT))
+    { auto o= bp->eat()->type();
+      op= o == d::T_PLUS ? MAT_ADD : o == d::T_MINUS ? MAT_SUB : MAT_MUL;
+      rhs= mkvar(bp); }
+  }
+
+  return MatAssign::make(t, op, var, lhs, rhs, k, v);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst statement(BasicParser* bp) {
   d::DAst res;
@@ -1243,6 +1617,9 @@ d::DAst statement(BasicParser* bp) {
   case T_DIM:
     res=declArray(bp);
   break;
+  case T_MAT:
+    res=matrix(bp);
+  break;
   case T_LET: {
     auto t= bp->eat();
     auto _A=t->addr();
@@ -1328,12 +1705,10 @@ d::DAst parse_line(BasicParser* bp) {
 d::DAst program(BasicParser* bp) {
   std::map<int,d::DAst> lines;
   d::AstVec raws;
-  do {
-    if (auto res= parse_line(bp); res)
-    { auto n = bp->line();
-      if (n < 0)
-        s__conj(raws,res); else lines[n]= res; }
-  } while (!bp->isEof());
+  while (auto res= bp->nextLine()) {
+    auto n = bp->line();
+    if (n < 0)
+      s__conj(raws,res); else lines[n]= res; }
   //std::cout << "parsed ALL lines, total count = " << lines.size() << "\n";
   return Program::make(d::Token::make(T_PROGRAM,"<>",DMARK(1,1)), lines);
 }
@@ -1343,6 +1718,14 @@ d::DAst BasicParser::parse() {
   return program(this);
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BasicParser::nextLine() {
+  while (!isEof()) {
+    if (auto res= parse_line(this); res) { return res; }
+  }
+  return d::DAst();
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int BasicParser::cur() {
   return lex->ctx().cur->type();
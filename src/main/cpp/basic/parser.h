@@ -55,8 +55,12 @@ struct FuncCall : public Ast {
 
   d::AstVec& funcArgs()  { return args; }
   d::DAst funcName() const { return fn; }
+  // where the subscripts point to in the array
+  llong element(d::IEvaluator*, const BArray*);
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     fn->visit(a);
     for (auto& x:args) x->visit(a);
@@ -76,6 +80,10 @@ struct FuncCall : public Ast {
   }
   d::DAst fn;
   d::AstVec args;
+  // the last callee and what it is, held so it can't be reused
+  d::DValue callee;
+  int kind=0;
+  d::DValue resolve(d::IEvaluator*);
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -86,6 +94,8 @@ struct BoolTerm : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     for(auto& x:terms)x->visit(a);
   }
@@ -106,6 +116,8 @@ struct BoolExpr : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     for (auto& x:terms) x->visit(a);
   }
@@ -130,6 +142,8 @@ struct RelationOp : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     lhs->visit(a),rhs->visit(a);
   }
@@ -154,6 +168,8 @@ struct NotFactor : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     expr->visit(a);
   }
@@ -174,6 +190,7 @@ struct Assignment : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~Assignment() {}
@@ -193,6 +210,8 @@ struct BinOp : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     lhs->visit(a),rhs->visit(a);
   }
@@ -210,16 +229,29 @@ struct BinOp : public Ast {
 struct Num : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*) {}
   static d::DAst make(d::DToken t) {
     return WRAP_AST(Num,t);
   }
+  // what the expression at t folds into
+  static d::DAst make(d::DToken t, const d::Value& v) {
+    return WRAP_AST(Num,t,v);
+  }
+
+  // the literal, for what is worked out before running
+  const d::Value& value() const { return lit; }
 
+  virtual stdstr pr_str() const;
   virtual ~Num() {}
 
   protected:
 
-  Num(d::DToken t) : Ast(t) {}
+  Num(d::DToken t);
+  Num(d::DToken t, const d::Value& v) : Ast(t), lit(v) { boxed= lit.box(); }
+  // the literal, made once
+  d::DValue boxed;
+  d::Value lit;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -243,9 +275,12 @@ struct String : public Ast {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Var : public Ast {
 
-  stdstr name() const { return tok()->getStr(); }
+  cstdstr& name() const { return _name; }
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer*) {}
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual void visit(d::IAnalyzer* a) { addr= a->resolve(name()); }
+  d::DValue set(d::IEvaluator*, d::DValue);
+  void store(d::IEvaluator*, const d::Value&);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST(Var,t);
@@ -253,9 +288,19 @@ struct Var : public Ast {
 
   virtual ~Var() {}
 
+  // unresolved if first seen ahead of its definition
+  d::LexAddr addr;
+
   protected:
 
-  Var(d::DToken t) : Ast(t) {}
+  Var(d::DToken t) : Ast(t), _name(t->getStr()) {}
+
+  private:
+
+  stdstr _name;
+  // for when addr is not ok, such as builtins and FN names
+  d::NameCache rcache;
+  d::NameCache wcache;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -266,6 +311,8 @@ struct UnaryOp : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::Value evalValue(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     expr->visit(a);
   }
@@ -336,7 +383,10 @@ struct Read : public Ast {
   virtual d::DValue eval(d::IEvaluator*);
   virtual stdstr pr_str() const;
   virtual void visit(d::IAnalyzer* a) {
-    for (auto& x:vars) x->visit(a);
+    for (auto& x:vars)
+    { if (DCAST(Ast,x)->tok()->type() != T_ARRAYINDEX)
+        a->define(d::Symbol::make(PNAME(Var,x)));
+      x->visit(a); }
   }
 
   virtual ~Read() {}
@@ -373,9 +423,7 @@ struct GoSub : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a) {
-    expr->visit(a);
-  }
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~GoSub() {}
 
@@ -385,6 +433,8 @@ struct GoSub : public Ast {
     expr=a;
   }
   d::DAst expr;
+  // the statement to go to, -1 if the line is known only when run
+  int dest=-1;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -395,9 +445,7 @@ struct Goto : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a) {
-    expr->visit(a);
-  }
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~Goto() {}
 
@@ -407,6 +455,8 @@ struct Goto : public Ast {
     expr=a;
   }
   d::DAst expr;
+  // the statement to go to, -1 if the line is known only when run
+  int dest=-1;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -417,9 +467,7 @@ struct OnXXX : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a) {
-    var->visit(a);
-  }
+  virtual void visit(d::IAnalyzer*);
   virtual ~OnXXX() {}
 
   private:
@@ -427,6 +475,8 @@ struct OnXXX : public Ast {
   OnXXX(d::DToken, d::DAst, d::TokenVec&);
   d::DAst var;
   IntVec targets;
+  // the statements for the targets, -1 for a line not there
+  IntVec dests;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -437,6 +487,7 @@ struct Defun : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual ~Defun() {}
 
@@ -470,6 +521,8 @@ struct ForNext : public Ast {
   ForNext(d::DToken t, d::DAst v) : Ast(t) { var=v; }
   ForNext(d::DToken t) : Ast(t) {}
   d::DAst var;
+  // the loop, linked when analyzed
+  DslFLInfo info;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -480,6 +533,7 @@ struct ForLoop : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~ForLoop() {}
@@ -490,6 +544,8 @@ struct ForLoop : public Ast {
     var = v; init = i; term = t; step = s;
   }
   d::DAst var,init,term,step;
+  // made when analyzed, shared with the NEXT
+  DslFLInfo info;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -516,6 +572,7 @@ struct Print : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     for (auto& x:exprs) x->visit(a);
   }
@@ -542,6 +599,7 @@ struct IfThen : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     cond->visit(a);
     then->visit(a);
@@ -565,6 +623,7 @@ struct Program : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~Program() {}
@@ -573,6 +632,9 @@ struct Program : public Ast {
 
   Program(d::DToken,const std::map<int,d::DAst>&);
   d::AstVec vlines;
+  // the statements of all lines, in order, and where each line
+  // starts in there
+  d::AstVec code;
   std::map<int,int> mlines;
 };
 
@@ -584,12 +646,15 @@ struct Compound : public Ast {
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual d::DAst fold(d::Folder*);
   virtual void visit(d::IAnalyzer* a) {
     for (auto& x:stmts) x->visit(a);
   }
   virtual stdstr pr_str() const;
   virtual ~Compound() {}
 
+  const d::AstVec& statements() const { return stmts; }
+
   private:
 
   Compound(d::DToken,int line, const d::AstVec&);
@@ -625,6 +690,7 @@ struct Input : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer* a) {
+    a->define(d::Symbol::make(PNAME(Var,var)));
     var->visit(a);
     if (prompt) prompt->visit(a);
   }
@@ -681,6 +747,83 @@ struct ArrayDecl : public Ast {
   IntVec ranges;
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// MAT READ a, b, ...  DATA into each array, row by row, from 1.
+struct MatRead : public Ast {
+
+  static d::DAst make(d::DToken t, const d::AstVec& v) {
+    return WRAP_AST(MatRead,t,v);
+  }
+
+  virtual d::DValue eval(d::IEvaluator*);
+  virtual void visit(d::IAnalyzer*);
+  virtual stdstr pr_str() const;
+  virtual ~MatRead() {}
+
+  private:
+
+  MatRead(d::DToken t, const d::AstVec& v) : Ast(t) {
+    s__ccat(vars,v);
+  }
+  d::AstVec vars;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// MAT PRINT a; b, ...  a row a line, packed after a ';'.
+struct MatPrint : public Ast {
+
+  static d::DAst make(d::DToken t, const d::AstVec& v) {
+    return WRAP_AST(MatPrint,t,v);
+  }
+
+  virtual d::DValue eval(d::IEvaluator*);
+  virtual void visit(d::IAnalyzer*);
+  virtual stdstr pr_str() const;
+  virtual ~MatPrint() {}
+
+  private:
+
+  MatPrint(d::DToken t, const d::AstVec& v) : Ast(t) {
+    s__ccat(vars,v);
+  }
+  // the arrays, each followed by its PrintSep if any
+  d::AstVec vars;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// MAT var = ..., op one of MAT_XXX, see mat.h.  lhs and rhs are
+// the array operands, scalar the (expr) of a MAT_SCALE, dims the
+// new bounds of a ZER, CON or IDN.
+struct MatAssign : public Ast {
+
+  static d::DAst make(d::DToken t, int op, d::DAst var,
+                      d::DAst lhs, d::DAst rhs,
+                      d::DAst scalar, const d::AstVec& dims) {
+    return WRAP_AST(MatAssign,t,op,var,lhs,rhs,scalar,dims);
+  }
+
+  virtual d::DValue eval(d::IEvaluator*);
+  virtual void visit(d::IAnalyzer*);
+  virtual stdstr pr_str() const;
+  virtual ~MatAssign() {}
+
+  private:
+
+  MatAssign(d::DToken t, int op, d::DAst var,
+            d::DAst lhs, d::DAst rhs,
+            d::DAst scalar, const d::AstVec& dims) : Ast(t) {
+    this->op=op;
+    this->var=var;
+    this->lhs=lhs;
+    this->rhs=rhs;
+    this->scalar=scalar;
+    s__ccat(this->dims,dims);
+  }
+  int op;
+  d::DAst var, lhs, rhs, scalar;
+  d::AstVec dims;
+};
+
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct BasicParser : public d::IParser {
@@ -693,9 +836,13 @@ struct BasicParser : public d::IParser {
   void setLine(int n) { curLine=n;}
 
   BasicParser(const Tchar* src);
+  // lines are read off the source one at a time, see nextLine()
+  BasicParser(d::Source*);
   virtual ~BasicParser();
 
   d::DAst parse();
+  // the next line, its number in line(), null at the end
+  d::DAst nextLine();
   int cur();
   char peek();
   bool isCur(int);
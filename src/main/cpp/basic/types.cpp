@@ -34,66 +34,72 @@ d::DValue expected(cstdstr& m, d::DValue v) {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-BArray::~BArray() { DEL_PTR(value); }
+BArray::BArray(cstdstr& name, const IntVec& szs) {
+  switch (name[name.size()-1]) {
+  case '$': kind=STRS; break;
+  case '!':
+  case '#': kind=REALS; break;
+  case '%': break;
+  default: loose=true; break;
+  }
+  reshape(szs);
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-BArray::BArray(const IntVec& szs) {
+void BArray::reshape(const IntVec& szs) {
   // DIM(2,2,2) => 3 x 3 x 3 = 27
-  int len = 1;
+  len = 1;
+  ranges.clear();
+  strides.clear();
   for (auto& n : szs) {
     auto actual = n+1;
+    s__conj(strides,len);
     len = len * actual;
     s__conj(ranges,actual); }
 
   ASSERT(len >= 0,
-         "Array size >= 0, got %d", len);
-
-  value=new d::ValVec(len);
+         "Array size >= 0, got %d", (int) len);
+
+  if (kind == STRS)
+    strs.assign(len, STRING_VAL(""));
+  else if (kind == REALS)
+    reals.assign(len, 0.0);
+  else
+    ints.assign(len, 0);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue BArray::set(d::VSlice pms, d::DValue v) {
-  int pos = index(pms);
-  if (pos < 0 || pos >= value->size())
-    RAISE(d::IndexOOB,
-          "Array::set, index out of bound, got %d", pos);
-  value->operator[](pos)= v;
-  return v;
+bool BArray::toReals() {
+  if (kind == REALS) { return true; }
+  if (!loose) { return false; }
+  reals.assign(ints.begin(), ints.end());
+  LongVec().swap(ints);
+  kind=REALS;
+  return true;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue BArray::get(d::VSlice pms) {
-  int pos= index(pms);
-  if (pos < 0 || pos >= value->size())
-    RAISE(d::IndexOOB,
-          "Array::get, index out of bound, got %d", pos);
-  return value->operator[](pos);
+void BArray::store(llong pos, const d::Value& v) {
+  if (kind == STRS) {
+    strs[pos]= v.box();
+  } else if (kind == REALS) {
+    reals[pos]= v.getFloat();
+  } else if (v.isInt() || !loose) {
+    ints[pos]= v.getInt();
+  } else {
+    // the first real, so reals from now on
+    toReals();
+    reals[pos]= v.getFloat();
+  }
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-int BArray::index(d::VSlice pms) {
-  if (ranges.size() != pms.size())
-    E_SEMANTIC("Mismatch DIMs, wanted %d, got %d",
-               (int) ranges.size(), (int) pms.size());
-  //algo= z * (XY) + yX + x
-  //DIM(3,3,3) A(2,2,2)
-  auto X=0,Y=0,Z=0;
-  auto x=0,y=0,z=0;
-  for (int i=0,e=pms.size();i<e;++i) {
-    auto v= *(pms.begin+i);
-    auto num= vcast<d::Number>(v);
-    if (!(num && num->isInt()))
-      E_SEMANTIC("Array index expected Int, got %s", PRV(v,1));
-    switch (i) {
-    case 0:
-      X=ranges[i]; x= num->getInt(); break;
-    case 1:
-      Y=ranges[i]; y= num->getInt(); break;
-    case 2:
-      Z=ranges[i]; z= num->getInt(); break;
-    }
-  }
-  return z * (X * Y) + y * X + x;
+void BArray::badIndex(int dim, const d::Value& v) const {
+  if (!v.isInt())
+    E_SEMANTIC("Array index expected Int, got %s", PRV(v.box(),1));
+  RAISE(d::IndexOOB,
+        "Array index out of bound, got %d for DIM %d",
+        (int) v.n, ranges[dim]-1);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -109,12 +115,10 @@ bool BArray::equals(d::DValue rhs) const {
   bool ok=0;
   if (d::is_same(rhs, this)) {
     auto p= DCAST(BArray, rhs);
-    int i=0;
-    int len = value->size();
-    if (len == p->value->size()) {
+    if (len == p->len) {
+      llong i=0;
       for (; i < len; ++i) {
-        if (! (*value)[i]->equals(
-              p->value->operator[](i))) break; }
+        if (!load(i).equals(p->load(i))) break; }
       ok = i >= len;
     }
   }
@@ -125,8 +129,7 @@ bool BArray::equals(d::DValue rhs) const {
 int BArray::compare(d::DValue rhs) const {
   if (d::is_same(rhs, this)) {
     auto p= DCAST(BArray, rhs);
-    auto len = value->size();
-    auto rz = p->value->size();
+    auto rz = p->len;
     if (equals(rhs)) { return 0; }
     if (len > rz) { return 1; }
     if (len < rz) { return -1; }
@@ -138,61 +141,66 @@ int BArray::compare(d::DValue rhs) const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue op_math(d::DValue left, int op, d::DValue right) {
-  auto rhs = vcast<d::Number>(right,DMARK_00);
-  auto lhs = vcast<d::Number>(left,DMARK_00);
-  bool ints = lhs->isInt() && rhs->isInt();
+  vcast<d::Number>(right,DMARK_00);
+  vcast<d::Number>(left,DMARK_00);
+  return op_math(d::Value(left), op, d::Value(right)).box();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value op_math(const d::Value& lhs, int op, const d::Value& rhs) {
+  bool ints = lhs.isInt() && rhs.isInt();
   llong L;
   double R;
   switch (op) {
   case T_INT_DIV:
     if (!ints)
       E_SYNTAX("Operator INT-DIV requires %d ints", 2);
-    if (rhs->isZero())
+    if (rhs.isZero())
       RAISE(d::DivByZero,
-            "Div by zero, denominator= %d", (int)rhs->getInt());
-    L = (lhs->getInt() / rhs->getInt());
+            "Div by zero, denominator= %d", (int)rhs.getInt());
+    L = (lhs.getInt() / rhs.getInt());
   break;
   case d::T_PLUS:
     if (ints)
-      L = lhs->getInt() + rhs->getInt();
+      L = lhs.getInt() + rhs.getInt();
     else
-      R = lhs->getFloat() + rhs->getFloat();
+      R = lhs.getFloat() + rhs.getFloat();
   break;
   case d::T_MINUS:
     if (ints)
-      L = lhs->getInt() - rhs->getInt();
+      L = lhs.getInt() - rhs.getInt();
     else
-      R = lhs->getFloat() - rhs->getFloat();
+      R = lhs.getFloat() - rhs.getFloat();
   break;
   case d::T_MULT:
     if (ints)
-      L = lhs->getInt() * rhs->getInt();
+      L = lhs.getInt() * rhs.getInt();
     else
-      R = lhs->getFloat() * rhs->getFloat();
+      R = lhs.getFloat() * rhs.getFloat();
   break;
   case d::T_DIV:
-    if (rhs->isZero())
+    if (rhs.isZero())
       RAISE(d::DivByZero,
-            "Div by zero, denominator= %d", (int)rhs->getInt());
+            "Div by zero, denominator= %d", (int)rhs.getInt());
     if (ints)
-      L = lhs->getInt() / rhs->getInt();
+      L = lhs.getInt() / rhs.getInt();
     else
-      R = lhs->getFloat() / rhs->getFloat();
+      R = lhs.getFloat() / rhs.getFloat();
   break;
   case T_MOD:
     if (ints)
-      L = (lhs->getInt() % rhs->getInt());
+      L = (lhs.getInt() % rhs.getInt());
     else
-      R = ::fmod(lhs->getFloat(),rhs->getFloat());
+      R = ::fmod(lhs.getFloat(),rhs.getFloat());
   break;
   case T_POWER:
     if (ints)
-      L = ::pow(lhs->getInt(), rhs->getInt());
+      L = ::pow(lhs.getInt(), rhs.getInt());
     else
-      R = ::pow(lhs->getFloat(),rhs->getFloat());
+      R = ::pow(lhs.getFloat(),rhs.getFloat());
   break;
   }
-  return ints ? NUMBER_VAL(L) : NUMBER_VAL(R);
+  return ints ? d::Value::of(L) : d::Value::of(R);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -201,7 +209,8 @@ void ensure_data_type(cstdstr& n, d::DValue v) {
   auto cz= n[n.size()-1];
   switch (cz) {
   case '$':
-    if (!s)
+    // an array checks its own elements
+    if (!s && !vcast<BArray>(v))
       E_SYNTAX("Wanted string, got %s", PRV(v,1));
   break;
   case '!': // single
@@ -216,9 +225,19 @@ void ensure_data_type(cstdstr& n, d::DValue v) {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Lambda::Lambda(cstdstr& name, StrVec& pms, d::DAst e) : Function(name) {
+void ensure_data_type(cstdstr& n, const d::Value& v) {
+  if (v.isObj()) {
+    return ensure_data_type(n, v.heap); }
+  if (n[n.size()-1] == '$')
+    E_SYNTAX("Wanted string, got %s", PRV(v.box(),1));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Lambda::Lambda(cstdstr& name,
+               StrVec& pms, d::DAst e, d::DTable t) : Function(name) {
   s__ccat(params, pms);
   body=e;
+  scope=t;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -228,8 +247,12 @@ d::DValue Lambda::invoke(d::IEvaluator* e, d::VSlice args) {
           "Arity error, wanted %d got %d",
           (int) params.size(), (int) args.size());
 
-  // we need to create a new frame to process this defn.
-  e->pushFrame(name());
+  // we need to create a new frame to process this defn,
+  // globals are always one frame up.
+  if (scope)
+    e->pushFrame(name(), scope, d::Frame::getRoot(e->peekFrame()));
+  else
+    e->pushFrame(name());
 
   // push all args onto stack
   for (int i=0, z=params.size(); i < z; ++i) {
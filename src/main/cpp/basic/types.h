@@ -13,6 +13,7 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include "../dsl/fold.h"
 #include "lexer.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -36,7 +37,6 @@ namespace d= czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 typedef d::DValue (*Invoker) (d::IEvaluator*, d::VSlice);
-typedef std::pair<int,int> CheckPt;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Function : public d::Data {
@@ -93,8 +93,8 @@ struct Lambda : public Function {
   virtual stdstr rtti() const { return "UserFunc"; }
 
   static d::DValue make(cstdstr& name,
-                        StrVec& pms, d::DAst body) {
-    return WRAP_VAL(Lambda, name,pms,body);
+                        StrVec& pms, d::DAst body, d::DTable scope) {
+    return WRAP_VAL(Lambda, name,pms,body,scope);
   }
 
   virtual stdstr pr_str(bool p=0) const;
@@ -109,40 +109,84 @@ struct Lambda : public Function {
 
   StrVec params;
   d::DAst body;
-  Lambda(cstdstr&, StrVec&, d::DAst);
+  d::DTable scope;
+  Lambda(cstdstr&, StrVec&, d::DAst, d::DTable);
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// DIM'ed, held flat by what the name says the elements are,
+// int64 for %, float64 for ! and #, strings for $.  A plain name
+// holds int64 until a real is stored, then all of it float64.
+//
+// Subscripts go from 0 to the DIM'ed bound, the first varies the
+// fastest, see at().
 struct BArray : public d::Data {
 
   virtual stdstr rtti() const { return "Array"; }
 
-  static d::DValue make(const IntVec& v) {
-    return WRAP_VAL(BArray,v);
+  static d::DValue make(cstdstr& name, const IntVec& v) {
+    return WRAP_VAL(BArray,name,v);
   }
 
   static d::DValue make() {
     return WRAP_VAL(BArray);
   }
 
-  d::DValue set(d::VSlice, d::DValue);
-  d::DValue get(d::VSlice);
+  // the element at pos, from summing at() over the subscripts
+  d::Value load(llong pos) const {
+    return kind == INTS ? d::Value::of(ints[pos])
+           : kind == REALS ? d::Value::of(reals[pos]) : d::Value(strs[pos]);
+  }
+  void store(llong pos, const d::Value&);
+
+  // the part of an element's position down to one subscript,
+  // a negative one wraps, so one compare checks both ends
+  llong at(int dim, const d::Value& v) const {
+    if (v.isInt() &&
+        (uint64_t) v.n < (uint64_t) ranges[dim]) { return v.n * strides[dim]; }
+    badIndex(dim, v);
+    return 0;
+  }
+
+  int dims() const { return ranges.size(); }
+  // elements along a dim, the 0th included
+  int range(int dim) const { return ranges[dim]; }
+  llong size() const { return len; }
+
+  // the storage, for MAT, see mat.h
+  bool isInts() const { return kind == INTS; }
+  bool isReals() const { return kind == REALS; }
+  llong* intData() { return ints.data(); }
+  double* realData() { return reals.data(); }
+  // a plain name's ints as reals, false if the name says ints
+  bool toReals();
+  // DIM'ed again, all of it zeroed
+  void reshape(const IntVec&);
 
   virtual stdstr pr_str(bool p=0) const;
   virtual int compare(d::DValue) const;
   virtual bool equals(d::DValue) const;
 
   // internal use only
-  BArray() { value=P_NIL;}
-  virtual ~BArray();
+  BArray() {}
+  virtual ~BArray() {}
 
   protected:
 
-  BArray(const IntVec&);
-  int index(d::VSlice);
+  enum { INTS, REALS, STRS };
 
-  d::ValVec* value;
+  BArray(cstdstr&, const IntVec&);
+  void badIndex(int dim, const d::Value&) const;
+
+  int kind=INTS;
+  // a plain name, ints until a real comes along
+  bool loose=false;
+  llong len=0;
   IntVec ranges;
+  LongVec strides;
+  LongVec ints;
+  std::vector<double> reals;
+  d::ValVec strs;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -184,9 +228,11 @@ struct ForLoopInfo {
 
   int beginOffset, endOffset;
   int begin, end;
+  // where the FOR and the NEXT are in the program's statements
+  int beginAt, endAt;
   stdstr var;
-  d::DValue init;
-  d::DValue step;
+  // set by the first pass, until the loop is done
+  bool on;
   DslFLInfo outer;
 
   private:
@@ -195,6 +241,8 @@ struct ForLoopInfo {
     var=v; begin=n; end=0;
     beginOffset=p;
     endOffset=0;
+    beginAt=endAt=0;
+    on=false;
   }
 
 };
@@ -206,7 +254,14 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer {
   virtual d::DValue setValueEx(cstdstr&, d::DValue);
   virtual d::DValue setValue(cstdstr&, d::DValue);
   virtual d::DValue getValue(cstdstr&) const;
+  virtual d::DValue setValue(const d::LexAddr&, d::DValue);
+  virtual d::DValue getValue(const d::LexAddr&) const;
+  virtual d::DValue getValue(cstdstr&, d::NameCache&) const;
+  virtual d::DValue setValue(cstdstr&, d::DValue, d::NameCache&);
+  virtual d::Value load(const d::LexAddr&) const;
+  virtual void store(const d::LexAddr&, const d::Value&);
   virtual d::DFrame pushFrame(cstdstr&);
+  virtual d::DFrame pushFrame(cstdstr&, d::DTable, d::DFrame);
   virtual d::DFrame popFrame();
   virtual d::DFrame peekFrame() const;
 
@@ -224,6 +279,7 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer {
   virtual d::DTable pushScope(cstdstr&);
   virtual d::DTable popScope();
   virtual d::DSymbol define(d::DSymbol);
+  virtual d::LexAddr resolve(cstdstr&) const;
 
   void install(const std::map<int,int>&);
   void uninstall();
@@ -240,22 +296,26 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer {
   void halt() { running =false; }
   bool isOn() const { return running; }
 
-  int jumpSub(int target, int from, int pos);
-  int retSub();
-  int jumpFor(DslFLInfo);
-  int endFor(DslFLInfo);
-  int jump(int line);
-
-  int poffset() { auto p= progOffset; progOffset=0; return p;}
-  int pc() const { return progCounter; };
-  int incr_pc() { return ++progCounter; }
+  // the program runs off one table of statements, see Program,
+  // and a jump is to an index in it.  A literal line is looked up
+  // once, by at() when analyzed, anything else as it runs.
+  int at(int line) const;
+  void jumpTo(int pos) { progCounter=pos; }
+  void jumpSubTo(int pos);
+  void jumpSub(int line);
+  void jump(int line);
+  void retSub();
+  void endFor(DslFLInfo);
+
+  // the statement running, and the one to run
+  int pc() const { return progCounter-1; }
+  int next() { return progCounter++; }
 
   DslFLInfo getCurForLoop() const { return forLoop; }
-  DslFLInfo getForLoop(int c, int offset) const;
 
   // used during analysis
-  void xrefForNext(cstdstr&, int n, int pos);
-  void xrefForNext(int n, int pos);
+  DslFLInfo xrefForNext(cstdstr&, int n, int pos);
+  DslFLInfo xrefForNext(int n, int pos);
   void addForLoop(DslFLInfo);
 
   //void addr(d::Addr m) { curMark=m; }
@@ -263,14 +323,13 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer {
 
   Basic(const Tchar* src) : source(src) {}
   d::DValue interpret();
+  // node counts around constant folding
+  d::FoldCounts folded;
   virtual ~Basic() {}
 
   private:
 
-  std::map<stdstr,DslFLInfo> forBegins;
-  std::map<stdstr,DslFLInfo> forEnds;
-
-  std::stack<CheckPt> gosubReturns;
+  std::stack<int> gosubReturns;
   std::map<int,int> lines;
 
   std::map<stdstr,d::DValue> defs;
@@ -283,9 +342,9 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer {
   DslFLInfo forLoop;
   bool running=0;
   int progCounter=0;
-  int progOffset=0;
 
   d::DFrame stack;
+  std::stack<d::DFrame> callers;
   d::DTable symbols;
   void init_lambdas();
   void check(d::DAst);
@@ -297,7 +356,9 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer {
 d::DValue expected(cstdstr&, d::DValue, d::Addr);
 d::DValue expected(cstdstr&, d::DValue);
 d::DValue op_math(d::DValue, int op, d::DValue);
+d::Value op_math(const d::Value&, int op, const d::Value&);
 void ensure_data_type(cstdstr&, d::DValue);
+void ensure_data_type(cstdstr&, const d::Value&);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 template <typename T>
@@ -321,6 +382,12 @@ T* vcast(d::DValue v, d::Addr mark) {
   return P_NIL;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+inline const d::Value& vnum(const d::Value& v, d::Addr mark) {
+  if (!v.isNumber()) { vcast<d::Number>(v.box(), mark); }
+  return v;
+}
+
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
@@ -0,0 +1,71 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <fstream>
+#include "suite.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::bench {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Runs the suite, writes the json to out if given, and checks it
+// against a baseline if given.  Non zero if anything regressed,
+// so CI can fail the build on it.
+int bench(int runs, cstdstr& out, cstdstr& baseline, double threshold) {
+  auto res= Suite().run(runs);
+  auto js= Suite::toJson(res);
+  std::cout << Suite::table(res);
+  if (!out.empty()) {
+    std::ofstream(out) << js.dump(2) << "\n";
+  }
+  if (baseline.empty()) { return 0; }
+  std::ifstream in(baseline);
+  if (!in) {
+    std::cout << "no baseline at " << baseline << "\n";
+    return 0;
+  }
+  auto bad= Suite::compare(json::parse(in), js, threshold);
+  for (auto& x : bad) {
+    std::cout << "REGRESSION " << x << "\n";
+  }
+  return bad.empty() ? 0 : 1;
+}
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+#if 0
+void* operator new(size_t n) {
+  ++czlab::bench::_allocs;
+  if (auto p= ::malloc(n); p) { return p; }
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { ::free(p); }
+void operator delete(void* p, size_t) noexcept { ::free(p); }
+
+// bench [out.json [baseline.json [threshold]]]
+int main(int ac, char** av) {
+  return czlab::bench::bench(20,
+                             ac > 1 ? av[1] : "",
+                             ac > 2 ? av[2] : "",
+                             ac > 3 ? ::atof(av[3]) : 0.10);
+}
+#endif
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
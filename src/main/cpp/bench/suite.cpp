@@ -0,0 +1,445 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <chrono>
+#include <fstream>
+#if !defined(WIN32) && !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+#include "../tiny14e/interpreter.h"
+#include "../spi/interpreter.h"
+#include "../basic/types.h"
+#include "../basic/parser.h"
+#include "timing.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::bench {
+namespace d= czlab::dsl;
+namespace t= czlab::tiny14e;
+namespace s= czlab::spi;
+namespace b= czlab::basic;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t _allocs=0;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+double millis(clock::time_point t) {
+  std::chrono::duration<double,std::milli> d= clock::now() - t;
+  return d.count();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Linux lets the high water mark be reset, so each pair gets its
+// own, elsewhere it is the process' peak so far.
+void resetPeak() {
+#if defined(__linux__)
+  std::ofstream f("/proc/self/clear_refs");
+  f << "5";
+#endif
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+long peakRss() {
+#if defined(__linux__)
+  std::ifstream f("/proc/self/status");
+  stdstr line;
+  while (std::getline(f, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return ::atol(line.c_str() + 6);
+    }
+  }
+#endif
+#if !defined(WIN32) && !defined(_WIN32)
+  struct rusage u;
+  ::getrusage(RUSAGE_SELF, &u);
+#if defined(__APPLE__)
+  return u.ru_maxrss / 1024;
+#else
+  return u.ru_maxrss;
+#endif
+#else
+  return 0;
+#endif
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr repeat(int n, cstdstr& s) {
+  stdstr out;
+  for (auto i=0; i < n; ++i) { out += s; }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// spi has no branches and no loops, so its loops are unrolled
+stdstr spiLoops() {
+  return "PROGRAM L;\n"
+         "VAR i, j, s : INTEGER;\n"
+         "BEGIN\n"
+         "  s := 0;\n"
+         "  i := 1;\n" +
+         repeat(30, "  j := 1;\n" +
+                    repeat(30, "  s := s + i * j;\n  j := j + 1;\n") +
+                    "  i := i + 1;\n") +
+         "END.\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+const std::vector<stdstr>& Suite::langs() {
+  static const std::vector<stdstr> v{"basic", "spi", "tiny14e", "elle", "otto"};
+  return v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::vector<Workload> Suite::workloads() {
+  std::vector<Workload> v;
+
+  // fib(15), naive
+  v.push_back(Workload{"fib", {
+    {"tiny14e",
+     "program F;\n"
+     "var r : integer;\n"
+     "procedure Fib(n : integer);\n"
+     "begin\n"
+     "  if (n < 2) r := r + n; else Fib(n - 1); Fib(n - 2); endIf;\n"
+     "end;\n"
+     "begin\n"
+     "  r := 0; Fib(15); writeLn(r);\n"
+     "end.\n"},
+    // no locals, so n is kept on a stack of our own
+    {"basic",
+     "10 DIM S(100)\n"
+     "20 P=0\n"
+     "30 R=0\n"
+     "40 N=15\n"
+     "50 GOSUB 100\n"
+     "60 PRINT R\n"
+     "70 END\n"
+     "100 IF N<2 THEN GOTO 150\n"
+     "110 P=P+1\n"
+     "115 S(P)=N\n"
+     "120 N=N-1\n"
+     "125 GOSUB 100\n"
+     "130 N=S(P)-2\n"
+     "135 GOSUB 100\n"
+     "140 P=P-1\n"
+     "145 RETURN\n"
+     "150 R=R+N\n"
+     "160 RETURN\n"},
+    {"otto",
+     "(do (defn fib [n] (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))\n"
+     "    (fib 15))\n"},
+    {"elle",
+     "(begin (define fib (lambda (n)\n"
+     "         (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2))))))\n"
+     "       (fib 15))\n"}
+  }, {{"tiny14e", "610"}, {"basic", "610"},
+      {"otto", "610"}, {"elle", "610"}}});
+
+  // sum of i*j over 30x30
+  v.push_back(Workload{"loops", {
+    {"tiny14e",
+     "program L;\n"
+     "var i, j, s : integer;\n"
+     "begin\n"
+     "  s := 0;\n"
+     "  for i := 1 30 for j := 1 30 s := s + i * j; endFor; endFor;\n"
+     "  writeLn(s);\n"
+     "end.\n"},
+    {"spi", spiLoops()},
+    {"basic",
+     "10 S=0\n"
+     "20 FOR I=1 TO 30\n"
+     "30 FOR J=1 TO 30\n"
+     "40 S=S+I*J\n"
+     "50 NEXT J\n"
+     "60 NEXT I\n"
+     "70 PRINT S\n"},
+    {"otto",
+     "(do (defn inner [i j s] (if (> j 30) s (inner i (+ j 1) (+ s (* i j)))))\n"
+     "    (defn outer [i s] (if (> i 30) s (outer (+ i 1) (inner i 1 s))))\n"
+     "    (outer 1 0))\n"},
+    {"elle",
+     "(begin (define inner (lambda (i j s)\n"
+     "         (if (> j 30) s (inner i (+ j 1) (+ s (* i j))))))\n"
+     "       (define outer (lambda (i s)\n"
+     "         (if (> i 30) s (outer (+ i 1) (inner i 1 s)))))\n"
+     "       (outer 1 0))\n"}
+  }, {{"tiny14e", "216225"}, {"spi", "216225"}, {"basic", "216225"},
+      {"otto", "216225"}, {"elle", "216225"}}});
+
+  // 100 appends to a string, tiny14e, spi and elle cannot join strings
+  v.push_back(Workload{"strings", {
+    {"basic",
+     "10 T$=\"\"\n"
+     "20 FOR I=1 TO 100\n"
+     "30 T$=T$+\"ab\"\n"
+     "40 NEXT I\n"
+     "50 PRINT LEN(T$)\n"},
+    {"otto",
+     "(do (defn build [n s] (if (== n 0) s (build (- n 1) (str s \"ab\"))))\n"
+     "    (count (build 100 \"\")))\n"}
+  }, {{"basic", "200"}, {"otto", "200"}}});
+
+  // fill a collection of 100 then walk it, tiny14e and spi have none
+  v.push_back(Workload{"collections", {
+    {"basic",
+     "10 DIM A(100)\n"
+     "20 FOR I=1 TO 100\n"
+     "30 A(I)=I\n"
+     "40 NEXT I\n"
+     "50 S=0\n"
+     "60 FOR I=1 TO 100\n"
+     "70 S=S+A(I)\n"
+     "80 NEXT I\n"
+     "90 PRINT S\n"},
+    {"otto",
+     "(do (defn fill [n v] (if (== n 0) v (fill (- n 1) (conj v n))))\n"
+     "    (defn sum [v i s] (if (== i (count v)) s (sum v (+ i 1) (+ s (nth v i)))))\n"
+     "    (sum (fill 100 []) 0 0))\n"},
+    // no car or cdr, so walked by map
+    {"elle",
+     "(begin (define fill (lambda (n l) (if (< n 1) l (fill (- n 1) (cons n l)))))\n"
+     "       (apply + (map (lambda (x) (+ x 0)) (fill 100 (list)))))\n"}
+  }, {{"basic", "5050"}, {"otto", "5050"}, {"elle", "5050"}}});
+
+  // 500 calls deep, spi cannot stop recursing
+  v.push_back(Workload{"recursion", {
+    {"tiny14e",
+     "program R;\n"
+     "var d : integer;\n"
+     "procedure Down(n : integer);\n"
+     "begin\n"
+     "  if (n > 0) d := d + 1; Down(n - 1); endIf;\n"
+     "end;\n"
+     "begin\n"
+     "  d := 0; Down(500); writeLn(d);\n"
+     "end.\n"},
+    {"basic",
+     "10 D=500\n"
+     "20 C=0\n"
+     "30 GOSUB 100\n"
+     "40 PRINT C\n"
+     "50 END\n"
+     "100 IF D=0 THEN RETURN\n"
+     "110 D=D-1\n"
+     "120 C=C+1\n"
+     "130 GOSUB 100\n"
+     "140 RETURN\n"},
+    {"otto",
+     "(do (defn down [n] (if (== n 0) 0 (+ 1 (down (- n 1)))))\n"
+     "    (down 500))\n"},
+    {"elle",
+     "(begin (define down (lambda (n) (if (< n 1) 0 (+ 1 (down (- n 1))))))\n"
+     "       (down 500))\n"}
+  }, {{"tiny14e", "500"}, {"basic", "500"},
+      {"otto", "500"}, {"elle", "500"}}});
+
+  // 100 closures made and called, only the lisps have them
+  v.push_back(Workload{"closures", {
+    {"otto",
+     "(do (defn adder [n] (fn [x] (+ x n)))\n"
+     "    (defn mk [n s] (if (== n 0) s (mk (- n 1) (+ s ((adder n) 1)))))\n"
+     "    (mk 100 0))\n"},
+    {"elle",
+     "(begin (define adder (lambda (n) (lambda (x) (+ x n))))\n"
+     "       (define mk (lambda (n s)\n"
+     "         (if (< n 1) s (mk (- n 1) (+ s ((adder n) 1))))))\n"
+     "       (mk 100 0))\n"}
+  }, {{"otto", "5150"}, {"elle", "5150"}}});
+
+  return v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the interpreters parse inside interpret(), so the parser is
+// timed on its own first and its share taken off
+template<typename P, typename F>
+Timing timed(cstdstr& src, F interpret) {
+  Timing r;
+  auto t= clock::now();
+  P(src.c_str()).parse();
+  r.parse= millis(t);
+  d::Isolate iso("");
+  d::IsolateScope bind(&iso);
+  auto n= _allocs;
+  t= clock::now();
+  interpret();
+  r.total= millis(t);
+  r.allocs= _allocs - n;
+  r.output= iso.output();
+  return r;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Timing once(cstdstr& lang, cstdstr& src) {
+  if (lang == "tiny14e") {
+    return timed<t::CrenshawParser>(src, [&src]() {
+      t::Interpreter(src.c_str(), true).interpret(); });
+  }
+  if (lang == "spi") {
+    return timed<s::SimplePascalParser>(src, [&src]() {
+      s::Interpreter(src.c_str(), true).interpret(); });
+  }
+  if (lang == "basic") {
+    return timed<b::BasicParser>(src, [&src]() {
+      b::Basic(src.c_str()).interpret(); });
+  }
+  if (lang == "otto") {
+    return timeOtto(src);
+  }
+  if (lang == "elle") {
+    return timeElle(src);
+  }
+  RAISE(d::BadArg, "Unknown language %s", C_STR(lang));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Result Suite::run(const Workload& w, cstdstr& lang, int runs) {
+  Result r;
+  r.lang= lang;
+  r.workload= w.name;
+  auto src= w.source.find(lang);
+  if (src == w.source.end()) {
+    r.skipped=true;
+    return r;
+  }
+  resetPeak();
+  try {
+    // the first run checks the answer and warms up
+    auto x= once(lang, src->second);
+    auto want= w.expect.find(lang);
+    r.ok= want == w.expect.end() ||
+          x.output.find(want->second) != stdstr::npos;
+    if (!r.ok) { r.error= "unexpected output: " + x.output; }
+    double parse=0, total=0;
+    size_t allocs=0;
+    for (auto i=0; i < runs; ++i) {
+      x= once(lang, src->second);
+      parse += x.parse;
+      total += x.total;
+      allocs += x.allocs;
+    }
+    r.runs=runs;
+    r.parseMs= parse / runs;
+    r.evalMs= (total - parse) / runs;
+    r.allocs= (double) allocs / runs;
+    r.opsPerSec= total > 0 ? runs * 1000.0 / total : 0;
+  } catch (const a::Error& e) {
+    r.ok=false;
+    r.error= e.what();
+  } catch (const std::exception& e) {
+    r.ok=false;
+    r.error= e.what();
+  }
+  r.peakRssKB= peakRss();
+  return r;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::vector<Result> Suite::run(int runs) {
+  std::vector<Result> out;
+  for (auto& w : workloads()) {
+    for (auto& lang : langs()) {
+      s__conj(out, run(w, lang, runs));
+    }
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+json Suite::toJson(const std::vector<Result>& v) {
+  json out= json::object();
+  out["version"]= 1;
+  out["results"]= json::array();
+  for (auto& r : v) {
+    json x= {{"lang", r.lang}, {"workload", r.workload}};
+    if (r.skipped) {
+      x["skipped"]=true;
+    } else {
+      x["ok"]= r.ok;
+      if (!r.error.empty()) { x["error"]= r.error; }
+      x["runs"]= r.runs;
+      x["ops_per_sec"]= r.opsPerSec;
+      x["parse_ms"]= r.parseMs;
+      x["eval_ms"]= r.evalMs;
+      x["allocs"]= r.allocs;
+      x["peak_rss_kb"]= r.peakRssKB;
+    }
+    out["results"].push_back(x);
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Suite::table(const std::vector<Result>& v) {
+  char buf[160];
+  ::snprintf(buf, sizeof(buf), "%-12s %-8s %12s %10s %10s %10s %10s\n",
+             "workload", "lang", "ops/sec",
+             "parse ms", "eval ms", "allocs", "rss KB");
+  stdstr out(buf);
+  for (auto& r : v) {
+    if (r.skipped) {
+      ::snprintf(buf, sizeof(buf), "%-12s %-8s %12s\n",
+                 C_STR(r.workload), C_STR(r.lang), "-");
+    } else if (!r.ok) {
+      ::snprintf(buf, sizeof(buf), "%-12s %-8s %12s %s\n",
+                 C_STR(r.workload), C_STR(r.lang), "FAIL", C_STR(r.error));
+    } else {
+      ::snprintf(buf, sizeof(buf),
+                 "%-12s %-8s %12.1f %10.3f %10.3f %10.0f %10ld\n",
+                 C_STR(r.workload), C_STR(r.lang), r.opsPerSec,
+                 r.parseMs, r.evalMs, r.allocs, r.peakRssKB);
+    }
+    out += buf;
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+StrVec Suite::compare(const json& base, const json& now, double threshold) {
+  std::map<stdstr,json> old;
+  StrVec out;
+  for (auto& x : base.value("results", json::array())) {
+    old[x.value("workload", "") + "/" + x.value("lang", "")]= x;
+  }
+  for (auto& x : now.value("results", json::array())) {
+    auto k= x.value("workload", "") + "/" + x.value("lang", "");
+    auto i= old.find(k);
+    if (i == old.end() ||
+        x.value("skipped", false) ||
+        i->second.value("skipped", false)) { continue; }
+    auto& b= i->second;
+    if (b.value("ok", false) && !x.value("ok", false)) {
+      s__conj(out, k + " now fails: " + x.value("error", ""));
+      continue;
+    }
+    auto was= b.value("ops_per_sec", 0.0);
+    auto is= x.value("ops_per_sec", 0.0);
+    if (was > 0 && is < was * (1 - threshold)) {
+      char buf[160];
+      ::snprintf(buf, sizeof(buf), "%s %.1f -> %.1f ops/sec (%.1f%%)",
+                 C_STR(k), was, is, (is - was) * 100 / was);
+      s__conj(out, stdstr(buf));
+    }
+  }
+  return out;
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
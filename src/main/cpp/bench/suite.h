@@ -0,0 +1,91 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <map>
+#include "../nlohmann/json.hpp"
+#include "../aeon/aeon.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::bench {
+namespace a= czlab::aeon;
+using json= nlohmann::json;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// One program written in every language that can say it, with
+// what it must print.  A language missing the construct has no
+// entry and shows up as skipped, so the matrix stays whole.
+struct Workload {
+  stdstr name;
+  // lang -> source
+  std::map<stdstr,stdstr> source;
+  // lang -> output, the printed result for the lisps
+  std::map<stdstr,stdstr> expect;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// An op is one whole run of the workload, parse included.
+struct Result {
+  stdstr lang;
+  stdstr workload;
+  bool skipped=false;
+  // printed what was expected
+  bool ok=false;
+  stdstr error;
+  int runs=0;
+  double opsPerSec=0;
+  // per run, eval is the rest of the run after the parse
+  double parseMs=0;
+  double evalMs=0;
+  double allocs=0;
+  // high water mark of the process over the runs, in KB
+  long peakRssKB=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// bumped by an operator new, if the program has one, see bench.cpp
+extern size_t _allocs;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Suite {
+
+  // basic, spi, tiny14e, elle and otto
+  static const std::vector<stdstr>& langs();
+  static std::vector<Workload> workloads();
+
+  // every workload in every language, each run 'runs' times
+  std::vector<Result> run(int runs);
+  Result run(const Workload&, cstdstr& lang, int runs);
+
+  static json toJson(const std::vector<Result>&);
+  static stdstr table(const std::vector<Result>&);
+
+  // a line per pair that got slower than base by more than
+  // threshold, a fraction, or stopped printing the right thing
+  static StrVec compare(const json& base,
+                        const json& now, double threshold);
+
+  Suite() {}
+  ~Suite() {}
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,74 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include "../dsl/isolate.h"
+#include "suite.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::bench {
+namespace d= czlab::dsl;
+using clock= std::chrono::steady_clock;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Shared by the runners.  otto and elle each run from a file of
+// their own, their headers define the same value macros.
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+double millis(clock::time_point);
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Times for one run, the output is what was printed, or for
+// the lisps the printed value.
+struct Timing {
+  double parse=0;
+  double total=0;
+  size_t allocs=0;
+  stdstr output;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// READ then EVAL, the root env is made outside the clock
+template<typename L>
+Timing timedLisp(cstdstr& src, d::DFrame env) {
+  Timing r;
+  L lisp;
+  d::Isolate iso("");
+  d::IsolateScope bind(&iso);
+  auto n= _allocs;
+  auto t= clock::now();
+  auto form= lisp.READ(src);
+  r.parse= millis(t);
+  auto v= lisp.EVAL(form.second, env);
+  r.total= millis(t);
+  r.allocs= _allocs - n;
+  r.output= iso.output() + lisp.PRINT(v);
+  return r;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// see otto.cpp and elle.cpp
+Timing timeOtto(cstdstr& src);
+Timing timeElle(cstdstr& src);
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,409 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <cstring>
+#include <typeinfo>
+#include <fstream>
+#include <thread>
+#if defined(WIN32) || defined(_WIN32)
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "cache.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+namespace a=czlab::aeon;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// The file is host order and host sized, it never leaves the box.
+//
+//  "DSLC" version key#protos, then per proto:
+//  name nslots nregs params# calls# code# consts# names#
+//  where a const is a tag then its payload, and names are the
+//  scope's slots in slot order, so the table can be laid out again.
+//  Last comes the FNV-1a of everything before it.
+const char MAGIC[4]= {'D','S','L','C'};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+uint64_t fnv1a(uint64_t h, const void* p, size_t n) {
+  auto b= (const unsigned char*) p;
+  for (size_t i=0; i < n; ++i) {
+    h= (h ^ b[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+const uint64_t FNV_BASIS= 14695981039346656037ULL;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the file as one read only block, mapped where we can
+struct Mapped {
+
+  Mapped(cstdstr& path) {
+#if defined(WIN32) || defined(_WIN32)
+    std::ifstream in(path, std::ios::binary);
+    if (in) {
+      buf.assign(std::istreambuf_iterator<char>(in),
+                 std::istreambuf_iterator<char>());
+      data= buf.data();
+      size= buf.size();
+    }
+#else
+    auto fd= ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0) { return; }
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      auto p= ::mmap(P_NIL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        data= (const char*) p;
+        size= st.st_size;
+      }
+    }
+    ::close(fd);
+#endif
+  }
+
+  ~Mapped() {
+#if !defined(WIN32) && !defined(_WIN32)
+    if (data) { ::munmap((void*) data, size); }
+#endif
+  }
+
+  const char* data=P_NIL;
+  size_t size=0;
+
+  private:
+
+  std::vector<char> buf;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// reads stop, and stay stopped, at the first short field
+struct Reader {
+
+  template<typename T>
+  T get() {
+    T v{};
+    if (more(sizeof(T))) {
+      ::memcpy(&v, pos, sizeof(T));
+      pos += sizeof(T);
+    }
+    return v;
+  }
+
+  stdstr str() {
+    auto n= get<uint32_t>();
+    if (!more(n)) { return ""; }
+    stdstr s(pos, n);
+    pos += n;
+    return s;
+  }
+
+  // a count, checked against what is left of the file
+  uint32_t count(size_t each) {
+    auto n= get<uint32_t>();
+    if (!more((size_t) n * each)) { n=0; }
+    return n;
+  }
+
+  bool more(size_t n) {
+    if (ok && (size_t)(end-pos) < n) { ok=false; }
+    return ok;
+  }
+
+  Reader(const char* p, size_t n) : pos(p), end(p+n) {}
+
+  const char* pos;
+  const char* end;
+  bool ok=true;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Writer {
+
+  template<typename T>
+  void put(const T& v) {
+    out.append((const char*) &v, sizeof(T));
+  }
+
+  void str(cstdstr& s) {
+    put((uint32_t) s.size());
+    out.append(s);
+  }
+
+  stdstr out;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool writeConst(Writer& w, const Value& v) {
+  w.put((uint8_t) v.tag);
+  switch (v.tag) {
+    case V_NIL: break;
+    case V_REAL: w.put(v.r); break;
+    case V_BOOL: case V_CHAR: case V_INT: w.put(v.n); break;
+    case V_OBJ:
+      if (v.heap && typeid(*v.heap) == typeid(String)) {
+        w.str(DCAST(String, v.heap)->impl());
+        break;
+      }
+      return false;
+  }
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value readConst(Reader& r) {
+  switch (r.get<uint8_t>()) {
+    case V_NIL: return Value();
+    case V_REAL: return Value::of(r.get<double>());
+    case V_INT: return Value::of(r.get<llong>());
+    case V_BOOL: return Value::of(r.get<llong>() != 0);
+    case V_CHAR: return Value::ofChar((Tchar) r.get<llong>());
+    case V_OBJ: return Value(String::make(r.str()));
+  }
+  r.ok=false;
+  return Value();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool checkCode(const std::vector<Proto>& ps, int p,
+               const std::vector<int>& level,
+               const std::vector<int>& slots) {
+  auto& q= ps[p];
+  auto np= (int) ps.size();
+  auto n= (int) q.code.size();
+  auto reg= [&q](int r) { return r >= 0 && r < q.nregs; };
+  auto to= [n](int c) { return c >= 0 && c < n; };
+  for (auto& i : q.code) {
+    auto ok=true;
+    switch (i.op) {
+      case OP_NOP: case OP_RET: case OP_FLUSH: break;
+      case OP_NIL: case OP_PUT: case OP_READ: case OP_LOADI:
+        ok= reg(i.a); break;
+      case OP_LOADK:
+        ok= reg(i.a) && i.b >= 0 && i.b < (int) q.consts.size(); break;
+      case OP_GETUP: case OP_SETUP:
+        // the frame b hops out is the declaring one at that level
+        ok= reg(i.a) && i.b >= 0 && i.b <= level[p] &&
+            i.c >= 0 && i.c < slots[level[p] - i.b];
+        break;
+      case OP_MOVE: case OP_ADDKI: case OP_NEGI: case OP_NEGR:
+      case OP_I2R: case OP_R2I: case OP_NEG: case OP_NUM:
+      case OP_NOT: case OP_TRUTH:
+        ok= reg(i.a) && reg(i.b); break;
+      case OP_BLTI: case OP_BLEI: case OP_BEQI: case OP_BNEI:
+      case OP_BLTR: case OP_BLER: case OP_BEQR: case OP_BNER:
+        ok= reg(i.a) && reg(i.b) && to(i.c); break;
+      case OP_JMP: ok= to(i.c); break;
+      case OP_JT: case OP_JF: ok= reg(i.a) && to(i.c); break;
+      case OP_CALL:
+        ok= i.a >= 0 && i.a < (int) q.calls.size(); break;
+      default:
+        // the three register ops
+        ok= i.op > OP_NOP && i.op < OP_END &&
+            reg(i.a) && reg(i.b) && reg(i.c);
+        break;
+    }
+    if (!ok) { return false; }
+  }
+  for (auto& s : q.calls) {
+    if (s.proto < 0 || s.proto >= np ||
+        s.argc < 0 || s.argc > (int) ps[s.proto].params.size() ||
+        s.base < 0 || s.base + s.argc > q.nregs) { return false; }
+  }
+  // every path ends in a return, the last op can't fall through
+  return n > 0 && (q.code.back().op == OP_RET || q.code.back().op == OP_JMP);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the code only touches its own frame, constants and protos,
+// and the frames its nesting says are there
+bool validate(const std::vector<Proto>& ps) {
+  auto np= (int) ps.size();
+  if (np == 0) { return false; }
+  for (auto& q : ps) {
+    if (q.nslots < 0 || q.nslots > q.nregs ||
+        (int) q.scope->size() != q.nslots) { return false; }
+    for (auto x : q.params) {
+      if (x < 0 || x >= q.nslots) { return false; }
+    }
+  }
+  // the nesting level of each proto, from the call sites, a call
+  // depth hops out lands in the frame one level above the callee
+  std::vector<int> level(np, -1);
+  std::vector<int> todo{0};
+  level[0]=0;
+  while (!todo.empty()) {
+    auto p= todo.back();
+    todo.pop_back();
+    for (auto& s : ps[p].calls) {
+      if (s.proto < 0 || s.proto >= np ||
+          s.depth < 0 || s.depth > level[p]) { return false; }
+      auto v= level[p] - s.depth + 1;
+      if (level[s.proto] < 0) {
+        level[s.proto]= v;
+        s__conj(todo, s.proto);
+      } else if (level[s.proto] != v) {
+        return false;
+      }
+    }
+  }
+  // the most slots a frame at each level can have
+  std::vector<int> slots(np, 0);
+  for (auto p=0; p < np; ++p) {
+    if (level[p] < 0) { return false; }
+    slots[level[p]]= std::max(slots[level[p]], ps[p].nslots);
+  }
+  for (auto p=0; p < np; ++p) {
+    if (!checkCode(ps, p, level, slots)) { return false; }
+  }
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr ProgramCache::key(cstdstr& lang, const Tchar* src) {
+  auto h= fnv1a(FNV_BASIS, &BYTECODE_VERSION, sizeof(BYTECODE_VERSION));
+  h= fnv1a(h, lang.data(), lang.size());
+  for (; *src; ++src) { h= fnv1a(h, src, sizeof(Tchar)); }
+  char buf[24];
+  ::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long) h);
+  return lang + "-" + buf;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr ProgramCache::path(cstdstr& key) const {
+  return dir + "/" + key + ".dslc";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool ProgramCache::load(cstdstr& key, std::vector<Proto>& out) const {
+  out.clear();
+  if (!on()) { return false; }
+  Mapped m(path(key));
+  uint64_t sum;
+  if (!m.data || m.size < sizeof(MAGIC) + sizeof(sum) ||
+      ::memcmp(m.data, MAGIC, sizeof(MAGIC)) != 0) {
+    return false;
+  }
+  auto body= m.size - sizeof(sum);
+  ::memcpy(&sum, m.data + body, sizeof(sum));
+  if (fnv1a(FNV_BASIS, m.data, body) != sum) {
+    return false;
+  }
+  Reader r(m.data + sizeof(MAGIC), body - sizeof(MAGIC));
+  if (r.get<uint32_t>() != BYTECODE_VERSION || r.str() != key) {
+    return false;
+  }
+  auto np= r.count(1);
+  out.resize(np);
+  for (auto& p : out) {
+    p.name= r.str();
+    p.nslots= r.get<int>();
+    p.nregs= r.get<int>();
+    p.params.resize(r.count(sizeof(int)));
+    for (auto& x : p.params) { x= r.get<int>(); }
+    p.calls.resize(r.count(sizeof(CallSite)));
+    if (!p.calls.empty()) {
+      ::memcpy(p.calls.data(), r.pos, p.calls.size() * sizeof(CallSite));
+      r.pos += p.calls.size() * sizeof(CallSite);
+    }
+    p.code.resize(r.count(sizeof(Instr)));
+    if (!p.code.empty()) {
+      ::memcpy(p.code.data(), r.pos, p.code.size() * sizeof(Instr));
+      r.pos += p.code.size() * sizeof(Instr);
+    }
+    p.consts.resize(r.count(1));
+    for (auto& x : p.consts) { x= readConst(r); }
+    p.scope= Table::make(p.name);
+    for (auto i= r.count(sizeof(uint32_t)); i > 0; --i) {
+      p.scope->insert(Symbol::make(r.str()));
+    }
+    if (!r.ok) { break; }
+  }
+  // a truncated, torn or bad file, compile again
+  if (!r.ok || r.pos != r.end || !validate(out)) {
+    out.clear();
+    return false;
+  }
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool ProgramCache::save(cstdstr& key, const std::vector<Proto>& protos) const {
+  if (!on()) { return false; }
+  Writer w;
+  w.out.append(MAGIC, sizeof(MAGIC));
+  w.put(BYTECODE_VERSION);
+  w.str(key);
+  w.put((uint32_t) protos.size());
+  for (auto& p : protos) {
+    w.str(p.name);
+    w.put(p.nslots);
+    w.put(p.nregs);
+    w.put((uint32_t) p.params.size());
+    for (auto x : p.params) { w.put(x); }
+    w.put((uint32_t) p.calls.size());
+    for (auto& x : p.calls) { w.put(x); }
+    w.put((uint32_t) p.code.size());
+    for (auto& x : p.code) { w.put(x); }
+    w.put((uint32_t) p.consts.size());
+    for (auto& x : p.consts) {
+      if (!writeConst(w, x)) { return false; }
+    }
+    // slot names in slot order
+    StrVec names;
+    if (p.scope) {
+      names.resize(p.scope->size());
+      for (auto& x : p.scope->layout()) { names[x.second]= x.first; }
+    }
+    w.put((uint32_t) names.size());
+    for (auto& x : names) { w.str(x); }
+  }
+  w.put(fnv1a(FNV_BASIS, w.out.data(), w.out.size()));
+#if defined(WIN32) || defined(_WIN32)
+  ::_mkdir(dir.c_str());
+  auto tmp= path(key) + "." + N_STR(::_getpid());
+#else
+  ::mkdir(dir.c_str(), 0755);
+  auto tmp= path(key) + "." + N_STR(::getpid());
+#endif
+  // isolates on other threads may be saving the same key
+  tmp += "." + N_STR(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f.write(w.out.data(), w.out.size())) {
+      ::remove(tmp.c_str());
+      return false;
+    }
+  }
+  if (::rename(tmp.c_str(), path(key).c_str()) != 0) {
+    ::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,66 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include "vm.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Bump this whenever the opcodes or the Proto layout change,
+// old cache files then simply miss.
+constexpr uint32_t BYTECODE_VERSION= 2;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Compiled programs on disk, one file per source, so a rerun of
+// the same script skips lexing, parsing, analysis and compiling.
+//
+// A file is named after the key, and holds the key again with the
+// version, so a stale or foreign file is a miss, never an error.
+// So is a file failing its checksum, or whose code would reach
+// outside its frame, constants or protos.
+// It is written to a temp file then renamed, concurrent runs of
+// one script at worst both compile it.
+struct ProgramCache {
+
+  // FNV-1a of the language and source, mixed with the version
+  static stdstr key(cstdstr& lang, const Tchar* src);
+
+  // false on a miss, protos are left empty then
+  bool load(cstdstr& key, std::vector<Proto>&) const;
+  // false if the protos hold a constant that cannot be written
+  bool save(cstdstr& key, const std::vector<Proto>&) const;
+
+  // an empty dir turns the cache off
+  bool on() const { return !dir.empty(); }
+
+  ProgramCache(cstdstr& dir) : dir(dir) {}
+  ~ProgramCache() {}
+
+  private:
+
+  stdstr path(cstdstr& key) const;
+  stdstr dir;
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
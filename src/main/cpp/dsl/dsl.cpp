@@ -12,15 +12,25 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include <cerrno>
+#include <cmath>
+#include <cstring>
 #include <typeinfo>
+#include <typeindex>
+#if defined(WIN32) || defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #include "dsl.h"
+#include "gc.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::dsl {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace a=czlab::aeon;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-std::map<int, stdstr> I_TOKENS {
+constexpr Keyword I_TOKENS[] {
   {T_INT, "long"},
   {T_REAL, "double"},
   {T_STRING, "string"},
@@ -56,11 +66,11 @@ std::map<int, stdstr> I_TOKENS {
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-auto S_TOKENS=a::map_reflect(I_TOKENS);
+constexpr KeywordTable S_TOKENS(I_TOKENS);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-const std::map<stdstr,int>& getStrTokens() { return S_TOKENS; }
-const std::map<int,stdstr>& getIntTokens() { return I_TOKENS; }
+int tokenType(std::string_view s) { return S_TOKENS.find(s); }
+std::string_view tokenName(int t) { return S_TOKENS.name(t); }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool is_same(const Data* x, const Data* y) {
@@ -73,6 +83,28 @@ bool is_same(DValue x, const Data* y) {
     return typeid(*p) == typeid(*y); else return false;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// stable for the run, which is all sorting needs
+int compare_types(const Data* x, const Data* y) {
+  if (!y) { return 1; }
+  std::type_index a(typeid(*x)), b(typeid(*y));
+  return a == b ? 0 : (a < b ? -1 : 1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t hash_combine(size_t seed, size_t h) {
+  return seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// rounded to 1e-12, so (+ 0.1 0.2) and 0.3 key alike.  Past 4096
+// the reals are about as far apart as the grid, and are kept.
+double real_key(double r) {
+  if (!(::fabs(r) < 4096.0)) { return r; }
+  auto k= ::round(r * 1e12);
+  return k == 0 ? 0.0 : k / 1e12;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int preEqual(int wanted, int got, cstdstr& fn) {
   if (wanted != got)
@@ -147,6 +179,39 @@ stdstr escape(cstdstr& src) {
 }
 
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// char classes, one lookup instead of the ctype calls
+enum { C_SPACE=1, C_DIGIT=2 };
+static const std::array<unsigned char,256> CTYPES= []() {
+  std::array<unsigned char,256> t {};
+  for (auto i=0; i < 256; ++i) {
+    if (::isspace(i)) { t[i] |= C_SPACE; }
+    if (::isdigit(i)) { t[i] |= C_DIGIT; }
+  }
+  return t;
+}();
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static bool is_class(Tchar ch, int c) {
+  return CTYPES[(unsigned char) ch] & c;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// first position from p not in class c
+static int span(Context& ctx, int p, int c) {
+  while (ctx.has(p) && is_class(ctx.src[p], c)) { ++p; }
+  return p;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static void moveTo(Context& ctx, int p) {
+  if (!ctx.has(p)) {
+    ctx.pos= ctx.len;
+    ctx.eof=true; }
+  else {
+    ctx.pos=p; }
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Tchar peek(Context& ctx) {
   return ctx.eof ? '\0' : ctx.src[ctx.pos];
@@ -160,19 +225,15 @@ Tchar pop(Context& ctx) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool peekPattern(Context& ctx, cstdstr& pattern) {
-  auto pos=0;
-  for (auto& x : pattern) {
-    if (peekAhead(ctx,pos)!=x)
-    break; else ++pos;
-  }
-  return pos==pattern.size();
+  return ctx.has(ctx.pos + pattern.size() - 1) &&
+         ::memcmp(ctx.src + ctx.pos, pattern.data(), pattern.size()) == 0;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 // Peek into the buffer and see what's ahead.
 Tchar peekAhead(Context& ctx, int offset) {
   auto nx = ctx.pos + offset;
-  return nx >= 0 && nx < ctx.len ? ctx.src[nx] : '\0';
+  return nx >= 0 && ctx.has(nx) ? ctx.src[nx] : '\0';
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -184,26 +245,16 @@ stdstr pr_addr(Addr m) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool forward(Context& ctx) {
-  // move up one char, handling newline.
+  // move up one char.
   if (ctx.eof) { return false; }
-
-  if (peek(ctx) == '\n') {
-    ++ctx.line;
-    ctx.col=0; }
-
-  ++ctx.pos;
-
-  if (ctx.pos >= ctx.len) {
-    ctx.eof=true; }
-  else {
-    ++ctx.col; }
-
+  moveTo(ctx, ctx.pos+1);
   return !ctx.eof;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool advance(Context& ctx, int steps) {
-  for (auto i=0; i < steps; ++i) { forward(ctx); }
+  if (ctx.eof) { return false; }
+  moveTo(ctx, ctx.pos+steps);
   return !ctx.eof;
 }
 
@@ -215,18 +266,18 @@ Addr mark_advance(Context& ctx, int steps) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void skipWhitespace(Context& ctx) {
-  while (!ctx.eof &&
-         ::isspace(peek(ctx))) advance(ctx);
+  if (!ctx.eof) { moveTo(ctx, span(ctx, ctx.pos, C_SPACE)); }
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 std::pair<stdstr,Addr> digits(Context& ctx) {
   // grab a sequence of digits
   auto m= ctx.mark();
-  stdstr res;
-  while (!ctx.eof &&
-         ::isdigit(peek(ctx))) { res += peek(ctx); advance(ctx); }
-  return s__pair(stdstr,Addr,res,m);
+  auto p= ctx.pos;
+  if (ctx.eof) { return s__pair(stdstr,Addr,"",m); }
+  auto e= span(ctx, p, C_DIGIT);
+  moveTo(ctx, e);
+  return s__pair(stdstr,Addr,stdstr(ctx.src+p, e-p),m);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -235,7 +286,7 @@ std::pair<stdstr,Addr> numeric(Context& ctx) {
   if (dot)
   { advance(ctx);
     if (ctx.eof || !::isdigit(peek(ctx)))
-      E_SYNTAX("Bad number near line %d, col %d.", ctx.line, ctx.col); }
+      E_SYNTAX("Bad number near %s.", pr_addr(ctx.mark()).c_str()); }
   auto res = digits(ctx);
   auto s= _1(res);
   if (!dot &&
@@ -252,54 +303,185 @@ std::pair<stdstr,Addr> numeric(Context& ctx) {
 std::pair<stdstr,Addr> str(Context& ctx) {
   auto m= ctx.mark();
   stdstr res;
-  auto ch= '\0';
   if (!ctx.eof &&
       peek(ctx) == '"') {
-    advance(ctx);
-    while (!ctx.eof) {
-      ch= peek(ctx);
+    // copy runs between escapes in one go
+    auto p= ctx.pos+1;
+    auto from= p;
+    for (; ctx.has(p); ++p) {
+      auto ch= ctx.src[p];
       if (ch == '"')
       break;
       if (ch == '\\') {
-        if (!advance(ctx)) {
+        res.append(ctx.src+from, p-from);
+        if (!ctx.has(++p)) {
           E_SYNTAX(
               "Bad escaped char %c near line %d, col %d.", ch, _1(m), _2(m)); }
-        ch=a::unescape_char(peek(ctx)); }
-      res += ch;
-      advance(ctx); }
+        res += a::unescape_char(ctx.src[p]);
+        from= p+1; } }
 
-    if (ctx.eof || ch != '"') {
+    if (!ctx.has(p)) {
+      moveTo(ctx, p);
       E_SYNTAX("Bad string value, missing \" near line %d, col %d.", _1(m), _2(m)); }
 
     // good, got the end dquote
-    advance(ctx);
+    res.append(ctx.src+from, p-from);
+    moveTo(ctx, p+1);
   }
 
   return s__pair(stdstr,Addr,res,m);
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::string_view identifier_view(Context& ctx, IdPredicate pred) {
+  auto p= ctx.pos;
+  auto e= p;
+
+  if (!ctx.eof && pred(ctx.src[e],1)) {
+    ++e;
+    while (ctx.has(e) && pred(ctx.src[e],0)) { ++e; }
+    moveTo(ctx, e); }
+
+  return std::string_view(ctx.src+p, e-p);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 std::pair<stdstr,Addr> identifier(Context& ctx, IdPredicate pred) {
   auto m= ctx.mark();
-  stdstr res;
+  auto v= identifier_view(ctx, pred);
+  return s__pair(stdstr,Addr,stdstr(v),m);
+}
 
-  while (!ctx.eof) {
-    auto ch=peek(ctx);
-    if (res.empty()) {
-      if (pred(ch,1)) {
-        res += ch;
-        advance(ctx); } else break; }
-    else {
-      if (pred(ch,0)) {
-        res += ch;
-        advance(ctx); } else break; } }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::string_view numeric_view(Context& ctx) {
+  // same rules as numeric(), a leading dot is not part of it
+  bool dot = peek(ctx)=='.' ;
+  if (dot)
+  { advance(ctx);
+    if (ctx.eof || !::isdigit(peek(ctx)))
+      E_SYNTAX("Bad number near %s.", pr_addr(ctx.mark()).c_str()); }
+  auto p= ctx.pos;
+  if (!ctx.eof) { moveTo(ctx, span(ctx, p, C_DIGIT)); }
+  if (!dot &&
+      !ctx.eof &&
+      peek(ctx) == '.') {
+    advance(ctx);
+    if (!ctx.eof) { moveTo(ctx, span(ctx, ctx.pos, C_DIGIT)); }
+  }
+  return std::string_view(ctx.src+p, ctx.pos-p);
+}
 
-  return s__pair(stdstr,Addr,res,m);
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t StreamSource::read(Tchar* buf, size_t n) {
+  in.read(buf, n);
+  return in.gcount();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t FileSource::read(Tchar* buf, size_t n) {
+  for (;;) {
+#if defined(WIN32) || defined(_WIN32)
+    auto r= ::_read(fd, buf, (unsigned) n);
+#else
+    auto r= ::read(fd, buf, n);
+    if (r < 0 && errno == EINTR) { continue; }
+#endif
+    return r > 0 ? (size_t) r : 0;
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+FileSource::~FileSource() {
+#if defined(WIN32) || defined(_WIN32)
+  if (owned) { ::_close(fd); }
+#else
+  if (owned) { ::close(fd); }
+#endif
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Context::Context() {
-  S_NIL(src); len=0; line=1; col=1; pos=0; eof=0; }
+  S_NIL(src); len=0; pos=0; eof=0; seen=0; lines=1; bol=0;
+  S_NIL(in); window=0; drained=0; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Context::~Context() {
+  DEL_PTR(in);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Context::open(Source* s, size_t w) {
+  DEL_PTR(in);
+  in=s;
+  window= w > 0 ? w : 1;
+  drained=false;
+  buf.clear();
+  buf.reserve(window);
+  src=buf.data(); len=0; pos=0; seen=0; lines=1; bol=0;
+  eof= !has(0);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Context::more(int p) {
+  // a token longer than the window grows the buffer, not the window
+  while (!drained && p >= (int) buf.size()) {
+    auto n= buf.size();
+    buf.resize(n + window);
+    auto got= in->read(buf.data()+n, window);
+    buf.resize(n + got);
+    if (got == 0) { drained=true; }
+  }
+  src=buf.data();
+  len=buf.size();
+  return p < (int) len;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Context::trim() {
+  // half a window read at the least, so the move is paid for
+  if (!in || pos < (int) window/2) { return; }
+  count(pos);
+  buf.erase(buf.begin(), buf.begin()+pos);
+  seen -= pos;
+  bol -= pos;
+  pos=0;
+  src=buf.data();
+  len=buf.size();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Addr Context::mark() {
+  int p= pos < (int) len ? pos : (int) len;
+  if (p < seen) {
+    // moved back, count again from the top
+    seen=0; lines=1; bol=0; }
+  count(p);
+  // at eof the col stays on the last char
+  auto c= p-bol+1;
+  return DMARK(lines, eof ? c-1 : c);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Context::count(int p) {
+  // memchr is the fast path for the newline search
+  for (auto s= src+seen, e= src+p; s < e;) {
+    auto nl= (const Tchar*) ::memchr(s, '\n', e-s);
+    if (!nl) { break; }
+    ++lines;
+    bol= nl-src+1;
+    s= nl+1; }
+  seen=p;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+thread_local llong Frame::shapes=0;
+// frames made so far on this thread
+thread_local llong frames=0;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DFrame Frame::make(cstdstr& n, DTable scope, DFrame outer) {
+  return WRAP_ENV(Frame, n, scope, outer);
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 DFrame Frame::make(cstdstr& n, DFrame outer) {
@@ -312,8 +494,40 @@ DFrame Frame::make(cstdstr& n) {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Frame::Frame(cstdstr& n, DFrame outer) : _name(n) { prev=outer; }
-Frame::Frame(cstdstr& n) : _name(n) { }
+Frame::Frame(cstdstr& n, DTable scope, DFrame outer) : Frame(n, outer) {
+  layout=scope;
+  if (scope) { vars.resize(scope->size()); }
+}
+Frame::Frame(cstdstr& n, DFrame outer) : id(++frames), _name(n) {
+  prev=outer;
+  Heap::current().link(this);
+}
+Frame::Frame(cstdstr& n) : id(++frames), _name(n) {
+  Heap::current().link(this);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Frame::~Frame() {
+  if (heap) { heap->unlink(this); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Frame::trace(Tracer& t) const {
+  t.visit(prev);
+  for (auto& v : vars) { t.visit(v.heap); }
+  for (auto& x : slots) { t.visit(x.second); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// drops everything held, which breaks the cycles it was part of
+void Frame::clear() {
+  std::vector<Value> v;
+  std::map<stdstr,DValue> m;
+  DFrame p;
+  v.swap(vars);
+  m.swap(slots);
+  p.swap(prev);
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Frame::pr_str() const {
@@ -326,6 +540,15 @@ stdstr Frame::pr_str() const {
   out += "\n";
   out += "frame: " + _name + " => ";
 
+  if (layout) {
+    for (auto& x : layout->layout()) {
+      if (x.second >= (int) vars.size()) { continue; }
+      auto v= vars[x.second].box();
+      auto vs= v ? v->pr_str(1) : stdstr("null");
+      if (!bits.empty()) bits += ", ";
+      bits += x.first + "=" + vs;
+    }
+  }
   for (auto i= slots.begin(), e= slots.end(); i != e; ++i) {
     auto v= i->second;
     auto vs= v ? v->pr_str(1) : stdstr("null");
@@ -340,6 +563,11 @@ stdstr Frame::pr_str() const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 std::set<stdstr> Frame::keys() const {
   std::set<stdstr> out;
+  if (layout) {
+    for (auto &x : layout->layout()) {
+      out.insert(x.first);
+    }
+  }
   for (auto &x : slots) {
     out.insert(x.first);
   }
@@ -349,6 +577,10 @@ std::set<stdstr> Frame::keys() const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 DValue Frame::get(cstdstr& key) const {
 
+  if (auto n= index(key); n >= 0) {
+    return get(0, n);
+  }
+
   auto x= slots.find(key);
   auto r= x != slots.end()
           ? x->second
@@ -365,6 +597,9 @@ DValue Frame::setEx(cstdstr& key, DValue v) {
 
   DEBUG("frame:setEx %s -> %s\n", C_STR(key), C_STR(v->pr_str(1)));
 
+  if (auto n= index(key); n >= 0) {
+    return set(0, n, v);
+  }
   if (s__contains(slots,key)) {
     return (slots[key]=v), v;
   } else {
@@ -375,12 +610,101 @@ DValue Frame::setEx(cstdstr& key, DValue v) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 DValue Frame::set(cstdstr& key, DValue v) {
   DEBUG("frame:set %s -> %s\n", C_STR(key), C_STR(v->pr_str(1)));
-  return (slots[key]=v), v;
+  if (auto n= index(key); n >= 0) {
+    return set(0, n, v);
+  }
+  if (slots.insert_or_assign(key, v).second) { ++shapes; }
+  return v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Frame* Frame::hop(int depth) const {
+  auto f= const_cast<Frame*>(this);
+  for (auto n=depth; n > 0; --n) {
+    // a resolved address deeper than the chain, a bad analysis
+    if (f= f->prev.get(); !f) {
+      RAISE(BadEval,
+            "No frame %d out from %s", depth, C_STR(_name));
+    }
+  }
+  return f;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DValue Frame::set(int depth, int slot, DValue v) {
+  auto f= hop(depth);
+  if (slot >= (int) f->vars.size()) {
+    // the scope grew after this frame was made
+    f->vars.resize(slot+1);
+  }
+  return (f->vars[slot]=Value(v)), v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DValue Frame::get(int depth, int slot) const {
+  auto f= hop(depth);
+  if (slot >= (int) f->vars.size()) { return DVAL_NIL; }
+  auto& v= f->vars[slot];
+  // box once, later reads share it
+  if (!v.heap) { v.heap= v.box(); }
+  return v.heap;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Frame::store(int depth, int slot, const Value& v) {
+  auto f= hop(depth);
+  if (slot >= (int) f->vars.size()) {
+    f->vars.resize(slot+1);
+  }
+  f->vars[slot]=v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Frame::load(int depth, int slot) const {
+  auto f= hop(depth);
+  return slot < (int) f->vars.size() ? f->vars[slot].bare() : Value();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Frame::resolve(cstdstr& key, NameCache& c, bool local) {
+  // the same walk as get(key), or set(key) if local
+  c.addr= LexAddr();
+  c.cell= P_NIL;
+  auto depth=0;
+  for (auto f= this; f; f= local ? P_NIL : f->prev.get(), ++depth) {
+    if (auto n= f->index(key); n >= 0) {
+      c.addr= LexAddr{depth, n};
+      break;
+    }
+    if (auto i= f->slots.find(key); i != f->slots.end()) {
+      c.cell= &i->second;
+      break;
+    }
+  }
+  if (local && !c.cell && !c.addr.ok()) {
+    c.cell= &slots[key];
+    ++shapes;
+  }
+  c.frame= id;
+  c.shape= shapes;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DValue Frame::get(cstdstr& key, NameCache& c) {
+  if (c.frame != id || c.shape != shapes) { resolve(key, c, false); }
+  return c.cell ? *c.cell
+                : (c.addr.ok() ? get(c.addr.depth, c.addr.slot) : DVAL_NIL);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DValue Frame::set(cstdstr& key, DValue v, NameCache& c) {
+  if (c.frame != id || c.shape != shapes) { resolve(key, c, true); }
+  return c.cell ? ((*c.cell=v), v) : set(0, c.addr.slot, v);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Frame::contains(cstdstr& key) const {
-  return slots.find(key) != slots.end();
+  return index(key) >= 0 || slots.find(key) != slots.end();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -396,9 +720,27 @@ DFrame Frame::getRoot(DFrame from) {
   return from->prev ? getRoot(from->prev) : from;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DFrame Frame::getOuter(DFrame from, int hops) {
+  for (; from && hops > 0; --hops) { from= from->prev; }
+  return from;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 DFrame Frame::getOuter() const { return prev; }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DValue IEvaluator::getValue(cstdstr& n, NameCache& c) const {
+  auto f= peekFrame();
+  return f ? f->get(n, c) : DVAL_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DValue IEvaluator::setValue(cstdstr& n, DValue v, NameCache& c) {
+  auto f= peekFrame();
+  return f ? f->set(n, v, c) : DVAL_NIL;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 DTable Table::make(cstdstr& n, const SymbolMap& root) {
   return DTable(new Table(n,root));
@@ -419,8 +761,34 @@ Table::Table(cstdstr& n) : _name(n) {}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Table::insert(DSymbol s) {
-  if (s)
-    symbols[s->name()] = s;
+  if (s) {
+    auto n= s->name();
+    symbols[n] = s;
+    // keep the slot on redefinition
+    if (s->hasSlot() && !s__contains(slots, n)) {
+      slots[n] = (int) slots.size();
+      ++Frame::shapes;
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Table::slot(cstdstr& name) const {
+  auto s= slots.find(name);
+  return s != slots.end() ? s->second : -1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+LexAddr Table::resolve(cstdstr& name) const {
+  int depth=0;
+  for (auto t= this; t; t= t->enclosing.get(), ++depth) {
+    if (auto s= t->slots.find(name); s != t->slots.end()) {
+      return LexAddr{depth, s->second};
+    }
+    // no storage, e.g. a type or a proc, only the depth is useful
+    if (s__contains(t->symbols, name)) { return LexAddr{depth, -1}; }
+  }
+  return LexAddr();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -441,6 +809,149 @@ DSymbol Table::find(cstdstr& name) const {
   }
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void TokenBuffer::reset(const Tchar* s, size_t n) {
+  src=s;
+  len=n;
+  types.clear();
+  offsets.clear();
+  lens.clear();
+  lits.clear();
+  pool.clear();
+  bols.clear();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int TokenBuffer::add(int type, int off, int n, int lit) {
+  s__conj(types, type);
+  s__conj(offsets, off);
+  s__conj(lens, n);
+  s__conj(lits, lit);
+  return size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int TokenBuffer::addLit(cstdstr& t) {
+  Lit x;
+  x.text=t;
+  x.num.n=0;
+  s__conj(pool, x);
+  return (int) pool.size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int TokenBuffer::addLit(llong n) {
+  Lit x;
+  x.num.n=n;
+  s__conj(pool, x);
+  return (int) pool.size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int TokenBuffer::addLit(double d) {
+  Lit x;
+  x.num.r=d;
+  s__conj(pool, x);
+  return (int) pool.size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Addr TokenBuffer::addr(int i) const {
+  if (bols.empty()) {
+    s__conj(bols, 0);
+    for (auto s= src, e= src+len; s < e;) {
+      auto nl= (const Tchar*) ::memchr(s, '\n', e-s);
+      if (!nl) { break; }
+      s__conj(bols, (int)(nl-src+1));
+      s= nl+1; } }
+  auto off= offsets[i];
+  auto b= std::upper_bound(bols.begin(), bols.end(), off) - 1;
+  auto c= off - *b + 1;
+  // as Context::mark(), at eof the col stays on the last char
+  return DMARK((int)(b-bols.begin()) + 1, off >= (int) len ? c-1 : c);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::string_view TokenBuffer::span(int i) const {
+  return std::string_view(src+offsets[i], lens[i]);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr TokenBuffer::text(int i) const {
+  // numbers only pool their value
+  auto k= lits[i];
+  auto t= types[i];
+  return (k < 0 || t == T_INT || t == T_REAL)
+         ? stdstr(span(i)) : pool[k].text;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DToken TokenBuffer::token(int i) const {
+  return token(i, addr(i));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DToken TokenBuffer::token(int i, Addr m) const {
+  auto k= lits[i];
+  switch (types[i]) {
+  case T_INT:
+    return Token::make(text(i), m, k < 0 ? (llong) 0 : pool[k].num.n);
+  case T_REAL:
+    return Token::make(text(i), m, k < 0 ? 0.0 : pool[k].num.r);
+  case T_STRING:
+    return Token::make(text(i), m);
+  default:
+    return Token::make(types[i], text(i), m);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Tchar TokenCursor::after() const {
+  auto e= buf->offsets[pos] + buf->lens[pos];
+  return e < (int) buf->len ? buf->src[e] : '\0';
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value::Value(DValue v) {
+  n=0;
+  heap=v;
+  if (auto p= v.get(); !p) {
+    tag=V_NIL;
+  } else if (typeid(*p) != typeid(Number)) {
+    tag=V_OBJ;
+  } else if (auto x= s__cast(Number,p); x->isInt()) {
+    tag=V_INT;
+    n=x->getInt();
+  } else {
+    tag=V_REAL;
+    r=x->getFloat();
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DValue Value::box() const {
+  if (heap || tag==V_NIL) { return heap; }
+  switch (tag) {
+  case V_REAL: return Number::make(r);
+  case V_CHAR: return String::make(stdstr(1, (Tchar) n));
+  default: return Number::make(n);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Value::equals(const Value& rhs) const {
+  if (isNumber() && rhs.isNumber()) {
+    return (isInt() && rhs.isInt())
+      ? n == rhs.n : a::fuzzy_equals(getFloat(), rhs.getFloat());
+  }
+  if (tag != rhs.tag) { return false; }
+  switch (tag) {
+  case V_NIL: return true;
+  case V_OBJ: return heap->equals(rhs.heap);
+  default: return n == rhs.n;
+  }
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool String::equals(DValue rhs) const {
   return is_same(rhs, this) &&
@@ -450,11 +961,17 @@ bool String::equals(DValue rhs) const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int String::compare(DValue rhs) const {
   if (!is_same(rhs, this)) {
-    return pr_str().compare(rhs->pr_str()); }
+    return compare_types(this, rhs.get()); }
   else {
     return value.compare(DCAST(String,rhs)->value); }
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t String::hash() const {
+  if (_hash == 0) { _hash= std::hash<stdstr>()(value); }
+  return _hash;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Number::match(const Number* rhs) const {
   return (isInt() && rhs->isInt())
@@ -471,13 +988,28 @@ bool Number::equals(DValue rhs) const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int Number::compare(DValue rhs) const {
   if (!is_same(rhs, this)) {
-    return pr_str().compare(rhs->pr_str());
+    return compare_types(this, rhs.get());
   } else {
     auto p= DCAST(Number, rhs);
     return match(p) ? 0 : (getFloat() > p->getFloat() ? 1 : -1);
   }
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Number::sameKey(DValue rhs) const {
+  if (!is_same(rhs, this)) { return false; }
+  auto p= DCAST(Number, rhs);
+  return (isInt() && p->isInt())
+    ? getInt() == p->getInt()
+    : real_key(getFloat()) == real_key(p->getFloat());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// an int matches the real of the same value, so both hash as reals
+size_t Number::hash() const {
+  return std::hash<double>()(real_key(getFloat()));
+}
+
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
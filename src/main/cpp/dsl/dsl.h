@@ -13,6 +13,11 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include <istream>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
 #include "../aeon/aeon.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -77,6 +82,10 @@ struct Unsupported : public a::Error {
 struct Symbol;
 struct Table;
 struct Node;
+struct Folder;
+struct Profiler;
+struct Tracer;
+struct Heap;
 struct Data;
 struct Frame;
 struct Lexeme;
@@ -152,6 +161,84 @@ enum TokenType {
   T_ETHEREAL
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Keyword {
+  int type=0;
+  std::string_view name;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// FNV-1a over the upper cased text, so a lookup may ignore case
+constexpr uint32_t keyword_hash(std::string_view s, uint32_t seed) {
+  uint32_t h= 2166136261u ^ seed;
+  for (auto c : s) {
+    if (c >= 'a' && c <= 'z') { c -= 'a'-'A'; }
+    h= (h ^ (unsigned char) c) * 16777619u;
+  }
+  // low bits of a product only see low bits, so mix the high ones down
+  h ^= h >> 16; h *= 0x7feb352du; h ^= h >> 15;
+  return h;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+constexpr bool keyword_equals(std::string_view a,
+                              std::string_view b, bool nocase) {
+  if (a.size() != b.size()) { return false; }
+  for (size_t i=0; i < a.size(); ++i) {
+    auto x= a[i], y= b[i];
+    if (nocase) {
+      if (x >= 'a' && x <= 'z') { x -= 'a'-'A'; }
+      if (y >= 'a' && y <= 'z') { y -= 'a'-'A'; }
+    }
+    if (x != y) { return false; }
+  }
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Perfect hash over a fixed word list, built by the compiler.
+// A lookup is one hash, one mask and one compare.
+template<size_t N>
+struct KeywordTable {
+
+  // a power of 2, at least 4x the words, keeps the seed search short
+  static constexpr size_t M= []() {
+    size_t m=8; while (m < 4*N) { m *= 2; } return m; }();
+
+  constexpr KeywordTable(const Keyword (&kw)[N]) : words(), slots(), seed(0) {
+    for (size_t i=0; i < N; ++i) { words[i]=kw[i]; }
+    for (;; ++seed) {
+      if (seed > 100000) { throw "no perfect hash, words clash"; }
+      for (auto& x : slots) { x= -1; }
+      bool ok=true;
+      for (size_t i=0; ok && i < N; ++i) {
+        auto& x= slots[keyword_hash(words[i].name, seed) & (M-1)];
+        if (x < 0) { x= (int) i; } else { ok=false; }
+      }
+      if (ok) { break; }
+    }
+  }
+
+  // the token type, -1 if not a word
+  constexpr int find(std::string_view s, bool nocase=false) const {
+    auto x= slots[keyword_hash(s, seed) & (M-1)];
+    return (x >= 0 && keyword_equals(words[x].name, s, nocase))
+           ? words[x].type : -1;
+  }
+
+  constexpr bool contains(std::string_view s) const { return find(s) >= 0; }
+
+  // a scan, for messages only
+  constexpr std::string_view name(int type) const {
+    for (auto& w : words) { if (w.type == type) { return w.name; } }
+    return std::string_view();
+  }
+
+  Keyword words[N];
+  std::array<int,M> slots;
+  uint32_t seed;
+};
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Lexeme {
   // A chunk of text - a sequence of chars.
@@ -191,19 +278,75 @@ struct IScanner {
   virtual ~IScanner() {}
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Text for a lexer, read in chunks, see Context::open().
+struct Source {
+  // up to n chars into buf, 0 at the end of the input
+  virtual size_t read(Tchar* buf, size_t n) = 0;
+  virtual ~Source() {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct StreamSource : public Source {
+  virtual size_t read(Tchar*, size_t);
+  StreamSource(std::istream& in) : in(in) {}
+  virtual ~StreamSource() {}
+
+  private:
+
+  std::istream& in;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct FileSource : public Source {
+  virtual size_t read(Tchar*, size_t);
+  // closes fd at the end only if owned
+  FileSource(int fd, bool owned=false) : fd(fd), owned(owned) {}
+  virtual ~FileSource();
+
+  private:
+
+  int fd;
+  bool owned;
+};
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Context {
   /////////////////////////////////////////////
   // For lexer, holds all the key attributes.
-  Addr mark() { return DMARK(line,col); }
-  ~Context() {}
+  // line & col of pos, counted only when asked for
+  Addr mark();
+  // From a source it then owns, instead of src being the whole
+  // program, src is a window onto the text, read in as needed.
+  void open(Source*, size_t window=64*1024);
+  // drops the text lexed so far, lexers call it between tokens,
+  // positions held across a call are no longer good
+  void trim();
+  // p can be read, reading more of the source in if need be
+  bool has(int p) { return p < (int)len || (in && more(p)); }
+  ~Context();
   Context();
   /////////////////////////////////////////////
-  int line, col, pos;
+  int pos;
   const Tchar* src;
   size_t len;
   bool eof;
   DToken cur;
+
+  private:
+
+  Context(const Context&)=delete;
+  Context& operator=(const Context&)=delete;
+
+  bool more(int);
+  void count(int);
+
+  Source* in;
+  std::vector<Tchar> buf;
+  size_t window;
+  bool drained;
+  // newlines before seen are counted, bol is where the line starts
+  int seen, lines, bol;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -219,18 +362,28 @@ struct SyntaxError : public a::Error {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool is_same(const Data* x, const Data* y);
 bool is_same(DValue, const Data* y);
+// orders values of different types by type, nothing is printed
+int compare_types(const Data* x, const Data* y);
+size_t hash_combine(size_t seed, size_t h);
+// a real snapped to the grid fuzzy_equals works to, so reals can
+// be keys, see Data::sameKey
+double real_key(double);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 std::pair<stdstr,Addr> identifier(Context&, IdPredicate);
 std::pair<stdstr,Addr> digits(Context&);
 std::pair<stdstr,Addr> numeric(Context&);
 std::pair<stdstr,Addr> str(Context&);
+// slices of the source, nothing is copied
+std::string_view identifier_view(Context&, IdPredicate);
+std::string_view numeric_view(Context&);
 Tchar peekAhead(Context&, int offset=1);
 bool peekPattern(Context&,cstdstr&);
 Tchar peek(Context&);
 Tchar pop(Context&);
-const std::map<stdstr,int>& getStrTokens();
-const std::map<int,stdstr>& getIntTokens();
+// the shared tokens, by text and by type
+int tokenType(std::string_view);
+std::string_view tokenName(int);
 void skipWhitespace(Context&);
 stdstr  pr_addr(Addr);
 bool advance(Context&, int steps=1);
@@ -251,6 +404,8 @@ struct Symbol {
   }
   DSymbol type() const { return _type; }
   stdstr name() const { return _name; }
+  // false if no value is kept for it in a frame
+  bool hasSlot() const { return _slotted; }
 
   ~Symbol() {}
 
@@ -259,12 +414,35 @@ struct Symbol {
   Symbol(cstdstr& n, DSymbol t) : Symbol(n) { _type=t; }
   Symbol(cstdstr& n) : _name(n) { }
 
+  bool _slotted=true;
+
   private:
 
   stdstr _name;
   DSymbol _type;
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct LexAddr {
+  // A variable resolved during analysis, the number of
+  // frames to walk up and the index into that frame.
+  int depth=-1;
+  int slot=-1;
+  bool ok() const { return slot >= 0; }
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct NameCache {
+  // A name lookup kept at its use site, for what analysis could
+  // not resolve.  It holds while the lookup starts from the same
+  // frame and no frame has gained a name since, see Frame::shapes.
+  llong frame=-1;
+  llong shape=-1;
+  // a slotted var, else the entry in some frame's map, else unbound
+  LexAddr addr;
+  DValue* cell=P_NIL;
+};
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 typedef std::map<stdstr,DSymbol> SymbolMap;
 struct Table {
@@ -281,6 +459,12 @@ struct Table {
   DSymbol search(cstdstr&) const;
   DSymbol find(cstdstr&) const;
 
+  // each inserted symbol owns a slot in the matching frame
+  int slot(cstdstr&) const;
+  int size() const { return (int) slots.size(); }
+  LexAddr resolve(cstdstr&) const;
+  const std::map<stdstr,int>& layout() const { return slots; }
+
   ~Table() {}
 
   protected:
@@ -291,6 +475,7 @@ struct Table {
 
   stdstr _name;
   SymbolMap symbols;
+  std::map<stdstr,int> slots;
   DTable enclosing;
 };
 
@@ -301,6 +486,15 @@ struct Data {
   virtual stdstr rtti() const=0;
   virtual bool equals(DValue) const = 0;
   virtual int compare(DValue) const = 0;
+  // values that are the same key hash alike, this one only
+  // tells types apart, so override it for anything used as a key
+  virtual size_t hash() const { return typeid(*this).hash_code(); }
+  // equality for keying containers, it must agree with hash(), so
+  // it can't be fuzzy, override it where equals() is
+  virtual bool sameKey(DValue v) const { return equals(v); }
+  // reports the values and frames held, for the cycle collector,
+  // anything holding a closure or a frame must have one
+  virtual void trace(Tracer&) const {}
   virtual ~Data() {}
 
   protected:
@@ -308,6 +502,23 @@ struct Data {
   Data() {}
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// for keying containers on the values themselves
+struct ValueHash {
+  size_t operator()(const DValue& v) const { return v ? v->hash() : 0; }
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct ValueEq {
+  bool operator()(const DValue& x, const DValue& y) const {
+    return x == y || (x && y && x->sameKey(y));
+  }
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+typedef std::unordered_map<DValue,DValue,ValueHash,ValueEq> ValueMap;
+typedef std::unordered_set<DValue,ValueHash,ValueEq> ValueSet;
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Number : public Data {
 
@@ -349,7 +560,9 @@ struct Number : public Data {
   }
 
   virtual bool equals(DValue) const;
+  virtual bool sameKey(DValue) const;
   virtual int compare(DValue) const;
+  virtual size_t hash() const;
 
   virtual stdstr rtti() const { return "Number"; }
   Number() : type(T_INT) { num.n=0; }
@@ -385,6 +598,7 @@ struct String : public Data {
 
   virtual bool equals(DValue) const;
   virtual int compare(DValue) const;
+  virtual size_t hash() const;
 
   stdstr impl() const { return value; }
   // internal use only
@@ -393,6 +607,8 @@ struct String : public Data {
   protected:
 
   stdstr value;
+  // never changes, so hashed once
+  mutable size_t _hash=0;
   String(cstdstr& s) : value(s) {}
   String(const Tchar* s) : value(s) {}
 };
@@ -412,8 +628,7 @@ struct Nothing : public Data {
 
   virtual int compare(DValue rhs) const {
     ASSERT1(rhs);
-    return is_same(rhs,this)
-           ? 0 : pr_str().compare(rhs->pr_str());
+    return compare_types(this, rhs.get());
   }
 
   virtual ~Nothing() {}
@@ -424,15 +639,77 @@ struct Nothing : public Data {
 
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+enum ValueTag { V_NIL=0, V_BOOL, V_CHAR, V_INT, V_REAL, V_OBJ };
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Value {
+  // Scalars are held inline, anything else stays a heap object.
+  // For a scalar, heap is an optional box of the same value, kept
+  // so that handing it back as a DValue does not allocate again.
+
+  static Value of(llong n) { Value v(V_INT); v.n=n; return v; }
+  static Value of(int n) { return of((llong) n); }
+  static Value of(double d) { Value v(V_REAL); v.r=d; return v; }
+  static Value of(bool b) { Value v(V_BOOL); v.n= b ? 1 : 0; return v; }
+  static Value ofChar(Tchar c) { Value v(V_CHAR); v.n=c; return v; }
+
+  // numbers are unboxed, everything else is held as is
+  Value(DValue);
+  Value() : tag(V_NIL) { n=0; }
+
+  bool isNil() const { return tag==V_NIL; }
+  bool isObj() const { return tag==V_OBJ; }
+  bool isInt() const { return tag==V_INT; }
+  bool isNumber() const { return tag==V_INT || tag==V_REAL; }
+
+  llong getInt() const { return tag==V_REAL ? (llong) r : n; }
+  double getFloat() const { return tag==V_REAL ? r : (double) n; }
+
+  bool isZero() const {
+    return tag==V_REAL ? a::fuzzy_zero(r) : n==0; }
+  bool isNeg() const { return tag==V_REAL ? r < 0.0 : n < 0; }
+  bool isPos() const { return tag==V_REAL ? r > 0.0 : n > 0; }
+
+  bool equals(const Value&) const;
+  // the heap object, allocated here if this is a bare scalar
+  DValue box() const;
+  // a scalar without its box, copies free of refcounting
+  Value bare() const {
+    if (tag==V_OBJ) { return *this; }
+    Value v(tag); v.n=n; return v;
+  }
+
+  ValueTag tag;
+  union { llong n; double r; };
+  DValue heap;
+
+  private:
+
+  explicit Value(ValueTag t) : tag(t) { n=0; }
+};
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct IEvaluator {
   // Interface support for parser evaluation.
   virtual DValue setValueEx(cstdstr&, DValue) = 0;
   virtual DValue setValue(cstdstr&, DValue) = 0;
   virtual DValue getValue(cstdstr&) const = 0;
+  virtual DValue setValue(const LexAddr&, DValue) = 0;
+  virtual DValue getValue(const LexAddr&) const = 0;
   virtual DFrame pushFrame(cstdstr&)=0;
+  // a frame laid out from an analyzed scope, outer is the static link
+  virtual DFrame pushFrame(cstdstr&, DTable, DFrame)=0;
   virtual DFrame popFrame()=0;
   virtual DFrame peekFrame() const =0;
+  // unboxed slot access, the defaults go through the boxed calls
+  virtual Value load(const LexAddr& a) const { return Value(getValue(a)); }
+  virtual void store(const LexAddr& a, const Value& v) { setValue(a, v.box()); }
+  // by name through the use site's cache, the defaults go to the frame
+  virtual DValue getValue(cstdstr&, NameCache&) const;
+  virtual DValue setValue(cstdstr&, DValue, NameCache&);
+  // set to have the probes report, see profiler.h
+  Profiler* profiler=P_NIL;
   virtual ~IEvaluator() {}
 };
 
@@ -445,30 +722,52 @@ struct IAnalyzer {
   virtual DTable pushScope(cstdstr&) = 0;
   virtual DTable popScope()=0;
   virtual DSymbol define(DSymbol)=0;
+  virtual LexAddr resolve(cstdstr&) const = 0;
 
   virtual ~IAnalyzer() {}
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Assembler;
+struct Operand {
+  // a register and its kind, see vm.h
+  int reg;
+  int kind;
+};
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Node {
   // Abstract node used in the building of a syntax tree.
   virtual DValue eval(IEvaluator*)=0;
+  // nodes that can yield a scalar without boxing it override this
+  virtual Value evalValue(IEvaluator* e) { return Value(eval(e)); }
   virtual void visit(IAnalyzer*)=0;
+  // bytecode for the node, the result goes to dst or any register
+  // if dst < 0, the default throws Unsupported so the program
+  // stays with eval()
+  virtual Operand compile(Assembler*, int dst);
+  // a jump taken if the node is, or is not, true, returns its pc
+  virtual int compileJump(Assembler*, bool when);
+  // fold the children, return what stands in for this node, if
+  // anything, see fold.h
+  virtual DAst fold(Folder*) { return DAst(); }
   virtual ~Node() {}
   protected:
   Node() {}
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-struct Frame {
+struct Frame : public std::enable_shared_from_this<Frame> {
   // A stack frame used during language evaluation.
 
   static DFrame search(cstdstr&, DFrame);
+  static DFrame make(cstdstr&, DTable, DFrame);
   static DFrame make(cstdstr&, DFrame);
   static DFrame make(cstdstr&);
   static DFrame getRoot(DFrame);
+  static DFrame getOuter(DFrame, int hops);
 
-  ~Frame() {}
+  ~Frame();
 
   stdstr name() const { return _name; }
   stdstr pr_str() const;
@@ -477,21 +776,60 @@ struct Frame {
   DValue set(cstdstr&, DValue);
   DValue get(cstdstr&) const;
 
+  // no names involved, see Table::resolve()
+  DValue set(int depth, int slot, DValue);
+  DValue get(int depth, int slot) const;
+  void store(int depth, int slot, const Value&);
+  Value load(int depth, int slot) const;
+
+  // as the named ones above, redone only when the cache is stale
+  DValue get(cstdstr&, NameCache&);
+  DValue set(cstdstr&, DValue, NameCache&);
+
+  // bumped whenever a frame gains a name or a scope a slot
+  static thread_local llong shapes;
+
   bool contains(cstdstr&) const;
   std::set<stdstr> keys() const;
 
   DFrame getOuter() const;
 
+  // for the collector, see Heap
+  void trace(Tracer&) const;
+  void clear();
+
   protected:
 
+  Frame(cstdstr&, DTable, DFrame);
   Frame(cstdstr&, DFrame);
   Frame(cstdstr&);
 
   private:
 
+  int index(cstdstr& key) const {
+    return layout ? layout->slot(key) : -1;
+  }
+
+  void resolve(cstdstr&, NameCache&, bool local);
+  // the frame depth hops out, raises if the chain is shorter
+  Frame* hop(int depth) const;
+
+  // never reused, unlike the address
+  llong id;
+
   stdstr _name;
   DFrame prev;
+  // slotted vars, names outside the layout go to the map
+  DTable layout;
+  // boxed lazily by get(), hence mutable
+  mutable std::vector<Value> vars;
   std::map<stdstr,DValue> slots;
+
+  friend struct Heap;
+  // every frame of the thread's heap, linked
+  Heap* heap=P_NIL;
+  Frame* gcPrev=P_NIL;
+  Frame* gcNext=P_NIL;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -505,7 +843,7 @@ struct TypeSymbol : public Symbol {
 
   protected:
 
-  TypeSymbol(cstdstr& n) : Symbol(n) {}
+  TypeSymbol(cstdstr& n) : Symbol(n) { _slotted=false; }
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -537,16 +875,19 @@ struct FnSymbol : public Symbol {
   SymbolVec& params() { return _params; }
   DAst body() const { return block; }
   void setBody(DAst b) { block=b;}
+  DTable scope() const { return _scope; }
+  void setScope(DTable t) { _scope=t; }
 
   ~FnSymbol() {}
 
   protected:
 
   FnSymbol(cstdstr& name, DSymbol t) : FnSymbol(name) { result=t; }
-  FnSymbol(cstdstr& name) : Symbol(name) {}
+  FnSymbol(cstdstr& name) : Symbol(name) { _slotted=false; }
 
   DSymbol result;
   DAst block;
+  DTable _scope;
   SymbolVec _params;
 };
 
@@ -620,6 +961,68 @@ struct Token : public Lexeme {
   Token(int t, Addr m) : Lexeme(t,m) {}
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// A whole token stream as parallel arrays.  Text is the source
+// slice unless the lexer put a literal in the pool, line & col
+// come from a newline index built on first use.
+struct TokenBuffer {
+
+  struct Lit {
+    stdstr text;
+    union { llong n; double r; } num;
+  };
+
+  // drops the tokens, keeps the capacity
+  void reset(const Tchar* src, size_t len);
+  int add(int type, int off, int len, int lit= -1);
+  int addLit(cstdstr&);
+  int addLit(llong);
+  int addLit(double);
+
+  int size() const { return (int) types.size(); }
+  Addr addr(int) const;
+  std::string_view span(int) const;
+  stdstr text(int) const;
+  // a heap token, for the parser to keep in the tree
+  DToken token(int) const;
+  DToken token(int, Addr) const;
+
+  TokenBuffer() { S_NIL(src); len=0; }
+  ~TokenBuffer() {}
+
+  std::vector<int> types;
+  std::vector<int> offsets;
+  std::vector<int> lens;
+  std::vector<int> lits;
+  std::vector<Lit> pool;
+  const Tchar* src;
+  size_t len;
+
+  private:
+
+  // where each line starts
+  mutable std::vector<int> bols;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct TokenCursor {
+  // Walks a TokenBuffer, stops at the last (eof) token.
+
+  int type() const { return buf->types[pos]; }
+  bool isCur(int t) const { return type() == t; }
+  bool isEof() const { return type() == T_EOF; }
+  Addr addr() const { return buf->addr(pos); }
+  // the char just past the current token
+  Tchar after() const;
+  int eat() { auto i=pos; if (pos+1 < buf->size()) ++pos; return i; }
+
+  TokenCursor(const TokenBuffer* b) : buf(b), pos(0) {}
+  ~TokenCursor() {}
+
+  const TokenBuffer* buf;
+  int pos;
+};
+
 
 
 
@@ -0,0 +1,160 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <typeinfo>
+#include "vm.h"
+#include "fold.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+namespace a=czlab::aeon;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// x as a T, or null if it is something else
+template<typename T, typename P>
+T* typed(const std::shared_ptr<P>& x) {
+  return x && typeid(*x) == typeid(T) ? DCAST(T, x) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Operand Literal::compile(Assembler* a, int dst) {
+  auto res= dst < 0 ? a->temp() : dst;
+  if (auto n= typed<Number>(value); n) {
+    if (n->isInt()) {
+      auto x= n->getInt();
+      if ((int) x == x) {
+        a->emit(OP_LOADI, res, (int) x);
+      } else {
+        a->emit(OP_LOADK, res, a->konst(bare));
+      }
+      return Operand{res, K_INT};
+    }
+    a->emit(OP_LOADK, res, a->konst(bare));
+    return Operand{res, K_REAL};
+  }
+  if (typed<String>(value)) {
+    a->emit(OP_LOADK, res, a->konst(bare));
+    return Operand{res, K_STR};
+  }
+  if (!value) {
+    a->emit(OP_NIL, res);
+    return Operand{res, K_ANY};
+  }
+  RAISE(Unsupported, "No bytecode for %s", C_STR(value->rtti()));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Literal::smallInt(const DAst& x, int& out) {
+  auto p= typed<Literal>(x);
+  auto n= p ? typed<Number>(p->value) : P_NIL;
+  if (!n || !n->isInt()) { return false; }
+  out= (int) n->getInt();
+  return out == n->getInt();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+FoldCounts Folder::run(DAst& root) {
+  FoldCounts c;
+  rewrite=false;
+  nodes=0;
+  fold(root);
+  c.before=nodes;
+  rewrite=true;
+  fold(root);
+  rewrite=false;
+  nodes=0;
+  fold(root);
+  c.after=nodes;
+  c.pooled=pooled;
+  return c;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::fold(DAst& n) {
+  if (n) {
+    ++nodes;
+    if (auto r= n->fold(this); r) { n=r; }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::fold(AstVec& v) {
+  for (auto& x : v) { fold(x); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+DAst Folder::eval(Node* n, const AstVec& kids) {
+  if (!rewrite) { return DAst(); }
+  for (auto& x : kids) {
+    auto p= typed<Literal>(x);
+    if (!p || !typed<Number>(p->value)) { return DAst(); }
+  }
+  DValue v;
+  try {
+    // pure nodes never touch the evaluator
+    v= n->eval(P_NIL);
+  } catch (...) {
+    return DAst();
+  }
+  return v ? pool(v) : DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Folder::truth(const DAst& x) const {
+  auto p= rewrite ? typed<Literal>(x) : P_NIL;
+  auto n= p ? typed<Number>(p->value) : P_NIL;
+  // as an int, so 0.5 is false
+  return n ? (n->getInt() != 0 ? 1 : 0) : -1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Folder::zero(const DAst& x) const {
+  auto p= typed<Literal>(x);
+  auto n= p ? typed<Number>(p->value) : P_NIL;
+  return n && n->isZero();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// equal literals share one node and one value
+DAst Folder::pool(DValue v) {
+  stdstr k;
+  if (auto n= typed<Number>(v); n) {
+    char buf[64];
+    if (n->isInt()) {
+      ::snprintf(buf, sizeof(buf), "i%lld", (long long) n->getInt());
+    } else {
+      // exact, %g would merge reals that only print alike
+      ::snprintf(buf, sizeof(buf), "r%a", n->getFloat());
+    }
+    k=buf;
+  } else if (auto s= typed<String>(v); s) {
+    k= "s" + s->impl();
+  } else {
+    return Literal::make(v);
+  }
+  if (auto i= _pool.find(k); i != _pool.end()) {
+    ++pooled;
+    return i->second;
+  }
+  return _pool[k]= Literal::make(v);
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,103 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include "dsl.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// A value known before the program runs, what a constant
+// subtree folds into.  The value is made once and shared.
+struct Literal : public Node {
+
+  static DAst make(DValue v) { return DAst(new Literal(v)); }
+
+  virtual DValue eval(IEvaluator*) { return value; }
+  virtual Value evalValue(IEvaluator*) { return bare; }
+  virtual void visit(IAnalyzer*) {}
+  virtual Operand compile(Assembler*, int dst);
+
+  // a number that fits an operand
+  static bool smallInt(const DAst&, int& out);
+
+  DValue value;
+  Value bare;
+
+  virtual ~Literal() {}
+
+  private:
+
+  Literal(DValue v) : value(v), bare(Value(v).bare()) {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct FoldCounts {
+  int before=0;
+  int after=0;
+  int pooled=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Constant folding, run once the analyzer has visited the tree.
+//
+// Each node's fold() hands its children to fold(), then applies
+// the shared rules below to itself: a node whose eval() reads
+// nothing but its children becomes a Literal when they all are,
+// by running that eval(), so the semantics are the language's own.
+// If it throws, the node stays and throws at run time as before.
+// A branch on a Literal keeps only the side taken, and an and/or
+// decided by its left term leaves the rest unfolded.
+struct Folder {
+
+  // fold the tree in place
+  FoldCounts run(DAst& root);
+
+  // the child, replaced by what its fold() returns
+  void fold(DAst&);
+  void fold(AstVec&);
+
+  // a Literal for a pure node if all kids are numeric Literals
+  DAst eval(Node*, const AstVec& kids);
+  // 1 or 0 for a Literal number, -1 if not known
+  int truth(const DAst&) const;
+  // a Literal number equal to 0, a divisor left for run time
+  // since the language may stop the program there, not throw
+  bool zero(const DAst&) const;
+  // false on the passes that only count, nothing may change then
+  bool rewriting() const { return rewrite; }
+
+  Folder() {}
+  ~Folder() {}
+
+  private:
+
+  DAst pool(DValue);
+  std::map<stdstr, DAst> _pool;
+  // false while only counting
+  bool rewrite=false;
+  int nodes=0;
+  int pooled=0;
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,203 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <chrono>
+#include <unordered_map>
+#include "gc.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// A frame, or a value with more than one owner.  A value with
+// just the one is taken as part of its owner and gets no node,
+// which leaves out most of the heap.
+struct Vertex {
+  long refs;
+  // owners met by the walk
+  long met=0;
+  bool live=false;
+  std::vector<int> out;
+  Vertex(long r) : refs(r) {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Walker : public Tracer {
+
+  // the frames first, in the order given
+  Walker(const std::vector<DFrame>& frames) {
+    for (auto& f : frames) {
+      // less the one held by the run
+      add(f.get(), f.use_count()-1);
+      s__conj(todo, Item(P_NIL, f.get(), nodes.size()-1));
+    }
+  }
+
+  void run() {
+    while (!todo.empty()) {
+      auto x= todo.back();
+      todo.pop_back();
+      cur= x.owner;
+      ++scanned;
+      if (x.frame) { x.frame->trace(*this); }
+      else { x.data->trace(*this); }
+    }
+  }
+
+  // from what is held by someone the walk did not meet
+  void mark() {
+    std::vector<int> stack;
+    for (auto i=0; i < (int) nodes.size(); ++i) {
+      if (nodes[i].refs > nodes[i].met) { s__conj(stack, i); }
+    }
+    while (!stack.empty()) {
+      auto i= stack.back();
+      stack.pop_back();
+      if (nodes[i].live) { continue; }
+      nodes[i].live=true;
+      for (auto j : nodes[i].out) {
+        if (!nodes[j].live) { s__conj(stack, j); }
+      }
+    }
+  }
+
+  virtual void visit(const DValue& v) {
+    if (!v) {}
+    else if (v.use_count() == 1) {
+      s__conj(todo, Item(v.get(), P_NIL, cur));
+    } else {
+      edge(v.get(), v.use_count(), v.get(), P_NIL);
+    }
+  }
+
+  virtual void visit(const DFrame& f) {
+    if (f) { edge(f.get(), f.use_count(), P_NIL, f.get()); }
+  }
+
+  struct Item {
+    Item(const Data* d, const Frame* f, int n)
+      : data(d), frame(f), owner(n) {}
+    const Data* data;
+    const Frame* frame;
+    int owner;
+  };
+
+  std::vector<Vertex> nodes;
+  std::unordered_map<const void*,int> index;
+  std::vector<Item> todo;
+  llong scanned=0;
+  int cur=0;
+
+  private:
+
+  bool add(const void* p, long refs) {
+    auto r= index.emplace(p, nodes.size());
+    if (r.second) { s__conj(nodes, Vertex(refs)); }
+    return r.second;
+  }
+
+  void edge(const void* p, long refs, const Data* d, const Frame* f) {
+    auto fresh= add(p, refs);
+    auto i= index[p];
+    ++nodes[i].met;
+    s__conj(nodes[cur].out, i);
+    if (fresh) { s__conj(todo, Item(d, f, i)); }
+  }
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Heap& Heap::current() {
+  static thread_local Heap h;
+  return h;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Heap::~Heap() {
+  // frames outliving the thread, kept in a static say
+  for (auto f= head; f; f= f->gcNext) { f->heap=P_NIL; }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Heap::link(Frame* f) {
+  f->heap=this;
+  f->gcNext=head;
+  if (head) { head->gcPrev=f; }
+  head=f;
+  ++_stats.frames;
+  ++made;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Heap::unlink(Frame* f) {
+  if (f->gcPrev) { f->gcPrev->gcNext= f->gcNext; }
+  else { head= f->gcNext; }
+  if (f->gcNext) { f->gcNext->gcPrev= f->gcPrev; }
+  f->heap=P_NIL;
+  --_stats.frames;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+llong Heap::poll() {
+  return enabled && made >= std::max(threshold, due) ? collect() : 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+llong Heap::collect() {
+  auto t= std::chrono::steady_clock::now();
+  std::vector<DFrame> all;
+  std::vector<DFrame> dead;
+
+  // held for the run, a frame on its way out has no owners left
+  for (auto f= head; f; f= f->gcNext) {
+    if (auto p= f->weak_from_this().lock(); p) { s__conj(all, p); }
+  }
+  {
+    Walker w(all);
+    w.run();
+    w.mark();
+    for (auto i=0; i < (int) all.size(); ++i) {
+      if (!w.nodes[i].live) { s__conj(dead, all[i]); }
+    }
+    _stats.lastScanned= w.scanned;
+  }
+  all.clear();
+  // cleared while still held, so none goes away half cleared
+  for (auto& f : dead) { f->clear(); }
+  auto n= (llong) dead.size();
+  dead.clear();
+
+  std::chrono::duration<double,std::milli> ms=
+    std::chrono::steady_clock::now() - t;
+  ++_stats.runs;
+  _stats.freed += n;
+  _stats.lastFreed= n;
+  _stats.lastMs= ms.count();
+  _stats.totalMs += ms.count();
+  made=0;
+  due= (llong) (_stats.frames * growth);
+  return n;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+HeapStats Heap::stats() const {
+  return _stats;
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,104 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include "dsl.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Handed every reference an object holds, see Data::trace().
+// Each stored pointer is to be reported once, reporting one twice
+// makes the collector free what is still in use.  Leaving one out
+// is safe, whatever it points to is then just never collected.
+struct Tracer {
+  virtual void visit(const DValue&)=0;
+  virtual void visit(const DFrame&)=0;
+  virtual ~Tracer() {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct HeapStats {
+  // alive on this thread, garbage not yet found included
+  llong frames=0;
+  llong runs=0;
+  // frames let go of, over all runs
+  llong freed=0;
+  // frames and values walked, and frames let go of, last run
+  llong lastScanned=0;
+  llong lastFreed=0;
+  double lastMs=0;
+  double totalMs=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Finds the frames that only keep each other alive, a lambda kept
+// in the frame it closes over being the usual case, and clears them.
+//
+// Refcounts still free everything else.  A run walks every frame on
+// the thread and what they hold, and counts how many of an object's
+// owners it met on the way.  An object with owners it did not meet is
+// held from outside, the C++ stack or a global, and so is everything
+// it reaches.  The frames left over are cut loose.
+//
+// One heap per thread, an isolate's values never leave its thread.
+// Run it where no raw pointer to a value is held, between top level
+// forms, the language repls poll() there.
+struct Heap {
+
+  static Heap& current();
+
+  // a run now, returns the frames let go of
+  llong collect();
+  // a run if enough frames were made since the last one
+  llong poll();
+
+  HeapStats stats() const;
+
+  // off, and poll() never runs
+  bool enabled=true;
+  // frames made between runs, at the least
+  llong threshold=10000;
+  // the next run is due after survivors * growth more frames,
+  // so a heap of live frames is not walked over and over
+  double growth=1.0;
+
+  ~Heap();
+
+  private:
+
+  friend struct Frame;
+
+  void link(Frame*);
+  void unlink(Frame*);
+
+  Heap() {}
+
+  // frames on this thread, a list through the frames themselves
+  Frame* head=P_NIL;
+  llong made=0;
+  llong due=0;
+  HeapStats _stats;
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,115 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "isolate.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+namespace a=czlab::aeon;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+thread_local Isolate* bound=P_NIL;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Isolate* Isolate::current() {
+  static thread_local Isolate stdio;
+  return bound ? bound : &stdio;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Isolate::Isolate(cstdstr& input) : _sin(input) {
+  _rng.seed(std::random_device()());
+  _in= &_sin;
+  _out= &_sout;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Isolate::Isolate() {
+  _rng.seed(std::random_device()());
+  _in= &std::cin;
+  _out= &std::cout;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+IsolateScope::IsolateScope(Isolate* i) : prev(bound) { bound=i; }
+IsolateScope::~IsolateScope() { bound=prev; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+BatchRunner::BatchRunner(int n) {
+  threads= n > 0 ? n : 1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+double BatchRunner::run(std::vector<Script>& scripts) {
+  std::atomic<size_t> next(0);
+  auto work= [&scripts, &next]() {
+    for (;;) {
+      auto i= next.fetch_add(1);
+      if (i >= scripts.size()) { break; }
+      auto& s= scripts[i];
+      Isolate iso(s.input);
+      IsolateScope bind(&iso);
+      s.error.clear();
+      try {
+        s.run();
+      } catch (const a::Error& e) {
+        s.error= e.what();
+      } catch (const std::exception& e) {
+        s.error= e.what();
+      } catch (...) {
+        s.error= "unknown error";
+      }
+      s.output= iso.output();
+    }
+  };
+  auto t= std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (auto i=1; i < threads; ++i) {
+    pool.emplace_back(work);
+  }
+  // this thread is a worker too
+  work();
+  for (auto& x : pool) { x.join(); }
+  std::chrono::duration<double> d= std::chrono::steady_clock::now() - t;
+  return d.count();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr BatchRunner::scaling(std::vector<Script>& scripts, int max) {
+  char buf[128];
+  ::snprintf(buf, sizeof(buf), "%8s %14s %8s\n",
+             "threads", "scripts/sec", "speedup");
+  stdstr out(buf);
+  double base=0;
+  for (auto n=1; n <= max; ++n) {
+    auto secs= BatchRunner(n).run(scripts);
+    auto rate= secs > 0 ? scripts.size() / secs : 0;
+    if (n == 1) { base=rate; }
+    ::snprintf(buf, sizeof(buf), "%8d %14.1f %8.2f\n",
+               n, rate, base > 0 ? rate / base : 0);
+    out += buf;
+  }
+  return out;
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,110 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <random>
+#include "dsl.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// What a run may change that is not inside the interpreter object,
+// the stdio streams, the random source and the gensym counter.
+//
+// An isolate is used by one thread at a time and its values never
+// reach another, so nothing in it is locked.  Binding one with
+// IsolateScope makes it current on that thread, a thread with none
+// bound gets a default isolate on stdio.
+struct Isolate {
+
+  static Isolate* current();
+
+  // reads from input, keeps what is written, see output()
+  Isolate(cstdstr& input);
+  // on stdin and stdout
+  Isolate();
+  ~Isolate() {}
+
+  std::istream& in() { return *_in; }
+  std::ostream& out() { return *_out; }
+  stdstr output() const { return _sout.str(); }
+
+  std::mt19937_64& rng() { return _rng; }
+  // for gensyms and the like
+  llong nextId() { return ++ids; }
+
+  private:
+
+  std::istringstream _sin;
+  std::ostringstream _sout;
+  std::istream* _in;
+  std::ostream* _out;
+  std::mt19937_64 _rng;
+  llong ids=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct IsolateScope {
+  // the isolate is current on this thread until the scope ends
+  IsolateScope(Isolate*);
+  ~IsolateScope();
+
+  private:
+
+  Isolate* prev;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Script {
+  // builds and runs its own interpreter, in a fresh isolate
+  std::function<void()> run;
+  stdstr input;
+  // filled in by the runner
+  stdstr output;
+  stdstr error;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Spreads scripts over a pool of threads, each script in an
+// isolate of its own, so they share nothing but the code.
+struct BatchRunner {
+
+  // every script once, returns the wall time in seconds
+  double run(std::vector<Script>&);
+
+  // the batch at 1 to max threads, a line per count with the
+  // scripts per second and the speedup over one thread
+  static stdstr scaling(std::vector<Script>&, int max);
+
+  BatchRunner(int threads);
+  ~BatchRunner() {}
+
+  private:
+
+  int threads;
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
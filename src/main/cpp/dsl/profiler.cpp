@@ -0,0 +1,227 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <typeinfo>
+#include <cstring>
+#include <csignal>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+#if !defined(WIN32) && !defined(_WIN32)
+#include <sys/time.h>
+#endif
+#include "profiler.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+namespace a=czlab::aeon;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the one being sampled, the timer has no other way in
+Profiler* active=P_NIL;
+// about 17 minutes at 1ms
+const int MAX_SAMPLES= 1 << 20;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Profiler::Profiler(Mode m, int usecs) : usecs(usecs), _mode(m) {
+  // path 0 is outside any probe
+  nodes.push_back(Path{-1,-1});
+  stats.resize(1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Profiler::~Profiler() {
+  if (active == this) { stop(); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Profiler::addSite(const Site& s) {
+  s__conj(info, s);
+  return (int) info.size() - 1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Profiler::push(int site) {
+  auto k= std::make_pair((int) cur, site);
+  auto i= paths.find(k);
+  if (i == paths.end()) {
+    i= paths.emplace(k, (int) nodes.size()).first;
+    nodes.push_back(Path{k.first, site});
+    stats.resize(nodes.size());
+  }
+  if (_mode == COUNT) {
+    open.push_back(Open{i->second, Clock::now(), Clock::duration{}});
+  } else {
+    open.push_back(Open{i->second, Clock::time_point{}, Clock::duration{}});
+  }
+  // last, a sample must never see a path not yet made
+  cur= i->second;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Profiler::leave() {
+  auto o= open.back();
+  auto& s= stats[o.path];
+  open.pop_back();
+  ++s.hits;
+  if (_mode == COUNT) {
+    auto d= Clock::now() - o.t0;
+    s.incl += d;
+    s.excl += d - o.child;
+    if (!open.empty()) { open.back().child += d; }
+  }
+  cur= nodes[o.path].parent;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Profiler::onTimer(int) {
+  auto p= active;
+  if (p && p->nsamples < MAX_SAMPLES) {
+    p->samples[p->nsamples]= p->cur;
+    p->nsamples = p->nsamples + 1;
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Profiler::start() {
+  if (_mode != SAMPLE || active) { return; }
+  samples.assign(MAX_SAMPLES, 0);
+  nsamples=0;
+  active=this;
+#if !defined(WIN32) && !defined(_WIN32)
+  struct sigaction sa;
+  ::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler= &Profiler::onTimer;
+  sa.sa_flags= SA_RESTART;
+  ::sigemptyset(&sa.sa_mask);
+  ::sigaction(SIGPROF, &sa, P_NIL);
+  struct itimerval t;
+  t.it_interval.tv_sec= usecs / 1000000;
+  t.it_interval.tv_usec= usecs % 1000000;
+  t.it_value= t.it_interval;
+  ::setitimer(ITIMER_PROF, &t, P_NIL);
+#endif
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Profiler::stop() {
+  if (active != this) { return; }
+#if !defined(WIN32) && !defined(_WIN32)
+  struct itimerval t;
+  ::memset(&t, 0, sizeof(t));
+  ::setitimer(ITIMER_PROF, &t, P_NIL);
+  ::signal(SIGPROF, SIG_DFL);
+#endif
+  active=P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Profiler::nameOf(const Node* n) {
+  stdstr s= typeid(*n).name();
+#if defined(__GNUC__)
+  int rc=0;
+  if (auto d= abi::__cxa_demangle(s.c_str(), P_NIL, P_NIL, &rc); d) {
+    if (rc == 0) { s= d; }
+    ::free(d);
+  }
+#endif
+  auto i= s.rfind("::");
+  return i == stdstr::npos ? s : s.substr(i+2);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Profiler::pathStr(int p) const {
+  stdstr out;
+  for (; p > 0; p= nodes[p].parent) {
+    auto& s= info[nodes[p].site];
+    auto f= s.what + ":" + N_STR(s.line);
+    // a frame may hold neither the separator nor a blank
+    for (auto& c : f) { if (c == ';' || c == ' ') c= '_'; }
+    out= out.empty() ? f : f + ";" + out;
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Profiler::folded() const {
+  std::vector<llong> w(nodes.size(), 0);
+  if (_mode == SAMPLE) {
+    for (int i=0; i < nsamples; ++i) { ++w[samples[i]]; }
+  } else {
+    for (auto i=0; i < (int) stats.size(); ++i) {
+      w[i]= std::chrono::duration_cast<
+              std::chrono::microseconds>(stats[i].excl).count();
+    }
+  }
+  stdstr out;
+  for (auto i=1; i < (int) w.size(); ++i) {
+    if (w[i] > 0) { out += pathStr(i) + " " + N_STR(w[i]) + "\n"; }
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Profiler::report() const {
+  struct Row {
+    llong hits=0;
+    llong samples=0;
+    Clock::duration incl{};
+    Clock::duration excl{};
+    stdstr what;
+  };
+  std::map<int,Row> lines;
+  std::vector<llong> hit(nodes.size(), 0);
+  for (int i=0; i < nsamples; ++i) { ++hit[samples[i]]; }
+  // inclusive time counts a recursive site once per level
+  for (auto i=1; i < (int) nodes.size(); ++i) {
+    auto& s= info[nodes[i].site];
+    auto& r= lines[s.line];
+    r.hits += stats[i].hits;
+    r.incl += stats[i].incl;
+    r.excl += stats[i].excl;
+    r.samples += hit[i];
+    if (r.what.find(s.what) == stdstr::npos) {
+      r.what += (r.what.empty() ? "" : ",") + s.what;
+    }
+  }
+  std::vector<std::pair<int,Row>> rows(lines.begin(), lines.end());
+  std::stable_sort(rows.begin(), rows.end(), [this](auto& x, auto& y) {
+    return _mode == SAMPLE ? x.second.samples > y.second.samples
+                           : x.second.excl > y.second.excl;
+  });
+  auto ms= [](Clock::duration d) {
+    return std::chrono::duration<double,std::milli>(d).count();
+  };
+  char buf[256];
+  ::snprintf(buf, sizeof(buf), "%6s %10s %10s %10s %8s  %s\n",
+             "line", "hits", "incl-ms", "excl-ms", "samples", "what");
+  stdstr out(buf);
+  for (auto& x : rows) {
+    auto& r= x.second;
+    ::snprintf(buf, sizeof(buf), "%6d %10lld %10.3f %10.3f %8lld  %s\n",
+               x.first, (long long) r.hits, ms(r.incl), ms(r.excl),
+               (long long) r.samples,
+               r.what.c_str());
+    out += buf;
+  }
+  return out;
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
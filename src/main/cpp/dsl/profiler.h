@@ -0,0 +1,144 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <unordered_map>
+#include "dsl.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Build with DSL_PROFILE 0 and the probes are gone altogether.
+#if !defined(DSL_PROFILE)
+#define DSL_PROFILE 1
+#endif
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Where a tree walker spends its time.
+//
+// A language puts a Probe around the eval() of its statements and
+// calls, a probe is a null test unless the evaluator has a profiler.
+// Probes nest into call paths, each path a parent path and a site.
+//
+// COUNT mode times every probe, so a site gets hits, inclusive and
+// exclusive time.  SAMPLE mode only tracks the current path, a
+// SIGPROF timer records it, so the overhead is a push and a pop.
+struct Profiler {
+
+  enum Mode { COUNT, SAMPLE };
+
+  // a statement or call, as the report shows it
+  struct Site {
+    int line;
+    stdstr what;
+  };
+
+  // one site per node, where() is asked the first time only
+  template<typename F>
+  void enter(const Node* n, F&& where) {
+    auto i= sites.find(n);
+    if (i == sites.end()) {
+      i= sites.emplace(n, addSite(where())).first;
+    }
+    push(i->second);
+  }
+  void leave();
+
+  // the timer runs between these, SAMPLE mode only
+  void start();
+  void stop();
+
+  // per source line, the heaviest first
+  stdstr report() const;
+  // "a;b;c n" lines, n is samples, or microseconds in COUNT mode
+  stdstr folded() const;
+
+  // the class name of a node, without its namespace
+  static stdstr nameOf(const Node*);
+
+  Mode mode() const { return _mode; }
+
+  Profiler(Mode m=COUNT, int usecs=1000);
+  ~Profiler();
+
+  private:
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Stat {
+    llong hits=0;
+    Clock::duration incl{};
+    Clock::duration excl{};
+  };
+
+  struct Path {
+    int parent;
+    int site;
+  };
+
+  struct Open {
+    int path;
+    Clock::time_point t0;
+    Clock::duration child;
+  };
+
+  int addSite(const Site&);
+  void push(int site);
+  stdstr pathStr(int) const;
+
+  static void onTimer(int);
+
+  std::unordered_map<const Node*, int> sites;
+  std::vector<Site> info;
+  std::map<std::pair<int,int>, int> paths;
+  std::vector<Path> nodes;
+  std::vector<Stat> stats;
+  std::vector<Open> open;
+  // written by the timer, sized up front
+  std::vector<int> samples;
+  volatile int nsamples=0;
+  volatile int cur=0;
+  int usecs;
+  Mode _mode;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// enter() on construction and leave() on destruction, so a throw
+// out of eval() closes the site
+struct Probe {
+#if DSL_PROFILE
+  template<typename F>
+  Probe(IEvaluator* e, const Node* n, F&& where) : p(e->profiler) {
+    if (p) { p->enter(n, where); }
+  }
+  ~Probe() { if (p) { p->leave(); } }
+  private:
+  Profiler* p;
+#else
+  template<typename F>
+  Probe(IEvaluator*, const Node*, F&&) {}
+#endif
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,411 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <typeinfo>
+#include "vm.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+namespace a=czlab::aeon;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Operand Node::compile(Assembler*, int) {
+  RAISE(Unsupported, "No bytecode for %s", typeid(*this).name());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Node::compileJump(Assembler* a, bool when) {
+  auto t= a->top();
+  auto r= compile(a, -1);
+  a->release(t);
+  return a->emit(when ? OP_JT : OP_JF, r.reg, 0, -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Assembler::compile(cstdstr& name, DTable scope, DAst root) {
+  protos.clear();
+  _bodies.clear();
+  _fns.clear();
+  Proto p;
+  p.name= name;
+  p.scope= scope;
+  p.nslots= scope ? scope->size() : 0;
+  s__conj(protos, p);
+  s__conj(_bodies, root);
+  // procedures found along the way are appended
+  for (size_t i=0; i < protos.size(); ++i) {
+    body(i, _bodies[i]);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Assembler::body(int n, DAst b) {
+  _cur= n;
+  _top= code().nslots;
+  code().nregs= _top;
+  b->compile(this, -1);
+  emit(OP_RET);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Assembler::proto(DSymbol fn) {
+  if (auto i= _fns.find(fn.get()); i != _fns.end()) {
+    return i->second;
+  }
+  auto f= DCAST(FnSymbol, fn);
+  auto s= f->scope();
+  Proto p;
+  p.name= f->name();
+  p.scope= s;
+  p.nslots= s->size();
+  for (auto& x : f->params()) {
+    s__conj(p.params, s->slot(x->name()));
+  }
+  auto n= (int) protos.size();
+  s__conj(protos, p);
+  s__conj(_bodies, f->body());
+  _fns[fn.get()]= n;
+  return n;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Assembler::call(int proto, int base, int argc, int depth) {
+  auto& c= code().calls;
+  CallSite s {proto, base, argc, depth};
+  s__conj(c, s);
+  return (int) c.size() - 1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Assembler::emit(int op, int a, int b, int c) {
+  auto& v= code().code;
+  Instr x {op, a, b, c};
+  s__conj(v, x);
+  return (int) v.size() - 1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Assembler::konst(const Value& v) {
+  auto& k= code().consts;
+  s__conj(k, v);
+  return (int) k.size() - 1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Assembler::temp() {
+  auto r= _top++;
+  if (_top > code().nregs) { code().nregs= _top; }
+  return r;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Operand Assembler::load(const LexAddr& x, int kind, int dst) {
+  if (x.depth == 0) {
+    if (dst >= 0 && dst != x.slot) {
+      emit(OP_MOVE, dst, x.slot);
+      return Operand{dst, kind};
+    }
+    return Operand{x.slot, kind};
+  }
+  auto r= dst < 0 ? temp() : dst;
+  emit(OP_GETUP, r, x.depth, x.slot);
+  return Operand{r, kind};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Assembler::store(const LexAddr& x, int src) {
+  if (x.depth != 0) {
+    emit(OP_SETUP, src, x.depth, x.slot);
+  } else if (src != x.slot) {
+    emit(OP_MOVE, x.slot, src);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Assembler::convert(int dst, const Operand& x, int kind) {
+  if (kind == K_ANY || kind == x.kind) {
+    if (dst != x.reg) { emit(OP_MOVE, dst, x.reg); }
+  } else if (x.kind == K_INT && kind == K_REAL) {
+    emit(OP_I2R, dst, x.reg);
+  } else if (x.kind == K_REAL && kind == K_INT) {
+    emit(OP_R2I, dst, x.reg);
+  } else {
+    RAISE(Unsupported,
+          "No bytecode for kind %d to %d", x.kind, kind);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Assembler::coerce(const Operand& x, int kind) {
+  if (kind == K_ANY || kind == x.kind) { return x.reg; }
+  auto r= temp();
+  convert(r, x, kind);
+  return r;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Assembler::kindOf(DSymbol t) {
+  if (!t) { return K_ANY; }
+  auto n= t->name();
+  return n == "INTEGER" ? K_INT
+         : (n == "REAL" ? K_REAL : (n == "STRING" ? K_STR : K_ANY));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// writes keep the register's box only if it is the same value
+inline void setI(Value& v, llong n) {
+  if (v.heap) { v.heap.reset(); }
+  v.tag= V_INT;
+  v.n= n;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+inline void setR(Value& v, double d) {
+  if (v.heap) { v.heap.reset(); }
+  v.tag= V_REAL;
+  v.r= d;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// same as toBool() in the front ends, reals are truncated
+inline bool truthy(const Value& v) {
+  return v.tag == V_REAL
+         ? ((llong) v.r != 0) : ((v.tag == V_INT || v.tag == V_BOOL) && v.n != 0);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+const Value& number(const Value& v) {
+  if (!v.isNumber()) {
+    auto x= v.box();
+    RAISE(BadArg,
+          "Wanted `%s`, got %s", "number", x ? C_STR(x->pr_str(1)) : "null");
+  }
+  return v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void VM::ensure(size_t n) {
+  if (stack.size() < n) {
+    stack.resize(std::max(n, 2 * stack.size()));
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value* VM::frameAt(int hops, int from) {
+  while (hops > 0) {
+    from= frames[from].outer;
+    --hops;
+  }
+  return stack.data() + frames[from].base;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+#if defined(__GNUC__)
+#define VM_CASE(x) L_##x:
+#define VM_NEXT do { i= ip++; goto *JUMPS[i->op]; } while (0)
+#else
+#define VM_CASE(x) case OP_##x:
+#define VM_NEXT continue
+#endif
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+#define VM_ARITH(op, set, f, x) \
+  VM_CASE(op) { set(R[i->a], R[i->b].f x R[i->c].f); } VM_NEXT;
+
+#define VM_COMPARE(op, f, x) \
+  VM_CASE(op) { setI(R[i->a], R[i->b].f x R[i->c].f); } VM_NEXT;
+
+#define VM_BRANCH(op, f, x) \
+  VM_CASE(op) { if (R[i->a].f x R[i->b].f) { ip= code + i->c; } } VM_NEXT;
+
+#define VM_GENERIC(op, x) \
+  VM_CASE(op) { \
+    auto& l= number(R[i->b]); \
+    auto& r= number(R[i->c]); \
+    if (l.tag == V_INT && r.tag == V_INT) { setI(R[i->a], l.n x r.n); } \
+    else { setR(R[i->a], l.getFloat() x r.getFloat()); } } VM_NEXT;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void VM::run() {
+#if defined(__GNUC__)
+#define DSL_OP_LABEL(x) &&L_##x,
+  static const void* JUMPS[]= { DSL_OPCODES(DSL_OP_LABEL) &&L_END };
+#undef DSL_OP_LABEL
+#endif
+  frames.clear();
+  line.clear();
+  ensure(protos[0].nregs);
+  frames.push_back(CallInfo{0, 0, -1, P_NIL});
+
+  auto P= &protos[0];
+  auto code= P->code.data();
+  auto K= P->consts.data();
+  auto R= stack.data();
+  auto ip= code;
+  const Instr* i= P_NIL;
+
+#if defined(__GNUC__)
+  VM_NEXT;
+  {
+#else
+  for (;;) { i= ip++; switch (i->op) {
+#endif
+
+  VM_CASE(NOP) VM_NEXT;
+  VM_CASE(MOVE) { R[i->a]= R[i->b]; } VM_NEXT;
+  VM_CASE(NIL) { R[i->a]= Value(); } VM_NEXT;
+  VM_CASE(LOADI) { setI(R[i->a], i->b); } VM_NEXT;
+  VM_CASE(LOADK) { R[i->a]= K[i->b]; } VM_NEXT;
+  VM_CASE(GETUP) {
+    R[i->a]= frameAt(i->b, frames.size()-1)[i->c];
+  } VM_NEXT;
+  VM_CASE(SETUP) {
+    frameAt(i->b, frames.size()-1)[i->c]= R[i->a];
+  } VM_NEXT;
+
+  VM_ARITH(ADDI, setI, n, +)
+  VM_ARITH(SUBI, setI, n, -)
+  VM_ARITH(MULI, setI, n, *)
+  VM_CASE(DIVI) {
+    ASSERT(R[i->c].n != 0,
+           "Div by int-zero error, %s", C_STR(N_STR(R[i->c].n)));
+    setI(R[i->a], R[i->b].n / R[i->c].n);
+  } VM_NEXT;
+  VM_ARITH(ADDR, setR, r, +)
+  VM_ARITH(SUBR, setR, r, -)
+  VM_ARITH(MULR, setR, r, *)
+  VM_CASE(DIVR) {
+    ASSERT(!a::fuzzy_zero(R[i->c].r),
+           "Div by zero error, %s", C_STR(N_STR(R[i->c].r)));
+    setR(R[i->a], R[i->b].r / R[i->c].r);
+  } VM_NEXT;
+  VM_CASE(ADDKI) { setI(R[i->a], R[i->b].n + i->c); } VM_NEXT;
+  VM_CASE(NEGI) { setI(R[i->a], - R[i->b].n); } VM_NEXT;
+  VM_CASE(NEGR) { setR(R[i->a], - R[i->b].r); } VM_NEXT;
+  VM_CASE(I2R) { setR(R[i->a], (double) R[i->b].n); } VM_NEXT;
+  VM_CASE(R2I) { setI(R[i->a], (llong) R[i->b].r); } VM_NEXT;
+
+  VM_GENERIC(ADD, +)
+  VM_GENERIC(SUB, -)
+  VM_GENERIC(MUL, *)
+  VM_CASE(DIV) {
+    setR(R[i->a], number(R[i->b]).getFloat() / number(R[i->c]).getFloat());
+  } VM_NEXT;
+  VM_CASE(QUO) {
+    setI(R[i->a],
+         (llong) (number(R[i->b]).getFloat() / number(R[i->c]).getFloat()));
+  } VM_NEXT;
+  VM_CASE(NEG) {
+    auto& x= number(R[i->b]);
+    if (x.tag == V_INT) { setI(R[i->a], - x.n); } else { setR(R[i->a], - x.r); }
+  } VM_NEXT;
+  VM_CASE(NUM) { R[i->a]= number(R[i->b]); } VM_NEXT;
+
+  VM_COMPARE(LTI, n, <)
+  VM_COMPARE(LEI, n, <=)
+  VM_COMPARE(EQI, n, ==)
+  VM_COMPARE(NEI, n, !=)
+  VM_COMPARE(LTR, r, <)
+  VM_COMPARE(LER, r, <=)
+  VM_COMPARE(EQR, r, ==)
+  VM_COMPARE(NER, r, !=)
+
+  VM_BRANCH(BLTI, n, <)
+  VM_BRANCH(BLEI, n, <=)
+  VM_BRANCH(BEQI, n, ==)
+  VM_BRANCH(BNEI, n, !=)
+  VM_BRANCH(BLTR, r, <)
+  VM_BRANCH(BLER, r, <=)
+  VM_BRANCH(BEQR, r, ==)
+  VM_BRANCH(BNER, r, !=)
+
+  VM_CASE(JMP) { ip= code + i->c; } VM_NEXT;
+  VM_CASE(JT) { if (truthy(R[i->a])) { ip= code + i->c; } } VM_NEXT;
+  VM_CASE(JF) { if (!truthy(R[i->a])) { ip= code + i->c; } } VM_NEXT;
+  VM_CASE(NOT) { setI(R[i->a], truthy(R[i->b]) ? 0 : 1); } VM_NEXT;
+  VM_CASE(TRUTH) { setI(R[i->a], truthy(R[i->b]) ? 1 : 0); } VM_NEXT;
+
+  VM_CASE(PUT) {
+    auto& v= R[i->a];
+    if (v.tag == V_INT) {
+      line += N_STR(v.n);
+    } else if (v.tag == V_REAL) {
+      line += N_STR(v.r);
+    } else if (auto x= v.box(); x) {
+      line += x->pr_str();
+    }
+  } VM_NEXT;
+  VM_CASE(FLUSH) {
+    host->write(line);
+    if (i->a) { host->writeln(); }
+    line.clear();
+  } VM_NEXT;
+  VM_CASE(READ) { R[i->a]= host->input(i->b); } VM_NEXT;
+
+  VM_CASE(CALL) {
+    auto& s= P->calls[i->a];
+    auto& q= protos[s.proto];
+    auto cur= (int) frames.size() - 1;
+    auto base= frames[cur].base + P->nregs;
+    ensure(base + q.nregs);
+    R= stack.data() + frames[cur].base;
+    auto W= stack.data() + base;
+    // the callee starts clean, args go to its param slots
+    for (auto k=0; k < q.nslots; ++k) { W[k]= Value(); }
+    for (auto k=0; k < s.argc; ++k) { W[q.params[k]]= R[s.base+k]; }
+    auto outer= cur;
+    for (auto h= s.depth; h > 0; --h) { outer= frames[outer].outer; }
+    frames[cur].ret= ip;
+    frames.push_back(CallInfo{s.proto, base, outer, P_NIL});
+    P= &q;
+    code= ip= P->code.data();
+    K= P->consts.data();
+    R= W;
+  } VM_NEXT;
+
+  VM_CASE(RET) {
+    host->leave(*P, R);
+    frames.pop_back();
+    if (frames.empty()) { return; }
+    auto& f= frames.back();
+    P= &protos[f.proto];
+    code= P->code.data();
+    K= P->consts.data();
+    R= stack.data() + f.base;
+    ip= f.ret;
+  } VM_NEXT;
+
+  VM_CASE(END) { return; }
+
+#if defined(__GNUC__)
+  }
+#else
+  default: return; } }
+#endif
+}
+
+#undef VM_GENERIC
+#undef VM_BRANCH
+#undef VM_COMPARE
+#undef VM_ARITH
+#undef VM_NEXT
+#undef VM_CASE
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,209 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include "dsl.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::dsl {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// A register machine for the analyzed syntax trees.
+//
+// Every procedure becomes a Proto, its frame is a window of
+// registers on one contiguous stack, the first registers are
+// the slots of its scope (see Table::resolve), temporaries
+// follow.  Ops named ..I and ..R assume ints and reals, the
+// compiler picks them from the analyzer's type symbols, the
+// rest check the tags at run time.
+//
+//  a,b,c are registers unless noted
+#define DSL_OPCODES(X) \
+  X(NOP) \
+  X(MOVE)  /* a=b */ \
+  X(NIL)   /* a=nil */ \
+  X(LOADI) /* a=int b */ \
+  X(LOADK) /* a=const b */ \
+  X(GETUP) /* a=slot c of the frame b hops out */ \
+  X(SETUP) /* slot c of the frame b hops out=a */ \
+  X(ADDI) X(SUBI) X(MULI) X(DIVI) \
+  X(ADDR) X(SUBR) X(MULR) X(DIVR) \
+  X(ADDKI) /* a=b+int c */ \
+  X(NEGI) X(NEGR) \
+  X(I2R) X(R2I) \
+  X(ADD) X(SUB) X(MUL) X(DIV) X(NEG) \
+  X(QUO)   /* a=b/c truncated */ \
+  X(NUM)   /* a=b, which must be a number */ \
+  X(LTI) X(LEI) X(EQI) X(NEI) \
+  X(LTR) X(LER) X(EQR) X(NER) \
+  X(BLTI) X(BLEI) X(BEQI) X(BNEI) /* goto c if a op b */ \
+  X(BLTR) X(BLER) X(BEQR) X(BNER) \
+  X(JMP)   /* goto c */ \
+  X(JT) X(JF) /* goto c if a is, or is not, true */ \
+  X(NOT) X(TRUTH) /* a=0 or 1 */ \
+  X(PUT)   /* print a to the line buffer */ \
+  X(FLUSH) /* write the line buffer, a newline if a */ \
+  X(READ)  /* a=input of kind b */ \
+  X(CALL)  /* call site a */ \
+  X(RET)
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+enum OpCode {
+#define DSL_OP_ENUM(x) OP_##x,
+  DSL_OPCODES(DSL_OP_ENUM)
+#undef DSL_OP_ENUM
+  OP_END
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the static kind of a register
+enum ValueKind {
+  K_ANY=0,
+  K_INT,
+  K_REAL,
+  K_STR
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Instr {
+  int op;
+  int a;
+  int b;
+  int c;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct CallSite {
+  int proto;
+  // args sit in consecutive registers
+  int base;
+  int argc;
+  // hops from the caller to the callee's declaring frame
+  int depth;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Proto {
+  stdstr name;
+  DTable scope;
+  std::vector<Instr> code;
+  std::vector<Value> consts;
+  std::vector<CallSite> calls;
+  // the slots the args go to
+  std::vector<int> params;
+  int nslots=0;
+  int nregs=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// what the machine needs from the language
+struct IHost {
+  virtual void write(cstdstr&) {}
+  virtual void writeln() {}
+  virtual Value input(int kind) { return Value(); }
+  // a frame is done with, slots are its scope's slots
+  virtual void leave(const Proto&, const Value* slots) {}
+  virtual ~IHost() {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Assembler {
+
+  // the entry point, proto 0, then every procedure it reaches,
+  // throws Unsupported if some node has no bytecode
+  void compile(cstdstr& name, DTable scope, DAst body);
+
+  // a procedure's proto, its body is compiled after the current one
+  int proto(DSymbol fn);
+  int call(int proto, int base, int argc, int depth);
+
+  int emit(int op, int a=0, int b=0, int c=0);
+  int here() const { return (int) code().code.size(); }
+  // point the jump at pc to here, or to another pc
+  void patch(int pc) { patch(pc, here()); }
+  void patch(int pc, int to) { code().code[pc].c= to; }
+  int konst(const Value&);
+
+  // temporaries are handed out as a stack
+  int temp();
+  int top() const { return _top; }
+  void release(int t) { _top=t; }
+
+  // a resolved variable, dst < 0 takes any register
+  Operand load(const LexAddr&, int kind, int dst);
+  void store(const LexAddr&, int src);
+
+  // copy into dst as the wanted kind, K_ANY keeps it as is
+  void convert(int dst, const Operand&, int kind);
+  // a register of the wanted kind, may be the operand's own
+  int coerce(const Operand&, int kind);
+
+  // the kind for a type symbol named INTEGER, REAL or STRING
+  static int kindOf(DSymbol type);
+
+  Proto& code() { return protos[_cur]; }
+  const Proto& code() const { return protos[_cur]; }
+
+  std::vector<Proto> protos;
+
+  Assembler() {}
+
+  private:
+
+  void body(int, DAst);
+
+  std::map<Symbol*, int> _fns;
+  std::vector<DAst> _bodies;
+  int _cur=0;
+  int _top=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct VM {
+
+  // runs proto 0 to the end
+  void run();
+
+  VM(const std::vector<Proto>& p, IHost* h) : protos(p), host(h) {}
+  ~VM() {}
+
+  private:
+
+  struct CallInfo {
+    int proto;
+    int base;
+    // the declaring frame
+    int outer;
+    const Instr* ret;
+  };
+
+  Value* frameAt(int hops, int from);
+  void ensure(size_t);
+
+  const std::vector<Proto>& protos;
+  std::vector<CallInfo> frames;
+  std::vector<Value> stack;
+  stdstr line;
+  IHost* host;
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
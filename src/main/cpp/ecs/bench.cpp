@@ -0,0 +1,187 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include "spatial.h"
+#include "cluster.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::ecs {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace e= czlab::ecs;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Position : public e::Component {
+  Position(const Vec3& p) : p(p) {}
+  Vec3 pos() const { return p; }
+  virtual ~Position() {}
+  Vec3 p;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct BenchWorld : public e::Engine {
+  BenchWorld(int n) : _count(n) {}
+  virtual ~BenchWorld() {}
+
+  virtual void initEnts() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> u(0, 1000);
+    for (auto i=0; i < _count; ++i) {
+      rego()->bind<Position>(new Position(Vec3(u(rng),u(rng),u(rng))), reifyEnt());
+    }
+  }
+
+  virtual void initSystems() {}
+
+  int _count;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the full scan we are trying to beat, straight over the
+// components so only the search itself is compared
+size_t bruteRadius(Engine* g, const Vec3& c, float r) {
+  size_t n=0;
+  auto m= g->rego()->getCache<Position>();
+  for (auto i=m->begin(),e=m->end();i!=e;++i) {
+    auto p= s__cast(Position, i->second.ptr())->pos();
+    auto dx= p.x-c.x, dy= p.y-c.y, dz= p.z-c.z;
+    if (dx*dx+dy*dy+dz*dz <= r*r) { ++n; }
+  }
+  return n;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename F>
+double usecs(F f, int reps) {
+  auto t= std::chrono::steady_clock::now();
+  for (auto i=0; i < reps; ++i) { f(i); }
+  std::chrono::duration<double,std::micro> d= std::chrono::steady_clock::now() - t;
+  return d.count() / reps;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void bench(int n) {
+  BenchWorld w(n);
+  w.ignite();
+
+  UniformGrid grid(25);
+  LooseTree tree(AABB(Vec3(0,0,0),Vec3(1000,1000,1000)));
+  SpatialSync<Position> gs(&w, &grid);
+  SpatialSync<Position> ts(&w, &tree);
+  gs.rebuild();
+  ts.rebuild();
+
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> u(0, 1000);
+  std::vector<Vec3> qs;
+  for (auto i=0; i < 64; ++i) { s__conj(qs, Vec3(u(rng),u(rng),u(rng))); }
+
+  EidVec out;
+  auto brute= usecs([&](int i) { bruteRadius(&w, qs[i%64], 50); }, n > 100000 ? 2 : 8);
+  auto gr= usecs([&](int i) { out.clear(); grid.queryRadius(qs[i%64], 50, out); }, 256);
+  auto tr= usecs([&](int i) { out.clear(); tree.queryRadius(qs[i%64], 50, out); }, 256);
+  auto gk= usecs([&](int i) { out.clear(); grid.nearest(qs[i%64], 16, out); }, 256);
+  auto tk= usecs([&](int i) { out.clear(); tree.nearest(qs[i%64], 16, out); }, 256);
+
+  std::cout << "n=" << n
+            << " radius(us): brute=" << brute
+            << " grid=" << gr << " tree=" << tr
+            << " knn16(us): grid=" << gk << " tree=" << tk << "\n";
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// moves every position each frame and pings the next world
+struct Drift : public e::System {
+  Drift(Engine* e) : System(e) {}
+  virtual int priority() const { return 1; }
+  virtual void preamble() {}
+  virtual bool update(float dt) {
+    auto m= engine()->rego()->getCache<Position>();
+    for (auto i=m->begin(),e=m->end();i!=e;++i) {
+      auto p= s__cast(Position, i->second.ptr());
+      p->p.x += dt;
+      p->p.y += p->p.x * 0.5f;
+    }
+    if (auto c= engine()->cluster(); c && c->size() > 1) {
+      auto me= engine()->worldId();
+      c->send(me, (me+1) % c->size(), j::json(frames));
+    }
+    ++frames;
+    return true;
+  }
+  size_t frames=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct DriftWorld : public BenchWorld {
+  DriftWorld(int n) : BenchWorld(n) {}
+  virtual void initSystems() {
+    drift= new Drift(this);
+    addSystem(drift);
+  }
+  Drift* drift=P_NIL;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// entity updates a second for 1..max worlds of n entities each,
+// worlds spin with no step, scaling is against one world and
+// can only be linear up to the number of cores
+void benchCluster(int n, int max) {
+  double one=0;
+  for (auto k=1; k <= max; k *= 2) {
+    Cluster c;
+    std::vector<DriftWorld*> ws;
+    for (auto i=0; i < k; ++i) {
+      auto w= new DriftWorld(n);
+      c.addWorld(w);
+      w->ignite();
+      s__conj(ws, w);
+    }
+    auto t= std::chrono::steady_clock::now();
+    c.start(0, true);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    c.stop();
+    std::chrono::duration<double> d= std::chrono::steady_clock::now() - t;
+    size_t frames=0;
+    for (auto w : ws) { frames += w->drift->frames; }
+    auto rate= frames * (double) n / d.count();
+    if (k == 1) { one= rate; }
+    std::cout << "worlds=" << k << " n=" << n
+              << " updates/s=" << rate
+              << " scaling=" << rate / one
+              << " cores=" << std::thread::hardware_concurrency() << "\n";
+  }
+}
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+#if 0
+using namespace czlab::ecs;
+
+int main(int ac, char** av) {
+  for (auto n : {10000, 100000, 1000000}) { bench(n); }
+  benchCluster(10000, 8);
+  return 0;
+}
+#endif
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,195 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+#include "cluster.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::ecs {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+typedef std::vector<Message> MsgVec;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Shard {
+  Engine* world;
+  std::thread thread;
+  // filled by other worlds, one lock per batch
+  std::mutex lock;
+  MsgVec inbox;
+  // by destination, touched only by this world's thread
+  std::vector<MsgVec> outbox;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Cluster::~Cluster() {
+  stop();
+  for (auto s : _shards) {
+    DEL_PTR(s->world);
+    DEL_PTR(s);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Cluster::addWorld(Engine* w) {
+  assert(!_running);
+  auto s= new Shard();
+  auto id= (int) _shards.size();
+  s->world= w;
+  w->_cluster= this;
+  w->_worldId= id;
+  s__conj(_shards, s);
+  for (auto x : _shards) {
+    x->outbox.resize(_shards.size());
+  }
+  return id;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Engine* Cluster::world(int id) const {
+  return (id >= 0 && id < (int) _shards.size()) ? _shards[id]->world : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::post(int from, int to, Message&& m) {
+  assert(from >= 0 && from < (int) _shards.size());
+  assert(to >= 0 && to < (int) _shards.size());
+  s__conj(_shards[from]->outbox[to], std::move(m));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::send(int from, int to, const j::json& body) {
+  post(from, to, Message{from, body, P_NIL});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::migrate(int from, int to, EEntity e) {
+  auto w= world(from);
+  auto m= new Migrant();
+  m->name= e->name();
+  m->parts= w->rego()->detach(e->id());
+  for (auto& p : m->parts) {
+    // another holder would race the receiver on the count
+    ASSERT(p.comp->refs() == 1,
+           "Migrating a shared component, entity= %s.", C_STR(m->name));
+  }
+  w->purgeEnt(e);
+  post(from, to, Message{from, j::json(), m});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::deliver(Shard* s) {
+  MsgVec batch;
+  {
+    std::lock_guard<std::mutex> g(s->lock);
+    batch.swap(s->inbox);
+  }
+  auto w= s->world;
+  for (auto& m : batch) {
+    if (m.ent.isSome()) {
+      // a fresh id in this world's id space
+      auto e= w->reifyEnt(m.ent->name);
+      for (auto& p : m.ent->parts) {
+        w->rego()->bind(p, e);
+      }
+      w->onArrive(e, m.from);
+    } else {
+      w->onMessage(m.from, m.body);
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::flush(Shard* s) {
+  for (size_t i=0; i < s->outbox.size(); ++i) {
+    auto& out= s->outbox[i];
+    if (out.empty()) { continue; }
+    auto d= _shards[i];
+    std::lock_guard<std::mutex> g(d->lock);
+    if (d->inbox.empty()) {
+      d->inbox.swap(out);
+    } else {
+      std::move(out.begin(), out.end(), std::back_inserter(d->inbox));
+      // refcounts are not atomic, let go before the receiver can see them
+      out.clear();
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::step(Shard* s, float dt) {
+  deliver(s);
+  s->world->update(dt);
+  flush(s);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::tick(float dt) {
+  for (auto s : _shards) { step(s, dt); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::run(Shard* s, float dt) {
+  auto gap= std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float>(dt));
+  auto next= std::chrono::steady_clock::now();
+  while (_running) {
+    step(s, dt);
+    next += gap;
+    std::this_thread::sleep_until(next);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::start(float dt, bool pin) {
+  if (_running) { return; }
+  _running= true;
+  auto cpus= std::thread::hardware_concurrency();
+  for (size_t i=0; i < _shards.size(); ++i) {
+    auto s= _shards[i];
+    s->thread= std::thread([this,s,dt]() { run(s,dt); });
+#if defined(__linux__)
+    if (pin && cpus > 0) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(i % cpus, &set);
+      ::pthread_setaffinity_np(s->thread.native_handle(), sizeof(set), &set);
+    }
+#endif
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Cluster::stop() {
+  if (!_running) { return; }
+  _running= false;
+  for (auto s : _shards) {
+    if (s->thread.joinable()) { s->thread.join(); }
+  }
+  // nothing is left in flight
+  for (auto s : _shards) { deliver(s); }
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,98 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include "types.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::ecs {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace a= czlab::aeon;
+namespace j= nlohmann;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// an entity on its way to another world
+struct MSVC_DLL Migrant : public a::Counted {
+  stdstr name;
+  std::vector<CompPart> parts;
+  virtual ~Migrant() {}
+  Migrant() {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Message {
+  int from;
+  j::json body;
+  a::RefPtr<Migrant> ent;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Shard;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a set of independent worlds, each owns its entities and
+// may run on its own thread, worlds talk only through
+// messages which are batched and delivered once per tick
+struct MSVC_DLL Cluster {
+
+  // add a world, the cluster takes ownership, not after start()
+  int addWorld(Engine*);
+
+  Engine* world(int) const;
+  size_t size() const { return _shards.size(); }
+
+  // both are called from the sending world's thread,
+  // delivered at the receiver's next tick
+  void send(int from, int to, const j::json&);
+  // a::Counted is not atomic, so the entity's components must
+  // be held by the registry alone, asserted, never by a system
+  void migrate(int from, int to, EEntity);
+
+  // one thread per world ticking at a fixed step,
+  // pin binds world i to cpu i where supported
+  void start(float step, bool pin=false);
+  void stop();
+  bool isRunning() const { return _running; }
+
+  // single threaded, one tick of every world in order
+  void tick(float step);
+
+  virtual ~Cluster();
+  Cluster() {}
+
+  private:
+
+  void run(Shard*, float);
+  void step(Shard*, float);
+  void deliver(Shard*);
+  void flush(Shard*);
+  void post(int from, int to, Message&&);
+
+  std::vector<Shard*> _shards;
+  std::atomic<bool> _running {false};
+
+  Cluster(const Cluster&)=delete;
+  Cluster& operator=(const Cluster&)=delete;
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
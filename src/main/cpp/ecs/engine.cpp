@@ -12,7 +12,8 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
-#include "types.h"
+#include <cmath>
+#include "events.h"
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::ecs {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -33,10 +34,16 @@ bool _compSystem(ESystem lhs, ESystem rhs) {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Engine::Engine() { _types= new Registry(); }
+Engine::Engine() {
+  _types= new Registry();
+  _events= new EventBus();
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Engine::~Engine() { DEL_PTR(_types); }
+Engine::~Engine() {
+  DEL_PTR(_events);
+  DEL_PTR(_types);
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 EntVec Engine::getEnts(const std::vector<Cid>& cs) const {
@@ -125,6 +132,90 @@ void Engine::purgeEnts() {
   _ents.clear();
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+MemReport Engine::memReport() const {
+  MemReport out;
+  double fw=0;
+  for (auto cid : _types->cids()) {
+    auto cs= _types->stats(cid);
+    if (auto m= _types->getCache(cid); m) {
+      for (auto i=m->begin(),e=m->end();i!=e;++i) {
+        if (!s__contains(_ents, i->first)) { ++cs.orphans; }
+      }
+    }
+    out.compBytes += cs.bytes + cs.mapBytes;
+    fw += cs.fragmentation * cs.bytes;
+    s__conj(out.comps, cs);
+  }
+  for (auto i=_ents.begin(),e=_ents.end();i!=e;++i) {
+    out.entBytes += sizeof(Entity) +
+                    i->second->_name.capacity() +
+                    sizeof(MapEidE::value_type) + 4*sizeof(void*);
+  }
+  out.liveEnts= _ents.size();
+  out.deadEnts= _garbo.size();
+  if (out.compBytes > 0) {
+    size_t z=0;
+    for (auto& c : out.comps) { z += c.bytes; }
+    out.fragmentation= z > 0 ? fw / z : 0;
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static void dropOrphans(Registry* r, const MapEidE& ents, Cid cid) {
+  std::vector<EntityId> dead;
+  if (auto m= r->getCache(cid); m) {
+    for (auto i=m->begin(),e=m->end();i!=e;++i) {
+      if (!s__contains(ents, i->first)) { s__conj(dead, i->first); }
+    }
+  }
+  for (auto eid : dead) { r->unbind(cid, eid); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Engine::compact() {
+  if (_updating) { return; }
+  for (auto cid : _types->cids()) {
+    dropOrphans(_types, _ents, cid);
+    _types->compact(cid);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Engine::compactStep(double threshold, size_t budget) {
+  if (_updating || budget == 0) { return false; }
+  while (1) {
+    if (_packing == 0) {
+      auto worst= threshold;
+      for (auto cid : _types->cids()) {
+        if (_types->pinned(cid)) { continue; }
+        auto cs= _types->stats(cid);
+        if (auto k= _stuck.find(cid); k != _stuck.end()) {
+          if (k->second == cs.count) { continue; }
+          _stuck.erase(k);
+        }
+        if (cs.fragmentation > worst) {
+          worst= cs.fragmentation;
+          _packing= cid;
+        }
+      }
+      if (_packing == 0) { return false; }
+      dropOrphans(_types, _ents, _packing);
+    }
+    bool done;
+    auto moved= _types->compact(_packing, budget, done);
+    if (done) {
+      // a pass didn't get it under, another one won't either
+      if (auto cs= _types->stats(_packing);
+          cs.fragmentation > threshold) { _stuck[_packing]= cs.count; }
+      _packing=0;
+    }
+    // nothing moved means that pass is over, so try the next type
+    if (moved > 0) { return true; }
+  }
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ESystem Engine::addSystem(ESystem arg) {
   auto p= arg->priority();
@@ -158,13 +249,31 @@ void Engine::purgeSystems() {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Engine::update(float time) {
+  auto ok=true;
   _updating = true;
-  for (auto i=_systems.begin(),e=_systems.end();i != e;++i) {
+  for (auto i=_systems.begin(),e=_systems.end();ok && i != e;++i) {
     auto s= *i;
-    if (s->isActive()) {
-      if (! s->update(time)) { break; }
+    if (! s->isActive()) { continue; }
+    auto rate= s->tickRate();
+    if (rate <= 0) {
+      ok= s->update(time);
+      continue;
+    }
+    auto step= 1.0f/rate;
+    auto n=0;
+    s->_accum += time;
+    while (s->_accum >= step) {
+      if (n == _maxCatchUp) {
+        // too far behind, drop the backlog
+        s->_accum= std::fmod(s->_accum, step);
+        break;
+      }
+      s->_accum -= step;
+      ++n;
+      if (! s->update(step)) { ok=false; break; }
     }
   }
+  _events->flip();
   _garbo.clear();
   _updating = false;
 }
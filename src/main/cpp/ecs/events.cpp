@@ -0,0 +1,73 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <mutex>
+#include "events.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::ecs {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static std::mutex _slotLock;
+static std::vector<int> _freeSlots;
+static int _lastSlot=0;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// owns the thread's slot, gives it back when the thread exits
+struct SlotHolder {
+  SlotHolder() {
+    std::lock_guard<std::mutex> g(_slotLock);
+    if (_freeSlots.empty()) {
+      slot= _lastSlot++;
+    } else {
+      slot= _freeSlots.back();
+      _freeSlots.pop_back();
+    }
+  }
+  ~SlotHolder() {
+    std::lock_guard<std::mutex> g(_slotLock);
+    s__conj(_freeSlots, slot);
+  }
+  int slot;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int eventSlot() {
+  thread_local SlotHolder h;
+  ASSERT(h.slot < MAX_EVENT_THREADS,
+         "Too many event producers, max= %d.", MAX_EVENT_THREADS);
+  return h.slot;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+EventBus::~EventBus() {
+  for (auto i=_queues.begin(),e=_queues.end();i!=e;++i) {
+    DEL_PTR(i->second);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void EventBus::flip() {
+  for (auto i=_queues.begin(),e=_queues.end();i!=e;++i) {
+    i->second->flip();
+  }
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
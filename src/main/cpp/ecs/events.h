@@ -0,0 +1,184 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include "types.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::ecs {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace a= czlab::aeon;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// max producer threads per queue
+const int MAX_EVENT_THREADS= 64;
+
+// small per-thread index, stable for the life of the thread,
+// handed on to a later thread once this one exits, so at most
+// MAX_EVENT_THREADS producers may be alive at the same time
+MSVC_DLL int eventSlot();
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct MSVC_DLL EventQueueBase {
+  // merge the producer buffers into the readable array,
+  // producers must be quiet while this runs
+  virtual void flip() = 0;
+  virtual ~EventQueueBase() {}
+  EventQueueBase() {}
+
+  private:
+
+  EventQueueBase(const EventQueueBase&)=delete;
+  EventQueueBase& operator=(const EventQueueBase&)=delete;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// events emitted this frame become readable after the next flip
+template<typename T>
+struct EventQueue : public EventQueueBase {
+
+  // safe from any thread, each thread appends to its own buffer
+  void emit(const T&);
+
+  // last frame's events, contiguous
+  const T* begin() const { return _front.data(); }
+  const T* end() const { return _front.data() + _front.size(); }
+  const T* data() const { return _front.data(); }
+  size_t size() const { return _front.size(); }
+  bool empty() const { return _front.empty(); }
+
+  virtual void flip();
+
+  virtual ~EventQueue();
+  EventQueue();
+
+  private:
+
+  // padded so producers do not share cache lines
+  struct alignas(64) Buffer {
+    std::vector<T> events;
+  };
+
+  std::atomic<Buffer*> _bufs[MAX_EVENT_THREADS];
+  std::vector<T> _front;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// typed queues keyed by event type, declare every type
+// before producers start so lookups never write
+struct MSVC_DLL EventBus {
+
+  template<typename T>
+  EventQueue<T>* declare();
+
+  template<typename T>
+  EventQueue<T>* queue() const;
+
+  // the type must have been declared, emit never adds a queue
+  template<typename T>
+  void emit(const T& e) {
+    auto q= queue<T>();
+    ASSERT(q, "Event type %s was never declared.", typeid(T).name());
+    q->emit(e);
+  }
+
+  // sync point, called by the engine after each update
+  void flip();
+
+  virtual ~EventBus();
+  EventBus() {}
+
+  private:
+
+  std::map<Cid, EventQueueBase*> _queues;
+  EventBus(const EventBus&)=delete;
+  EventBus& operator=(const EventBus&)=delete;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+EventQueue<T>::EventQueue() {
+  for (auto i=0; i < MAX_EVENT_THREADS; ++i) {
+    _bufs[i].store(P_NIL, std::memory_order_relaxed);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+EventQueue<T>::~EventQueue() {
+  for (auto i=0; i < MAX_EVENT_THREADS; ++i) {
+    auto b= _bufs[i].load(std::memory_order_relaxed);
+    DEL_PTR(b);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void EventQueue<T>::emit(const T& e) {
+  auto& slot= _bufs[eventSlot()];
+  auto b= slot.load(std::memory_order_acquire);
+  if (E_NIL(b)) {
+    // only this thread ever fills this slot
+    b= new Buffer();
+    slot.store(b, std::memory_order_release);
+  }
+  s__conj(b->events, e);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void EventQueue<T>::flip() {
+  _front.clear();
+  for (auto i=0; i < MAX_EVENT_THREADS; ++i) {
+    if (auto b= _bufs[i].load(std::memory_order_acquire); b) {
+      _front.insert(_front.end(), b->events.begin(), b->events.end());
+      // keep the capacity for the next frame
+      b->events.clear();
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+EventQueue<T>* EventBus::declare() {
+  auto cid= EntityFeature<T>::id();
+  if (auto i= _queues.find(cid); i != _queues.end()) {
+    return s__cast(EventQueue<T>, i->second);
+  }
+  auto q= new EventQueue<T>();
+  _queues[cid]= q;
+  return q;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+EventQueue<T>* EventBus::queue() const {
+  if (auto i= _queues.find(EntityFeature<T>::id()); i != _queues.end()) {
+    return s__cast(EventQueue<T>, i->second);
+  } else {
+    return NULL;
+  }
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -16,9 +16,6 @@
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::ecs {
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static EntityId _lastNodeId=0;
-
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Entity::Entity(Engine* e, const stdstr& n) : Entity (e) {
   this->_name=n;
@@ -27,7 +24,7 @@ Entity::Entity(Engine* e, const stdstr& n) : Entity (e) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Entity::Entity(Engine* e) {
   _engine=e;
-  _eid = ++_lastNodeId;
+  _eid = e->nextEid();
   _name = "node#" + std::to_string(_eid);
 }
 
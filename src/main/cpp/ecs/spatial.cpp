@@ -0,0 +1,550 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <cmath>
+#include <queue>
+#include <algorithm>
+#include "spatial.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::ecs {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+typedef std::pair<float,EntityId> DistEid;
+// max-heap on distance, holds the k best so far
+typedef std::priority_queue<DistEid> KBest;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static void offer(KBest& best, int k, float d, EntityId eid) {
+  if ((int) best.size() < k) {
+    best.push(DistEid(d,eid));
+  } else if (d < best.top().first) {
+    best.pop();
+    best.push(DistEid(d,eid));
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static void drain(KBest& best, EidVec& out) {
+  auto n= out.size();
+  out.resize(n + best.size());
+  for (auto i= out.size(); i > n; best.pop()) {
+    out[--i]= best.top().second;
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool AABB::contains(const Vec3& p) const {
+  return p.x >= lo.x && p.x <= hi.x &&
+         p.y >= lo.y && p.y <= hi.y &&
+         p.z >= lo.z && p.z <= hi.z;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+float SpatialIndex::dist2(const Vec3& a, const Vec3& b) const {
+  auto dx= a.x-b.x;
+  auto dy= a.y-b.y;
+  auto dz= _dims == 3 ? a.z-b.z : 0;
+  return dx*dx + dy*dy + dz*dz;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+const Vec3* SpatialIndex::where(EntityId eid) const {
+  auto s= _slots.find(eid);
+  return s != _slots.end() ? &s->second.pos : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void SpatialIndex::ids(EidVec& out) const {
+  for (auto& s : _slots) { s__conj(out, s.first); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void SpatialIndex::drop(ItemVec& v, EntityId eid) const {
+  for (auto i= v.begin(),e= v.end(); i != e; ++i) {
+    if (i->eid == eid) {
+      *i= v.back();
+      v.pop_back();
+      break;
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+UniformGrid::UniformGrid(float cellSize, int dims) : SpatialIndex(dims) {
+  _cellSize= cellSize > 0 ? cellSize : 1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+long UniformGrid::coord(float v) const {
+  return (long) std::floor(v / _cellSize);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+llong UniformGrid::cellKey(long x, long y, long z) const {
+  // 21 bits per axis, wraps around after 2M cells
+  const llong M= 0x1FFFFF;
+  return ((x & M) << 42) | ((y & M) << 21) | (z & M);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+llong UniformGrid::cellOf(const Vec3& p) const {
+  return cellKey(coord(p.x),
+                 coord(p.y), _dims == 3 ? coord(p.z) : 0);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UniformGrid::insert(EntityId eid, const Vec3& p) {
+  if (contains(eid)) {
+    return move(eid,p);
+  }
+  auto k= cellOf(p);
+  s__conj(_cells[k], Item(eid,p));
+  _slots[eid]= Slot{p,k};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UniformGrid::move(EntityId eid, const Vec3& p) {
+  auto s= _slots.find(eid);
+  if (s == _slots.end()) {
+    return insert(eid,p);
+  }
+  auto k= cellOf(p);
+  auto& slot= s->second;
+  if (k == slot.cell) {
+    for (auto& x : _cells[k]) {
+      if (x.eid == eid) { x.pos= p; break; }
+    }
+  } else {
+    auto& old= _cells[slot.cell];
+    drop(old, eid);
+    if (old.empty()) { _cells.erase(slot.cell); }
+    s__conj(_cells[k], Item(eid,p));
+    slot.cell= k;
+  }
+  slot.pos= p;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UniformGrid::remove(EntityId eid) {
+  if (auto s= _slots.find(eid); s != _slots.end()) {
+    auto k= s->second.cell;
+    auto& c= _cells[k];
+    drop(c, eid);
+    if (c.empty()) { _cells.erase(k); }
+    _slots.erase(s);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UniformGrid::clear() {
+  _cells.clear();
+  _slots.clear();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UniformGrid::queryBox(const AABB& b, EidVec& out) const {
+  auto x0= coord(b.lo.x), x1= coord(b.hi.x);
+  auto y0= coord(b.lo.y), y1= coord(b.hi.y);
+  auto z0= _dims == 3 ? coord(b.lo.z) : 0;
+  auto z1= _dims == 3 ? coord(b.hi.z) : 0;
+  auto lo= b.lo, hi= b.hi;
+  if (_dims == 2) { lo.z= hi.z= 0; }
+  AABB bx(lo,hi);
+  auto n= (double)(x1-x0+1) * (y1-y0+1) * (z1-z0+1);
+
+  if (n > _cells.size()) {
+    // the box spans more cells than we have, walk them all
+    for (auto& c : _cells) {
+      for (auto& x : c.second) {
+        auto p= x.pos;
+        if (_dims == 2) { p.z=0; }
+        if (bx.contains(p)) { s__conj(out, x.eid); }
+      }
+    }
+    return;
+  }
+
+  for (auto x=x0; x <= x1; ++x)
+  for (auto y=y0; y <= y1; ++y)
+  for (auto z=z0; z <= z1; ++z) {
+    if (auto c= _cells.find(cellKey(x,y,z)); c != _cells.end()) {
+      for (auto& i : c->second) {
+        auto p= i.pos;
+        if (_dims == 2) { p.z=0; }
+        if (bx.contains(p)) { s__conj(out, i.eid); }
+      }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UniformGrid::queryRadius(const Vec3& c, float r, EidVec& out) const {
+  auto x0= coord(c.x-r), x1= coord(c.x+r);
+  auto y0= coord(c.y-r), y1= coord(c.y+r);
+  auto z0= _dims == 3 ? coord(c.z-r) : 0;
+  auto z1= _dims == 3 ? coord(c.z+r) : 0;
+  auto n= (double)(x1-x0+1) * (y1-y0+1) * (z1-z0+1);
+  auto r2= r*r;
+
+  if (n > _cells.size()) {
+    for (auto& k : _cells) {
+      for (auto& i : k.second) {
+        if (dist2(c, i.pos) <= r2) { s__conj(out, i.eid); }
+      }
+    }
+    return;
+  }
+
+  for (auto x=x0; x <= x1; ++x)
+  for (auto y=y0; y <= y1; ++y)
+  for (auto z=z0; z <= z1; ++z) {
+    if (auto k= _cells.find(cellKey(x,y,z)); k != _cells.end()) {
+      for (auto& i : k->second) {
+        if (dist2(c, i.pos) <= r2) { s__conj(out, i.eid); }
+      }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UniformGrid::nearest(const Vec3& c, int k, EidVec& out) const {
+  if (k <= 0 || _slots.empty()) { return; }
+  auto cx= coord(c.x), cy= coord(c.y);
+  auto cz= _dims == 3 ? coord(c.z) : 0;
+  size_t seen=0;
+  KBest best;
+
+  // grow a shell of cells around the query point, anything beyond
+  // shell r is at least r cells away
+  for (long r=0; ; ++r) {
+    auto side= (double) (2*r+1);
+    auto n= _dims == 3 ? side*side*side : side*side;
+    if (n > 4.0 * _cells.size()) {
+      // sparse world, cheaper to look at everything
+      best= KBest();
+      for (auto& x : _cells) {
+        for (auto& i : x.second) {
+          offer(best, k, dist2(c, i.pos), i.eid);
+        }
+      }
+      break;
+    }
+    auto zr= _dims == 3 ? r : 0;
+    for (auto x= -r; x <= r; ++x)
+    for (auto y= -r; y <= r; ++y) {
+      auto edge= x == -r || x == r || y == -r || y == r;
+      // inside the shell only the z faces are new
+      if (!edge && zr == 0) { continue; }
+      auto step= edge ? 1 : 2*zr;
+      for (auto z= -zr; z <= zr; z += step) {
+        if (auto q= _cells.find(cellKey(cx+x,cy+y,cz+z)); q != _cells.end()) {
+          for (auto& i : q->second) {
+            offer(best, k, dist2(c, i.pos), i.eid);
+          }
+          seen += q->second.size();
+        }
+      }
+    }
+    auto reach= r * _cellSize;
+    if (seen >= _slots.size() ||
+        ((int) best.size() == k && best.top().first <= reach*reach)) {
+      break;
+    }
+  }
+
+  drain(best, out);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+LooseTree::LooseTree(const AABB& world,
+                     int dims, int leafCap, int maxDepth) : SpatialIndex(dims) {
+  _world= world;
+  _leafCap= leafCap > 0 ? leafCap : 1;
+  _maxDepth= maxDepth;
+  clear();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::clear() {
+  auto& w= _world;
+  Node root;
+  root.mid= Vec3((w.lo.x+w.hi.x)/2,
+                 (w.lo.y+w.hi.y)/2, _dims == 3 ? (w.lo.z+w.hi.z)/2 : 0);
+  root.half= std::max(w.hi.x-w.lo.x, w.hi.y-w.lo.y);
+  if (_dims == 3) { root.half= std::max(root.half, w.hi.z-w.lo.z); }
+  root.half /= 2;
+  root.depth=0;
+  root.kids= -1;
+  root.parent= -1;
+  root.count=0;
+  _nodes.clear();
+  _free.clear();
+  _slots.clear();
+  s__conj(_nodes, root);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int LooseTree::childOf(const Node& n, const Vec3& p) const {
+  return (p.x >= n.mid.x ? 1 : 0) |
+         (p.y >= n.mid.y ? 2 : 0) |
+         (_dims == 3 && p.z >= n.mid.z ? 4 : 0);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool LooseTree::looseHas(const Node& n, const Vec3& p) const {
+  // the root takes anything, even outside the world
+  if (&n == &_nodes[0]) { return true; }
+  auto h= 2*n.half;
+  return std::fabs(p.x-n.mid.x) <= h &&
+         std::fabs(p.y-n.mid.y) <= h &&
+         (_dims == 2 || std::fabs(p.z-n.mid.z) <= h);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+float LooseTree::boxDist2(const Node& n, const Vec3& p) const {
+  if (&n == &_nodes[0]) { return 0; }
+  auto h= 2*n.half;
+  auto dx= std::max(0.0f, std::fabs(p.x-n.mid.x) - h);
+  auto dy= std::max(0.0f, std::fabs(p.y-n.mid.y) - h);
+  auto dz= _dims == 3 ? std::max(0.0f, std::fabs(p.z-n.mid.z) - h) : 0;
+  return dx*dx + dy*dy + dz*dz;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::split(int ni) {
+  auto cnt= 1 << _dims;
+  auto first= (int) _nodes.size();
+  if (!_free.empty()) {
+    first= _free.back();
+    _free.pop_back();
+  }
+  for (auto i=0; i < cnt; ++i) {
+    auto& n= _nodes[ni];
+    auto q= n.half/2;
+    Node c;
+    c.mid= Vec3(n.mid.x + ((i&1) ? q : -q),
+                n.mid.y + ((i&2) ? q : -q),
+                _dims == 3 ? n.mid.z + ((i&4) ? q : -q) : 0);
+    c.half= q;
+    c.depth= n.depth+1;
+    c.kids= -1;
+    c.parent= ni;
+    c.count=0;
+    if (first+i < (int) _nodes.size()) {
+      _nodes[first+i]= c;
+    } else {
+      s__conj(_nodes, c);
+    }
+  }
+  _nodes[ni].kids= first;
+
+  ItemVec keep;
+  ItemVec items;
+  items.swap(_nodes[ni].items);
+  for (auto& x : items) {
+    auto ci= first + childOf(_nodes[ni], x.pos);
+    if (looseHas(_nodes[ci], x.pos)) {
+      s__conj(_nodes[ci].items, x);
+      ++_nodes[ci].count;
+      _slots[x.eid].cell= ci;
+    } else {
+      s__conj(keep, x);
+    }
+  }
+  _nodes[ni].items.swap(keep);
+
+  for (auto i=0; i < cnt; ++i) {
+    if ((int) _nodes[first+i].items.size() > _leafCap &&
+        _nodes[first+i].depth < _maxDepth) {
+      split(first+i);
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::place(EntityId eid, const Vec3& p) {
+  auto ni=0;
+  while (_nodes[ni].kids >= 0) {
+    auto ci= _nodes[ni].kids + childOf(_nodes[ni], p);
+    if (!looseHas(_nodes[ci], p)) { break; }
+    ni= ci;
+  }
+  s__conj(_nodes[ni].items, Item(eid,p));
+  _slots[eid]= Slot{p,ni};
+  for (auto k=ni; k >= 0; k= _nodes[k].parent) { ++_nodes[k].count; }
+  if (_nodes[ni].kids < 0 &&
+      (int) _nodes[ni].items.size() > _leafCap &&
+      _nodes[ni].depth < _maxDepth) {
+    split(ni);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::insert(EntityId eid, const Vec3& p) {
+  if (contains(eid)) {
+    move(eid,p);
+  } else {
+    place(eid,p);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::move(EntityId eid, const Vec3& p) {
+  auto s= _slots.find(eid);
+  if (s == _slots.end()) {
+    return place(eid,p);
+  }
+  auto& n= _nodes[s->second.cell];
+  if (looseHas(n, p)) {
+    // still inside the loose bounds, just update in place
+    for (auto& x : n.items) {
+      if (x.eid == eid) { x.pos= p; break; }
+    }
+    s->second.pos= p;
+  } else {
+    unlink(s->second.cell, eid);
+    place(eid,p);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::remove(EntityId eid) {
+  if (auto s= _slots.find(eid); s != _slots.end()) {
+    auto ni= s->second.cell;
+    _slots.erase(s);
+    unlink(ni, eid);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::unlink(int ni, EntityId eid) {
+  drop(_nodes[ni].items, eid);
+  // the highest subtree down to half a leaf, so it stays
+  // well clear of splitting again
+  auto top= -1;
+  for (auto k=ni; k >= 0; k= _nodes[k].parent) {
+    if (--_nodes[k].count <= _leafCap/2 && _nodes[k].kids >= 0) { top=k; }
+  }
+  if (top >= 0) { merge(top); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::merge(int ni) {
+  auto cnt= 1 << _dims;
+  std::vector<int> todo {_nodes[ni].kids};
+  _nodes[ni].kids= -1;
+  while (!todo.empty()) {
+    auto first= todo.back();
+    todo.pop_back();
+    for (auto i=0; i < cnt; ++i) {
+      auto& c= _nodes[first+i];
+      for (auto& x : c.items) {
+        s__conj(_nodes[ni].items, x);
+        _slots[x.eid].cell= ni;
+      }
+      c.items.clear();
+      c.count=0;
+      if (c.kids >= 0) { s__conj(todo, c.kids); }
+      c.kids= -1;
+    }
+    s__conj(_free, first);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::queryRadius(const Vec3& c, float r, EidVec& out) const {
+  auto cnt= 1 << _dims;
+  auto r2= r*r;
+  std::vector<int> todo {0};
+  while (!todo.empty()) {
+    auto& n= _nodes[todo.back()];
+    todo.pop_back();
+    if (boxDist2(n, c) > r2) { continue; }
+    for (auto& x : n.items) {
+      if (dist2(c, x.pos) <= r2) { s__conj(out, x.eid); }
+    }
+    if (n.kids >= 0) {
+      for (auto i=0; i < cnt; ++i) { s__conj(todo, n.kids+i); }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::queryBox(const AABB& b, EidVec& out) const {
+  auto cnt= 1 << _dims;
+  auto lo= b.lo, hi= b.hi;
+  if (_dims == 2) { lo.z= hi.z= 0; }
+  AABB bx(lo,hi);
+  std::vector<int> todo {0};
+  while (!todo.empty()) {
+    auto ni= todo.back();
+    auto& n= _nodes[ni];
+    todo.pop_back();
+    if (ni != 0) {
+      auto h= 2*n.half;
+      if (n.mid.x+h < lo.x || n.mid.x-h > hi.x ||
+          n.mid.y+h < lo.y || n.mid.y-h > hi.y ||
+          (_dims == 3 && (n.mid.z+h < lo.z || n.mid.z-h > hi.z))) {
+        continue;
+      }
+    }
+    for (auto& x : n.items) {
+      auto p= x.pos;
+      if (_dims == 2) { p.z=0; }
+      if (bx.contains(p)) { s__conj(out, x.eid); }
+    }
+    if (n.kids >= 0) {
+      for (auto i=0; i < cnt; ++i) { s__conj(todo, n.kids+i); }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LooseTree::nearest(const Vec3& c, int k, EidVec& out) const {
+  if (k <= 0 || _slots.empty()) { return; }
+  typedef std::pair<float,int> DistNode;
+  // min-heap of nodes by distance to their loose bounds
+  std::priority_queue<DistNode,
+                      std::vector<DistNode>, std::greater<DistNode>> todo;
+  auto cnt= 1 << _dims;
+  KBest best;
+
+  todo.push(DistNode(0,0));
+  while (!todo.empty()) {
+    auto d= todo.top().first;
+    auto& n= _nodes[todo.top().second];
+    todo.pop();
+    if ((int) best.size() == k && d > best.top().first) { break; }
+    for (auto& x : n.items) {
+      offer(best, k, dist2(c, x.pos), x.eid);
+    }
+    if (n.kids >= 0) {
+      for (auto i=0; i < cnt; ++i) {
+        auto ci= n.kids+i;
+        todo.push(DistNode(boxDist2(_nodes[ci], c), ci));
+      }
+    }
+  }
+
+  drain(best, out);
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,250 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <unordered_map>
+#include "types.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::ecs {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace a= czlab::aeon;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Vec3 {
+  Vec3(float x, float y, float z=0) : x(x), y(y), z(z) {}
+  Vec3() {}
+  float x=0;
+  float y=0;
+  float z=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct AABB {
+  AABB(const Vec3& lo, const Vec3& hi) : lo(lo), hi(hi) {}
+  AABB() {}
+  bool contains(const Vec3&) const;
+  Vec3 lo;
+  Vec3 hi;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+typedef std::vector<EntityId> EidVec;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// points indexed by entity, dims is 2 (z ignored) or 3
+struct MSVC_DLL SpatialIndex {
+
+  virtual void insert(EntityId, const Vec3&) = 0;
+  virtual void move(EntityId, const Vec3&) = 0;
+  virtual void remove(EntityId) = 0;
+  virtual void clear() = 0;
+
+  bool contains(EntityId eid) const { return s__contains(_slots, eid); }
+  size_t size() const { return _slots.size(); }
+  int dims() const { return _dims; }
+
+  // where the entity was put, nil if it is not indexed
+  const Vec3* where(EntityId) const;
+  // every indexed entity, appended to out
+  void ids(EidVec& out) const;
+
+  // results are appended to out
+  virtual void queryRadius(const Vec3&, float radius, EidVec& out) const = 0;
+  virtual void queryBox(const AABB&, EidVec& out) const = 0;
+  // k nearest, closest first
+  virtual void nearest(const Vec3&, int k, EidVec& out) const = 0;
+
+  virtual ~SpatialIndex() {}
+
+  protected:
+
+  // cell is the grid key or the tree node
+  struct Slot {
+    Vec3 pos;
+    llong cell;
+  };
+
+  struct Item {
+    Item(EntityId e, const Vec3& p) : eid(e), pos(p) {}
+    EntityId eid;
+    Vec3 pos;
+  };
+
+  typedef std::vector<Item> ItemVec;
+
+  SpatialIndex(int dims) { _dims= dims == 2 ? 2 : 3; }
+  float dist2(const Vec3&, const Vec3&) const;
+  void drop(ItemVec&, EntityId) const;
+
+  std::unordered_map<EntityId,Slot> _slots;
+  int _dims;
+
+  private:
+
+  SpatialIndex()=delete;
+  SpatialIndex(const SpatialIndex&)=delete;
+  SpatialIndex& operator=(const SpatialIndex&)=delete;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// hashed uniform grid, best when entities are spread evenly
+// and queries are about the size of a cell
+struct MSVC_DLL UniformGrid : public SpatialIndex {
+
+  virtual void insert(EntityId, const Vec3&);
+  virtual void move(EntityId, const Vec3&);
+  virtual void remove(EntityId);
+  virtual void clear();
+
+  virtual void queryRadius(const Vec3&, float, EidVec&) const;
+  virtual void queryBox(const AABB&, EidVec&) const;
+  virtual void nearest(const Vec3&, int, EidVec&) const;
+
+  UniformGrid(float cellSize, int dims=3);
+  virtual ~UniformGrid() {}
+
+  private:
+
+  llong cellOf(const Vec3&) const;
+  llong cellKey(long, long, long) const;
+  long coord(float) const;
+
+  std::unordered_map<llong,ItemVec> _cells;
+  float _cellSize;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// loose quadtree (dims=2) or octree (dims=3), each node accepts
+// points within twice its size so small moves need no re-insert,
+// a subtree emptied to half a leaf folds back into its top node
+struct MSVC_DLL LooseTree : public SpatialIndex {
+
+  virtual void insert(EntityId, const Vec3&);
+  virtual void move(EntityId, const Vec3&);
+  virtual void remove(EntityId);
+  virtual void clear();
+
+  virtual void queryRadius(const Vec3&, float, EidVec&) const;
+  virtual void queryBox(const AABB&, EidVec&) const;
+  virtual void nearest(const Vec3&, int, EidVec&) const;
+
+  // world bounds, points outside stay in the root
+  LooseTree(const AABB& world, int dims=3, int leafCap=8, int maxDepth=12);
+  virtual ~LooseTree() {}
+
+  private:
+
+  struct Node {
+    Vec3 mid;
+    float half;
+    int depth;
+    int kids;
+    int parent;
+    // items in this node and below
+    int count;
+    ItemVec items;
+  };
+
+  int childOf(const Node&, const Vec3&) const;
+  bool looseHas(const Node&, const Vec3&) const;
+  float boxDist2(const Node&, const Vec3&) const;
+  void split(int);
+  void place(EntityId, const Vec3&);
+  // take the item out of its node, then fold what got too small
+  void unlink(int, EntityId);
+  void merge(int);
+
+  std::vector<Node> _nodes;
+  // blocks of kids given back by merge(), reused by split()
+  std::vector<int> _free;
+  AABB _world;
+  int _leafCap;
+  int _maxDepth;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// keeps an index in step with the entities that have component T,
+// T must provide Vec3 pos() const.  sync() walks the registry's T
+// and checks each pos() against where the index has it, so a bind,
+// an unbind or a write to a position is seen whoever made it.
+// That is one pass over T a call, made once a frame, say after
+// the systems that move things.
+template<typename T>
+struct SpatialSync {
+
+  // bring the index in line with T
+  void sync();
+
+  // drop the index and put in every entity that has T
+  void rebuild();
+
+  SpatialIndex* index() const { return _index; }
+
+  SpatialSync(Engine* e, SpatialIndex* x) { _engine=e; _index=x; }
+  virtual ~SpatialSync() {}
+
+  private:
+
+  Engine* _engine;
+  SpatialIndex* _index;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void SpatialSync<T>::sync() {
+  auto cc= _engine->rego()->template getCache<T>();
+  size_t n=0;
+  if (cc) {
+    for (auto i= cc->begin(),e= cc->end(); i != e; ++i) {
+      auto pos= s__cast(T,i->second.ptr())->pos();
+      if (auto w= _index->where(i->first); E_NIL(w)) {
+        _index->insert(i->first, pos);
+      } else if (w->x != pos.x || w->y != pos.y || w->z != pos.z) {
+        _index->move(i->first, pos);
+      }
+    }
+    n= cc->size();
+  }
+  // every T is in now, any more have lost theirs
+  if (_index->size() > n) {
+    EidVec all;
+    _index->ids(all);
+    for (auto eid : all) {
+      if (E_NIL(cc) || !s__contains(*cc, eid)) { _index->remove(eid); }
+    }
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+void SpatialSync<T>::rebuild() {
+  _index->clear();
+  if (auto cc= _engine->rego()->template getCache<T>(); cc) {
+    for (auto i= cc->begin(),e= cc->end(); i != e; ++i) {
+      _index->insert(i->first, s__cast(T,i->second.ptr())->pos());
+    }
+  }
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -120,6 +120,43 @@ struct Game : public e::Engine {
 
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// every other entity gives its components back, so both
+// types are spread thin enough for compactStep to pack
+struct Packed : public e::Engine {
+  Packed() {}
+  virtual ~Packed() {}
+
+  virtual void initEnts() {
+    for (auto i=0; i < 64; ++i) {
+      auto x= reifyEnt();
+      rego()->bind<Location>(new Location(),x);
+      rego()->bind<Health>(new Health(),x);
+      if (i % 2) {
+        rego()->unbind<Location>(x);
+        rego()->unbind<Health>(x);
+      }
+    }
+  }
+
+  virtual void initSystems() {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a raw pointer into a pinned type is still good after the
+// steps, while the unpinned type did move
+bool pinnedSurvivesCompact() {
+  Packed g;
+  g.ignite();
+  g.rego()->pin<Location>();
+  auto eid= g.getEnts<Location>().back()->id();
+  auto loc= g.rego()->getCache<Location>()->find(eid)->second.ptr();
+  auto hp= g.rego()->getCache<Health>()->find(eid)->second.ptr();
+  while (g.compactStep(0.1, 4)) {}
+  return g.rego()->getCache<Location>()->find(eid)->second.ptr() == loc &&
+         g.rego()->getCache<Health>()->find(eid)->second.ptr() != hp;
+}
+
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
@@ -145,6 +182,7 @@ int main(int ac, char** av) {
 
 
   delete g;
+  std::cout << "pinned = " << pinnedSurvivesCompact() << "\n";
   std::cout << "yo! "    << "\n";
   return 0;
 }
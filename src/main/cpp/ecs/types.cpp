@@ -13,12 +13,77 @@
  * Copyright (c) 2013-2016, Kenneth Leung. All rights reserved. */
 
 #include <iostream>
+#include <new>
 #include "types.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::ecs {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Cid EntityFeatureBase::_lastId = 0;
+std::atomic<Cid> EntityFeatureBase::_lastId(0);
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// sits in front of every component, arena is nil when
+// the component came from the heap
+struct alignas(16) CompHeader {
+  Arena* arena;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a packed block of components, the registry holds one
+// reference and each component another, components may be
+// released on other threads after migrating
+struct alignas(16) Arena {
+
+  static Arena* make(size_t n, size_t stride) {
+    auto p= ::malloc(sizeof(Arena) + n*stride);
+    auto a= new (p) Arena();
+    a->stride=stride;
+    return a;
+  }
+
+  void* slot(size_t i) {
+    return (char*)this + sizeof(Arena) + i*stride;
+  }
+
+  void retain() { live.fetch_add(1, std::memory_order_relaxed); }
+
+  // drop the registry's reference
+  void retire() { done(); }
+
+  void done() {
+    if (live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      this->~Arena();
+      ::free(this);
+    }
+  }
+
+  size_t stride=0;
+  std::atomic<int> live {1};
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static size_t slotSize(size_t z) {
+  return (sizeof(CompHeader) + z + 15) & ~((size_t)15);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void* Component::operator new(size_t z) {
+  auto h= (CompHeader*) ::malloc(sizeof(CompHeader) + z);
+  if (E_NIL(h)) { throw std::bad_alloc(); }
+  h->arena= P_NIL;
+  return h+1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Component::operator delete(void* p) {
+  if (E_NIL(p)) { return; }
+  auto h= s__cast(CompHeader,p) - 1;
+  if (h->arena) {
+    h->arena->done();
+  } else {
+    ::free(h);
+  }
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Component::~Component() {
@@ -27,11 +92,163 @@ Component::~Component() {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Registry::~Registry() {
+  // arenas go away as their last component is released
+  for (auto i=_info.begin(),e=_info.end();i!=e;++i) {
+    for (auto a : i->second.arenas) { a->retire(); }
+  }
   for (auto i=_rego.begin(),e=_rego.end();i!=e;++i) {
     DEL_PTR(i->second);
   }
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Registry::unbind(Cid cid, EntityId eid) {
+  if (auto i= _rego.find(cid); i != _rego.end()) {
+    i->second->erase(eid);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Registry::bind(const CompPart& p, EEntity e) {
+  if (auto i= _rego.find(p.cid); i != _rego.end()) {} else {
+    _rego.insert(s__pair(Cid,MapEidC*,p.cid, new MapEidC));
+    _info[p.cid].type= p.type;
+  }
+  _rego[p.cid]->insert(s__pair(EntityId,EComponent, e->id(), p.comp));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::vector<CompPart> Registry::detach(EntityId eid) {
+  std::vector<CompPart> out;
+  for (auto i=_rego.begin(),e=_rego.end();i!=e;++i) {
+    if (auto c= i->second->find(eid); c != i->second->end()) {
+      s__conj(out, (CompPart{i->first, _info[i->first].type, c->second}));
+      i->second->erase(c);
+    }
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::vector<Cid> Registry::cids() const {
+  std::vector<Cid> out;
+  for (auto i=_rego.begin(),e=_rego.end();i!=e;++i) {
+    s__conj(out, i->first);
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+CompStats Registry::stats(Cid cid) const {
+  CompStats out;
+  auto m= getCache(cid);
+  auto t= _info.find(cid);
+  if (E_NIL(m) || t == _info.end()) {
+    return out;
+  }
+  auto stride= slotSize(t->second.type.size);
+  char* lo= P_NIL;
+  char* hi= P_NIL;
+  for (auto i=m->begin(),e=m->end();i!=e;++i) {
+    auto p= (char*) i->second.ptr();
+    if (E_NIL(lo) || p < lo) { lo=p; }
+    if (E_NIL(hi) || p > hi) { hi=p; }
+  }
+  out.name= t->second.type.name;
+  out.cid= cid;
+  out.count= m->size();
+  out.bytes= out.count * stride;
+  // a tree node is 3 links and a color on top of the pair
+  out.mapBytes= out.count * (sizeof(MapEidC::value_type) + 4*sizeof(void*));
+  if (out.count > 1) {
+    auto span= (double) (hi - lo) + stride;
+    out.fragmentation= std::max(0.0, 1.0 - out.bytes / span);
+  }
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Registry::compact(Cid cid) {
+  bool done;
+  return compact(cid, SIZE_MAX, done) > 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t Registry::compact(Cid cid, size_t budget, bool& done) {
+  done=true;
+  auto m= getCache(cid);
+  auto t= _info.find(cid);
+  if (E_NIL(m) || t == _info.end() || t->second.pinned ||
+      E_NIL(t->second.type.move) || budget == 0) {
+    return 0;
+  }
+  auto& info= t->second;
+  if (E_NIL(info.fill)) {
+    size_t n=0;
+    for (auto i=m->begin(),e=m->end();i!=e;++i) {
+      // someone else holds it, moving it would split the object
+      if (i->second->refs() == 1) { ++n; }
+    }
+    if (n == 0) { return 0; }
+    // the old blocks go as the last of their components moves out
+    for (auto a : info.arenas) { a->retire(); }
+    info.arenas.clear();
+    info.fill= Arena::make(n, slotSize(info.type.size));
+    info.cap=n;
+    info.used=0;
+    info.next=0;
+    s__conj(info.arenas, info.fill);
+  }
+
+  size_t moved=0;
+  auto i= m->lower_bound(info.next);
+  for (auto e=m->end();
+       i != e && moved < budget && info.used < info.cap; ++i) {
+    auto c= i->second.ptr();
+    if (c->refs() != 1) { continue; }
+    auto h= s__cast(CompHeader, info.fill->slot(info.used));
+    if (auto nc= info.type.move(c, h+1); nc) {
+      h->arena= info.fill;
+      info.fill->retain();
+      ++info.used;
+      ++moved;
+      i->second= nc;
+    }
+  }
+
+  if (i != m->end() && info.used < info.cap) {
+    info.next= i->first;
+    done=false;
+  } else {
+    if (info.used == 0) {
+      info.fill->retire();
+      info.arenas.pop_back();
+    }
+    info.fill=P_NIL;
+  }
+  return moved;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Registry::pin(Cid cid) {
+  auto& info= _info[cid];
+  if (info.fill) {
+    // a pass was under way, what moved stays moved
+    if (info.used == 0) {
+      info.fill->retire();
+      info.arenas.pop_back();
+    }
+    info.fill=P_NIL;
+  }
+  info.pinned=true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Registry::pinned(Cid cid) const {
+  auto t= _info.find(cid);
+  return t != _info.end() && t->second.pinned;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 MapEidC* Registry::getCache(const Cid& z) const {
   if (auto i=_rego.find(z); i != _rego.end()) {
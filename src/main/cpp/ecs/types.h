@@ -15,6 +15,9 @@
 
 //////////////////////////////////////////////////////////////////////////////
 
+#include <atomic>
+#include <typeinfo>
+#include <type_traits>
 #include "../nlohmann/json.hpp"
 #include "../aeon/smptr.h"
 
@@ -33,6 +36,9 @@ struct Component;
 struct System;
 struct Entity;
 struct Engine;
+struct EventBus;
+struct Arena;
+struct Cluster;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 typedef a::RefPtr<Component> EComponent;
@@ -40,10 +46,12 @@ typedef a::RefPtr<System> ESystem;
 typedef a::RefPtr<Entity> EEntity;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// type ids are shared by every world so that components
+// keep their id when an entity migrates
 struct EntityFeatureBase {
   protected:
   static Cid nextId() { return ++_lastId; }
-  static Cid _lastId;
+  static std::atomic<Cid> _lastId;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -57,6 +65,65 @@ struct EntityFeature : public EntityFeatureBase {
 struct MSVC_DLL Component : public a::Counted {
   virtual ~Component();
   Component() {}
+
+  // each component carries a small header naming its arena,
+  // so compact() can pack them and delete still works
+  static void* operator new(size_t);
+  static void* operator new(size_t, void* p) { return p; }
+  static void operator delete(void*);
+  static void operator delete(void*, void*) {}
+
+  protected:
+
+  // a copy starts with no references
+  Component(const Component&) : a::Counted() {}
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+typedef Component* (*Relocator)(Component*, void*);
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// what a registry knows about a component type
+struct CompType {
+  stdstr name;
+  size_t size=0;
+  // copies into raw memory, nil if the type can't be copied
+  Relocator move=P_NIL;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// one component of an entity in transit
+struct CompPart {
+  Cid cid;
+  CompType type;
+  EComponent comp;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// per component type memory usage
+struct CompStats {
+  stdstr name;
+  Cid cid=0;
+  size_t count=0;
+  // component objects, including headers
+  size_t bytes=0;
+  // the entity->component map
+  size_t mapBytes=0;
+  // 0 when packed, near 1 when scattered
+  double fragmentation=0;
+  // components whose entity is gone
+  size_t orphans=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct MemReport {
+  std::vector<CompStats> comps;
+  size_t liveEnts=0;
+  size_t deadEnts=0;
+  size_t entBytes=0;
+  size_t compBytes=0;
+  // weighted by bytes over all component types
+  double fragmentation=0;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -70,6 +137,7 @@ struct MSVC_DLL Entity : public a::Counted {
 
   bool isOk() const { return !_dead; };
   EntityId id() const { return _eid; }
+  cstdstr& name() const { return _name; }
 
   virtual ~Entity() {}
 
@@ -103,14 +171,21 @@ struct MSVC_DLL System : public a::Counted {
   virtual void preamble() = 0;
   virtual int priority() const = 0;
 
+  // ticks per second, 0 => run once per frame
+  // with the frame's time
+  virtual float tickRate() const { return 0; }
+
   virtual ~System() {}
 
+  friend struct Engine;
   protected:
 
   System(Engine* e) { _engine= e; }
 
   Engine* _engine;
   bool _active=true;
+  // unconsumed time for fixed-step systems
+  float _accum=0;
 
   System()=delete;
   System(const System&)=delete;
@@ -131,12 +206,58 @@ struct MSVC_DLL Registry {
   template<typename T>
   void bind(T* c, EEntity e);
 
+  void unbind(Cid, EntityId);
+
+  // untyped bind, used when entities move between worlds
+  void bind(const CompPart&, EEntity e);
+
+  // unbind and return every component of the entity
+  std::vector<CompPart> detach(EntityId);
+
+  // all bound component types
+  std::vector<Cid> cids() const;
+
+  CompStats stats(Cid) const;
+
+  // move the components of this type into one packed block,
+  // in iteration order, skipping any referenced elsewhere.
+  // A raw Component* kept across a compact dangles once its
+  // component moves, hold the EComponent or pin the type.
+  bool compact(Cid);
+  // the same, moving at most budget components a call and going
+  // on from where the last call stopped, done once the pass is
+  // over, returns how many moved
+  size_t compact(Cid, size_t budget, bool& done);
+
+  // for types whose raw pointers systems cache, compact
+  // leaves them where they are
+  template<typename T>
+  void pin() { pin(EntityFeature<T>::id()); }
+  void pin(Cid);
+  bool pinned(Cid) const;
+
   virtual ~Registry();
   Registry() {}
 
   private:
 
+  struct TypeInfo {
+    CompType type;
+    std::vector<Arena*> arenas;
+    // a pass under way, the block being filled, its slots,
+    // and the entity to go on from
+    Arena* fill=P_NIL;
+    size_t cap=0;
+    size_t used=0;
+    EntityId next=0;
+    bool pinned=false;
+  };
+
+  template<typename T>
+  static Component* relocate(Component*, void*);
+
   std::map<Cid, MapEidC*> _rego;
+  std::map<Cid, TypeInfo> _info;
   Registry(const Registry&) = delete;
   Registry& operator=(const Registry&) = delete;
 };
@@ -165,6 +286,17 @@ struct MSVC_DLL Engine {
   // the singleton registry
   Registry* rego() const { return _types; }
 
+  // set when the engine is one world in a cluster
+  Cluster* cluster() const { return _cluster; }
+  int worldId() const { return _worldId; }
+
+  // called on the world's thread before its update
+  virtual void onMessage(int from, const j::json&) {}
+  virtual void onArrive(EEntity, int from) {}
+
+  // typed events between systems, flipped after each update
+  EventBus* events() const { return _events; }
+
   // remove systems
   void purgeSystem(ESystem);
   void purgeSystems();
@@ -173,6 +305,22 @@ struct MSVC_DLL Engine {
   void purgeEnt(EEntity);
   void purgeEnts();
 
+  // memory used by entities and components
+  MemReport memReport() const;
+
+  // drop components of dead entities and pack every
+  // component type, not allowed during update
+  void compact();
+
+  // incremental form, goes on packing the most fragmented type
+  // above the threshold, moving at most budget components a
+  // call, false once nothing moved.  A type still above the
+  // threshold after its pass, as when its components are held
+  // outside the registry, is skipped until its count changes.
+  // Pinned types are never packed.  For the rest, a raw pointer
+  // held across a step may dangle, see Registry::compact.
+  bool compactStep(double threshold=0.25, size_t budget=256);
+
   // register+add a system
   ESystem addSystem(ESystem);
 
@@ -180,9 +328,15 @@ struct MSVC_DLL Engine {
   void ignite();
 
   // each update called will update each system
-  // in order
+  // in order, fixed-step systems are ticked zero or
+  // more times depending on the accumulated time
   void update(float time);
 
+  // max ticks a fixed-step system may run per update,
+  // any backlog beyond that is dropped
+  void maxCatchUp(int n) { _maxCatchUp= n > 0 ? n : 1; }
+  int maxCatchUp() const { return _maxCatchUp; }
+
   // you can pass in some configurations
   Engine(j::json c) : Engine() { _config=c; }
   Engine();
@@ -193,13 +347,27 @@ struct MSVC_DLL Engine {
   virtual void initSystems() = 0;
   virtual void initEnts() = 0;
 
+  friend struct Entity;
+  friend struct Cluster;
   private:
 
+  // entity ids are unique within a world only
+  EntityId nextEid() { return ++_lastEid; }
+
   std::vector<ESystem> _systems;
   j::json _config;
   MapEidE _ents;
   EntVec _garbo;
   Registry* _types;
+  EventBus* _events;
+  Cluster* _cluster=P_NIL;
+  EntityId _lastEid=0;
+  // the type compactStep is packing, and the ones it gave up on
+  // with their counts at the time
+  Cid _packing=0;
+  std::map<Cid,size_t> _stuck;
+  int _worldId=0;
+  int _maxCatchUp=5;
   bool _updating=false;
 
   Engine(const Engine&)=delete;
@@ -229,6 +397,18 @@ void Registry::unbind(EEntity e) {
   }
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<typename T>
+Component* Registry::relocate(Component* c, void* mem) {
+  // subclasses bound as T would be sliced
+  if constexpr (std::is_copy_constructible_v<T>) {
+    if (typeid(*c) != typeid(T)) { return P_NIL; }
+    return new (mem) T(std::move(*s__cast(T,c)));
+  } else {
+    return P_NIL;
+  }
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 template<typename T>
 void Registry::bind(T* c, EEntity e) {
@@ -237,6 +417,7 @@ void Registry::bind(T* c, EEntity e) {
 
   if (auto i= _rego.find(cid); i != _rego.end()) {} else {
     _rego.insert(s__pair(Cid,MapEidC*,cid, new MapEidC));
+    _info[cid].type= CompType{typeid(T).name(), sizeof(T), &relocate<T>};
   }
   _rego[cid]->insert(s__pair(EntityId,EComponent, eid, c));
 }
@@ -20,7 +20,7 @@ namespace a = czlab::aeon;
 namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-std::map<int, stdstr> TOKENS {
+constexpr d::Keyword TOKENS[] {
   {T_SPLICE_UNQUOTE,",@"},
   {T_SYNTAX_QUOTE, "`"},
   {T_UNQUOTE, ","},
@@ -34,14 +34,13 @@ std::map<int, stdstr> TOKENS {
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-auto KEYWORDS = a::map_reflect(TOKENS);
+constexpr d::KeywordTable KEYWORDS(TOKENS);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr typeToString(int type) {
-  auto& i= d::getIntTokens();
-  return s__contains(TOKENS, type)
-         ? map__val(TOKENS, type)
-         : (s__contains(i,type) ? map__val(i,type) : ("token#" + N_STR(type)));
+  auto s= KEYWORDS.name(type);
+  if (s.empty()) { s= d::tokenName(type); }
+  return s.size() ? stdstr(s) : ("token#" + N_STR(type));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -51,6 +50,12 @@ Reader::Reader(const Tchar* src) {
   _ctx.cur= getNextToken();
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Reader::Reader(d::Source* in) {
+  _ctx.open(in);
+  _ctx.cur= getNextToken();
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Reader::isKeyword(cstdstr&) const {
   RAISE(d::Unsupported, "%s not allowed!", "isKeyword");
@@ -168,7 +173,7 @@ Tchar readChar(d::Context& ctx) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Reader::getNextToken() {
-  //auto& S= d::getStrTokens();
+  _ctx.trim();
   while (!_ctx.eof) {
     auto ch= d::peek(_ctx);
 
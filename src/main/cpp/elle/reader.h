@@ -49,6 +49,8 @@ struct Reader : public d::IScanner {
 
   d::Context& ctx() { return _ctx; }
   Reader(const Tchar* src);
+  // a window at a time, owns the source
+  Reader(d::Source*);
   virtual ~Reader() {};
 
   private:
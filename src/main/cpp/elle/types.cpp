@@ -12,6 +12,8 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include "../dsl/isolate.h"
+#include "../dsl/gc.h"
 #include "types.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -74,10 +76,16 @@ bool SPair::equals(d::DValue rhs) const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int SPair::compare(d::DValue rhs) const {
   if (!d::is_same(rhs,this))
-    return pr_str(0).compare(rhs->pr_str(0));
-  else
-    return equals(rhs)
-           ? 0 : pr_str(0).compare(rhs->pr_str(0));
+    return d::compare_types(this, rhs.get());
+  auto p= vcast<SPair>(rhs);
+  auto c= f1->compare(p->f1);
+  return c != 0 ? c : f2->compare(p->f2);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void SPair::trace(d::Tracer& t) const {
+  t.visit(f1);
+  t.visit(f2);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -203,9 +211,19 @@ bool SVec::equals(d::DValue rhs) const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int SVec::compare(d::DValue rhs) const {
   if (!d::is_same(rhs,this))
-    return pr_str(0).compare(rhs->pr_str(0));
-  else
-    return equals(rhs) ? 0 : pr_str(0).compare(rhs->pr_str(0));
+    return d::compare_types(this, rhs.get());
+  auto p= vcast<SVec>(rhs);
+  int sz= values.size(), rc= p->values.size();
+  for (auto i=0; i < sz && i < rc; ++i) {
+    if (auto c= values[i]->compare(p->values[i]); c != 0)
+      return c;
+  }
+  return sz == rc ? 0 : (sz > rc ? 1 : -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void SVec::trace(d::Tracer& t) const {
+  for (auto& x : values) t.visit(x);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -224,9 +242,9 @@ stdstr SVec::pr_str(bool p) const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int SNative::compare(d::DValue rhs) const {
   if (!d::is_same(rhs,this))
-    return pr_str(0).compare(rhs->pr_str(0));
+    return d::compare_types(this, rhs.get());
   else
-    return equals(rhs) ? 0 : pr_str(0).compare(rhs->pr_str(0));
+    return equals(rhs) ? 0 : name().compare(vcast<SNative>(rhs)->name());
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -292,10 +310,9 @@ d::DValue SLambda::invoke(Scheme* p) {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static int L_SEED=0;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 SLambda::SLambda(const StrVec& _args, d::DValue body, d::DFrame env)
-: SFunction("anon#" + N_STR(++L_SEED)) {
+: SFunction("anon#" + N_STR(d::Isolate::current()->nextId())) {
   this->body = body;
   this->env= env;
   s__ccat(params, _args);
@@ -329,8 +346,16 @@ bool SLambda::equals(d::DValue rhs) const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int SLambda::compare(d::DValue rhs) const {
-  return equals(rhs)
-         ? 0 : pr_str(0).compare(rhs->pr_str(0));
+  if (!d::is_same(rhs,this))
+    return d::compare_types(this, rhs.get());
+  else
+    return equals(rhs) ? 0 : name().compare(vcast<SLambda>(rhs)->name());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void SLambda::trace(d::Tracer& t) const {
+  t.visit(body);
+  t.visit(env);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -87,8 +87,7 @@ struct SFalse : public SValue {
   virtual bool truthy() const { return false; }
 
   virtual int compare(d::DValue rhs) const {
-    return d::is_same(rhs, this)
-           ? 0 : pr_str(0).compare(rhs->pr_str(0));
+    return d::compare_types(this, rhs.get());
   }
 
   virtual d::DValue eval(Scheme*,d::DFrame) {
@@ -117,9 +116,7 @@ struct STrue : public SValue {
   virtual stdstr pr_str(bool=0) const { return "#t"; }
 
   virtual int compare(d::DValue rhs) const {
-    return d::is_same(rhs, this)
-           ? 0
-           : pr_str(0).compare(rhs->pr_str(0));
+    return d::compare_types(this, rhs.get());
   }
 
   virtual d::DValue eval(Scheme*,d::DFrame) {
@@ -169,13 +166,29 @@ struct SNumber : public SValue {
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs, this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
     { auto f= vcast<SNumber>(rhs)->getFloat();
       auto f2= getFloat();
       return a::fuzzy_equals(f, f2) ? 0 : (f2 > f ? 1 : -1); }
   }
 
+  virtual bool sameKey(d::DValue rhs) const {
+    if (!d::is_same(rhs, this))
+      return false;
+    else
+    { auto p= vcast<SNumber>(rhs);
+      return isInt() == p->isInt() &&
+             (isInt() ? num.n == p->num.n
+                      : d::real_key(num.r) == d::real_key(p->num.r)); }
+  }
+
+  virtual size_t hash() const {
+    return isInt()
+           ? std::hash<llong>()(num.n)
+           : std::hash<double>()(d::real_key(num.r));
+  }
+
   virtual d::DValue eval(Scheme*, d::DFrame) {
     return WRAP_VAL(SNumber, this);
   }
@@ -239,11 +252,18 @@ struct SString : public SValue {
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs, this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
       return value.compare(vcast<SString>(rhs)->value);
   }
 
+  virtual size_t hash() const {
+    if (_hash == 0)
+      _hash= d::hash_combine(typeid(SString).hash_code(),
+                             std::hash<stdstr>()(value));
+    return _hash;
+  }
+
   virtual bool isEmpty() const { return value.empty(); }
   virtual int count() const { return value.size(); }
 
@@ -260,6 +280,7 @@ struct SString : public SValue {
   SString(cstdstr& s) { value=s; }
 
   stdstr value;
+  mutable size_t _hash=0;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -288,12 +309,14 @@ struct SChar : public SValue {
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs, this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
     { auto c = vcast<SChar>(rhs)->value;
       return value==c ? 0 : value > c ? 1 : -1; }
   }
 
+  virtual size_t hash() const { return std::hash<Tchar>()(value); }
+
   Tchar impl() { return value; }
   virtual ~SChar() {}
 
@@ -333,11 +356,13 @@ struct SSymbol : public SValue {
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs,this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
       return value.compare(vcast<SSymbol>(rhs)->value);
   }
 
+  virtual size_t hash() const { return std::hash<stdstr>()(value); }
+
   stdstr impl() const { return value; }
   void rename(cstdstr& n) { value=n; }
 
@@ -363,8 +388,7 @@ struct SNil : public SValue {
   }
 
   virtual int compare(d::DValue rhs) const {
-    return equals(rhs)
-           ? 0 : pr_str(0).compare(rhs->pr_str(0));
+    return d::compare_types(this, rhs.get());
   }
 
   virtual bool equals(d::DValue rhs) const {
@@ -404,6 +428,7 @@ struct SPair : public SValue {
   virtual d::DValue eval(Scheme*,d::DFrame);
   virtual bool equals(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual void trace(d::Tracer&) const;
 
   virtual stdstr pr_str(bool=0) const;
 
@@ -469,6 +494,7 @@ struct SVec : public SValue {
 
   virtual bool equals(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual void trace(d::Tracer&) const;
   virtual d::DValue eval(Scheme*, d::DFrame);
   virtual stdstr pr_str(bool p=0) const;
   //virtual d::DValue conj(d::VSlice) const;
@@ -532,6 +558,7 @@ struct SLambda : public SFunction {
 
   virtual bool equals(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual void trace(d::Tracer&) const;
 
   d::DFrame bindContext(d::VSlice);
   SLambda() : SFunction("") {}
@@ -0,0 +1,158 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <chrono>
+#include <map>
+#include <fstream>
+#include "../dsl/gc.h"
+#include "otto.h"
+#include "types.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::otto {
+using clock= std::chrono::steady_clock;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+double nanos(clock::time_point t) {
+  std::chrono::duration<double,std::nano> d= clock::now() - t;
+  return d.count();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// n keys built into one map, a get for each, then assoc of a new
+// key, which copies the map.  The same is done keyed on the printed
+// form, as maps used to be, to see what the value keys save.
+void mapBench(cstdstr& name, d::ValVec& keys) {
+  int n= keys.size();
+  d::ValVec kv;
+  for (auto& k : keys) {
+    s__conj(kv, k);
+    s__conj(kv, k);
+  }
+  auto extra= VEC_VAL2(KEYWORD_VAL("extra"), NIL_VAL());
+  auto sl= vcast<LVec>(extra);
+
+  auto t= clock::now();
+  auto m= MAP_VAL(kv);
+  auto build= nanos(t) / n;
+  auto h= vcast<LHash>(m);
+  size_t hits=0;
+  t= clock::now();
+  for (auto& k : keys) {
+    if (h->contains(k)) { ++hits; }
+  }
+  auto get= nanos(t) / n;
+  d::ValVec more{sl->nth(0), sl->nth(1)};
+  t= clock::now();
+  auto m2= h->assoc(d::VSlice(more));
+  auto assoc= nanos(t) / 1e6;
+
+  std::map<stdstr, std::pair<d::DValue,d::DValue>> old;
+  t= clock::now();
+  for (auto& k : keys) {
+    old[k->pr_str()]= std::make_pair(k, k);
+  }
+  auto obuild= nanos(t) / n;
+  t= clock::now();
+  for (auto& k : keys) {
+    if (old.find(k->pr_str()) != old.end()) { ++hits; }
+  }
+  auto oget= nanos(t) / n;
+  t= clock::now();
+  {
+    auto copy= old;
+    copy[sl->nth(0)->pr_str()]= std::make_pair(sl->nth(0), sl->nth(1));
+  }
+  auto oassoc= nanos(t) / 1e6;
+
+  std::cout << name << " n=" << n << " hits=" << hits << "\n"
+            << "  value keys: build ns/op=" << build
+            << " get ns/op=" << get
+            << " assoc ms=" << assoc << "\n"
+            << "  pr_str keys: build ns/op=" << obuild
+            << " get ns/op=" << oget
+            << " assoc ms=" << oassoc << "\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void mapBench(int n) {
+  d::ValVec ints, kws, vecs;
+  for (auto i=0; i < n; ++i) {
+    s__conj(ints, NUMBER_VAL(i));
+    s__conj(kws, KEYWORD_VAL("key" + N_STR(i)));
+    s__conj(vecs, VEC_VAL2(NUMBER_VAL(i), STRING_VAL("v")));
+  }
+  mapBench("int-keys", ints);
+  mapBench("keyword-keys", kws);
+  mapBench("vector-keys", vecs);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+long rssKB() {
+  std::ifstream in("/proc/self/status");
+  stdstr line;
+  while (std::getline(in, line)) {
+    if (line.compare(0,6,"VmRSS:") == 0)
+      return ::atol(line.c_str()+6);
+  }
+  return 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Closures kept in the frames they close over, made afresh by
+// every run, so all of it is garbage once the run is over.  The
+// frames alive and the rss should level off, run long enough.
+void gcSoak(llong runs) {
+  stdstr src= R"((do
+    (defn down [n] (if (< n 1) 0 (down (- n 1))))
+    (defn adder [x] (fn [y] (+ x y)))
+    (defn counter [] (let [c (atom 0)] (fn [] (swap! c (fn [x] (+ x 1))))))
+    (def fs (map adder [1 2 3 4 5]))
+    (def self (atom nil))
+    (reset! self (fn [] @self))
+    (def c (counter))
+    (c)
+    (down 100)))";
+  auto& heap= d::Heap::current();
+  for (llong i=0; i < runs; ++i) {
+    repl(src);
+    if (i % (runs/10 + 1) == 0 || i == runs-1) {
+      auto s= heap.stats();
+      std::cout << "run " << i
+                << " rss KB=" << rssKB()
+                << " frames=" << s.frames
+                << " gc runs=" << s.runs
+                << " freed=" << s.freed
+                << " last ms=" << s.lastMs << "\n";
+    }
+  }
+}
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+#if 0
+int main(int ac, char** av) {
+  czlab::otto::mapBench(1000000);
+  czlab::otto::gcSoak(100000);
+  return 0;
+}
+#endif
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
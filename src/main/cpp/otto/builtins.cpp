@@ -13,6 +13,7 @@
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
 #include <chrono>
+#include "../dsl/isolate.h"
 #include "parser.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -503,14 +504,14 @@ static d::DValue native_pr_str(Lisper* lisp, d::VSlice args) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 static d::DValue native_println(Lisper* lisp, d::VSlice args) {
   // (println "a" 1 "b")
-  ::printf("%s\n", C_STR(print(args,false, " ")));
+  d::Isolate::current()->out() << print(args,false, " ") << "\n";
   return NIL_VAL();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 static d::DValue native_prn(Lisper* lisp, d::VSlice args) {
   // (prn "a" 1 "b")
-  ::printf("%s\n", C_STR(print(args,true, " ")));
+  d::Isolate::current()->out() << print(args,true, " ") << "\n";
   return NIL_VAL();
 }
 
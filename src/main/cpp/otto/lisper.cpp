@@ -14,6 +14,7 @@
 
 #include "parser.h"
 #include "builtins.h"
+#include "../dsl/gc.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::otto {
@@ -387,9 +388,24 @@ stdstr repl(const stdstr& s, d::DFrame env) {
       auto s= vcast<LList>(ret.second);
       for (auto i = 0, e=s->count(); i < e; ++i) {
         out = lisp.PRINT(lisp.EVAL(s->nth(i), env));
+        // no raw pointers into the heap between forms
+        d::Heap::current().poll();
       }
       break;
   }
+  d::Heap::current().poll();
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr repl(d::Source* in, d::DFrame env) {
+  Lisper lisp;
+  SExprParser p(in);
+  stdstr out="nil";
+  while (auto f= p.next()) {
+    out = lisp.PRINT(lisp.EVAL(f, env));
+    d::Heap::current().poll();
+  }
   return out;
 }
 
@@ -20,6 +20,11 @@ namespace czlab::otto {
 namespace d=czlab::dsl;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr repl(cstdstr& s);
+// a form at a time off the source, which it owns, so the
+// text is never all in memory, returns the last one printed
+stdstr repl(d::Source*, d::DFrame env);
+// natives and core macros, what repl() starts from
+d::DFrame root_env();
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
 
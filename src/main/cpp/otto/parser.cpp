@@ -14,6 +14,7 @@
 
 #include <regex>
 #include <ctime>
+#include "../dsl/isolate.h"
 #include "parser.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -28,10 +29,9 @@ d::DValue readAtom(SExprParser*);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr gensym(cstdstr& prefix) {
-  static int seed=0;
+  auto iso= d::Isolate::current();
   stdstr out;
   int x;
-  srand(time(NULL));
   /*
   for (auto i = 0; i < 3; ++i) {
     x= rand() % 26;
@@ -41,12 +41,11 @@ stdstr gensym(cstdstr& prefix) {
   }
   */
   for (auto i = 0; i < 6; ++i) {
-    x= rand() % 10;
+    x= iso->rng()() % 10;
     out += (char) (((int)'0') + x);
   }
 
-  ++seed;
-  return prefix + out + N_STR(seed);
+  return prefix + out + N_STR(iso->nextId());
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -68,6 +67,11 @@ SExprParser::SExprParser(const Tchar* src) {
   rdr(); // to get rid of warnings, stupid and weird
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+SExprParser::SExprParser(d::Source* in) {
+  lexer = new Reader(in);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue readAtom(SExprParser* p) {
   switch (p->cur()) {
@@ -254,10 +258,8 @@ d::DValue readForm(SExprParser* p) {
 std::pair<int,d::DValue> SExprParser::parse() {
   d::DValue ret;
   d::ValVec out;
-  while (!isEof()) {
-    if (auto f= readForm(this); f) {
-      s__conj(out, f);
-    }
+  while (auto f= next()) {
+    s__conj(out, f);
   }
   int cnt= out.size();
   switch (cnt) {
@@ -268,6 +270,16 @@ std::pair<int,d::DValue> SExprParser::parse() {
   return s__pair(int,d::DValue,cnt,ret);
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue SExprParser::next() {
+  while (!isEof()) {
+    if (auto f= readForm(this); f) {
+      return f;
+    }
+  }
+  return DVAL_NIL;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int SExprParser::cur() const {
   return lexer->ctx().cur->type();
@@ -26,7 +26,11 @@ stdstr gensym(cstdstr& prefix);
 struct SExprParser : public d::IParser {
   // S-Expression parser.
   std::pair<int,d::DValue> parse();
+  // the next top level form, null at the end
+  d::DValue next();
   SExprParser(const Tchar* src);
+  // forms are read off the source one at a time, see next()
+  SExprParser(d::Source*);
   virtual ~SExprParser();
   int cur() const;
   Tchar peek() const;
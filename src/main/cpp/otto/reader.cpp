@@ -20,7 +20,7 @@ namespace a = czlab::aeon;
 namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-std::map<int, stdstr> TOKENS {
+constexpr d::Keyword TOKENS[] {
   {T_SPLICE_UNQUOTE, "~@"},
   {T_ANONFN, "#("},
   {T_SET, "#{"},
@@ -30,14 +30,13 @@ std::map<int, stdstr> TOKENS {
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-auto KEYWORDS = a::map_reflect(TOKENS);
+constexpr d::KeywordTable KEYWORDS(TOKENS);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr typeToString(int type) {
-  auto& i= d::getIntTokens();
-  return s__contains(TOKENS, type)
-         ? map__val(TOKENS, type)
-         : (s__contains(i,type) ? map__val(i,type) : ("token#" + N_STR(type)));
+  auto s= KEYWORDS.name(type);
+  if (s.empty()) { s= d::tokenName(type); }
+  return s.size() ? stdstr(s) : ("token#" + N_STR(type));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -47,6 +46,12 @@ Reader::Reader(const Tchar* src) {
   _ctx.cur= getNextToken();
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Reader::Reader(d::Source* in) {
+  _ctx.open(in);
+  _ctx.cur= getNextToken();
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Reader::isKeyword(cstdstr&) const {
   RAISE(d::Unsupported, "%s not allowed!", "isKeyword");
@@ -146,7 +151,7 @@ void Reader::skipCommas() {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Reader::getNextToken() {
-  auto& S= d::getStrTokens();
+  _ctx.trim();
   while (!_ctx.eof) {
     auto ch= d::peek(_ctx);
     // ORDER IS IMPORTANT!
@@ -169,7 +174,7 @@ d::DToken Reader::getNextToken() {
         ch == '~' ||
         ch == '^' ||
         ch == '@')
-      return d::Token::make(S.at(stdstr(1,ch)),
+      return d::Token::make(d::tokenType(std::string_view(&ch,1)),
                             ch,d::mark_advance(_ctx));
 
     if ((ch == '-' || ch == '+') &&
@@ -12,6 +12,8 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include "../dsl/isolate.h"
+#include "../dsl/gc.h"
 #include "types.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -23,6 +25,15 @@ namespace d= czlab::dsl;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool truthy(d::DValue v) { return DCAST(LValue,v)->truthy(); }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LValue::trace(d::Tracer& t) const { t.visit(metaObj); }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LAtom::trace(d::Tracer& t) const {
+  LValue::trace(t);
+  t.visit(value);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void appendAll(LSeqable* s, d::ValVec& out) { appendAll(s, 0, out); }
 
@@ -66,14 +77,6 @@ d::DValue expected(cstdstr& m, d::DValue v) {
         "Wanted `%s`, got %s", C_STR(m), C_STR(v->pr_str()));
 }
 
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-stdstr hash_key(d::DValue s) {
-  if (!s) {
-    RAISE(a::NPError, "Failed to hash key for map.%s","\n");
-  }
-  return s->pr_str();
-}
-
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 LSequential* cast_sequential(d::DValue v, d::Addr info) {
   if (auto p=cast_sequential(v); p)
@@ -176,6 +179,7 @@ LKeyword::LKeyword(d::DToken t) : LValue(t->addr()) {
   int del=127;
   char c = (char) del;
   value = stdstr { c } + t->getStr();
+  _hash= std::hash<stdstr>()(value);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -183,6 +187,7 @@ LKeyword::LKeyword(cstdstr& s) {
   int del=127;
   char c = (char) del;
   value = stdstr { c } + s;
+  _hash= std::hash<stdstr>()(value);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -190,6 +195,20 @@ stdstr LKeyword::pr_str(bool p) const {
   stdstr s{value}; s[0]= ':'; return s;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// salted, so "a" and the symbol a do not collide
+size_t LString::hash() const {
+  if (_hash == 0)
+    _hash= d::hash_combine(typeid(LString).hash_code(),
+                           std::hash<stdstr>()(value));
+  return _hash;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t LSymbol::hash() const {
+  return std::hash<stdstr>()(value);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LSymbol::eval(Lisper*, d::DFrame e) {
   if (auto r= e->get(value); r) {
@@ -241,16 +260,29 @@ d::DValue LSequential::nth(int pos) const {
   return s__index(pos,values) ? values[pos] : NIL_VAL();
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a list or a vector, without the temporary vcast makes
+const LSequential* as_sequential(const d::DValue& v) {
+  auto p= v.get();
+  return p && (typeid(*p) == typeid(LList) ||
+               typeid(*p) == typeid(LVec))
+         ? s__cast(const LSequential,p) : P_NIL;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool LSequential::equals(d::DValue rhs) const {
-  const LSequential* p = P_NIL;
-  auto sz= count();
+  return match(rhs, false);
+}
 
-  if (vcast<LList>(rhs))
-    p= cast_sequential(rhs);
-  else
-  if (vcast<LVec>(rhs))
-    p= cast_sequential(rhs);
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool LSequential::sameKey(d::DValue rhs) const {
+  return match(rhs, true);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool LSequential::match(d::DValue rhs, bool key) const {
+  auto p= as_sequential(rhs);
+  auto sz= count();
 
   if (E_NIL(p) ||
       sz != p->count())
@@ -258,7 +290,8 @@ bool LSequential::equals(d::DValue rhs) const {
 
   //ok,let's try
   auto i=0; for (; i < sz; ++i) {
-    if (!(nth(i)->equals(p->nth(i))))
+    auto& x= values[i];
+    if (!(key ? x->sameKey(p->values[i]) : x->equals(p->values[i])))
     break;
   }
 
@@ -267,21 +300,39 @@ bool LSequential::equals(d::DValue rhs) const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int LSequential::compare(d::DValue rhs) const {
-  const LSequential* p = P_NIL;
+  auto p= as_sequential(rhs);
   auto sz= count();
 
-  if (vcast<LList>(rhs))
-    p= cast_sequential(rhs);
-  else
-  if (vcast<LVec>(rhs))
-    p= cast_sequential(rhs);
+  if (E_NIL(p))
+    return d::compare_types(this, rhs.get());
+
+  auto rc= p->count();
+  if (sz != rc) { return (sz > rc) ? 1 : -1; }
 
-  if (p) {
-    auto rc= p->count();
-    if (sz != rc) { return (sz > rc) ? 1 : -1; }
+  for (auto i=0; i < sz; ++i) {
+    if (auto c= values[i]->compare(p->values[i]); c != 0)
+      return c;
   }
 
-  return pr_str().compare(rhs->pr_str());
+  return 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a list and a vector can be equal, so the type is left out
+size_t LSequential::hash() const {
+  if (_hash == 0) {
+    size_t h= values.size();
+    for (auto& x : values)
+      h= d::hash_combine(h, x->hash());
+    _hash=h;
+  }
+  return _hash;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LSequential::trace(d::Tracer& t) const {
+  LValue::trace(t);
+  for (auto& x : values) t.visit(x);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -413,8 +464,9 @@ LHash::LHash(d::VSlice more) {
     E_SYNTAX("Wanted even n# of args, got %d near %s",
              c, "");
 
+  values.reserve(c/2);
   for (auto i = more.begin; i != more.end; i += 2)
-    values[hash_key(*i)] = HASH_VAL(*i, *(i+1));
+    values[*i] = *(i+1);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -424,16 +476,11 @@ LHash::LHash(d::Addr a, d::ValVec& v) : LHash(v) { loc=a; }
 LHash::LHash(d::ValVec& v) : LHash(d::VSlice(v)) {}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-LHash::LHash(const std::map<stdstr,VPair>& m) {
-  for (auto& x : m)
-    values[_1(x)] = _2(x);
-}
+LHash::LHash(const d::ValueMap& m) : values(m) {}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-LHash::LHash(const LHash* rhs, d::DValue m) : LValue(m) {
-  for (auto& x : rhs->values)
-    values[_1(x)]= _2(x);
-}
+LHash::LHash(const LHash* rhs, d::DValue m)
+  : LValue(m), values(rhs->values) {}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LHash::assoc(d::VSlice more) const {
@@ -441,18 +488,18 @@ d::DValue LHash::assoc(d::VSlice more) const {
   if (!a::is_even(c))
     E_SYNTAX("Wanted even n# of args, got %d near %s",
         c, "");
-  std::map<stdstr,VPair> m(values);
+  d::ValueMap m(values);
   for (auto i = more.begin; i != more.end; i += 2) {
-    m[hash_key(*i)] = HASH_VAL(*i,*(i+1));
+    m[*i] = *(i+1);
   }
   return MAP_VAL(m);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LHash::dissoc(d::VSlice more) const {
-  std::map<stdstr,VPair> m(values);
+  d::ValueMap m(values);
   for (auto i= more.begin; i != more.end; ++i)
-    m.erase(hash_key(*i));
+    m.erase(*i);
   return MAP_VAL(m);
 }
 
@@ -469,10 +516,8 @@ d::DValue LHash::nth(int pos) const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LHash::seq() const {
   d::ValVec out;
-  for (auto x=values.begin(),e=values.end();
-       x != e; ++x)
-  { auto p= _2_(x);
-    s__conj(out, VEC_VAL2(_1(p), _2(p))); }
+  for (auto& x : values)
+    s__conj(out, VEC_VAL2(_1(x), _2(x)));
   return LIST_VAL(out);
 }
 
@@ -488,21 +533,20 @@ d::DValue LHash::rest() const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool LHash::contains(d::DValue key) const {
-  return s__contains(values, hash_key(key));
+  return s__contains(values, key);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LHash::get(d::DValue key) const {
-  auto i = values.find(hash_key(key));
-  return (i != values.end()) ? _2(_2_(i)) : NIL_VAL();
+  auto i = values.find(key);
+  return (i != values.end()) ? _2_(i) : NIL_VAL();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LHash::eval(Lisper* p, d::DFrame e) {
-  std::map<stdstr,VPair> out;
+  d::ValueMap out;
   for (auto& it : values)
-    out[_1(it)] = HASH_VAL(p->EVAL(_1(_2(it)),e),
-                           p->EVAL(_2(_2(it)),e));
+    out[p->EVAL(_1(it),e)] = p->EVAL(_2(it),e);
   return MAP_VAL(out);
 }
 
@@ -510,7 +554,7 @@ d::DValue LHash::eval(Lisper* p, d::DFrame e) {
 d::DValue LHash::keys() const {
   d::ValVec keys;
   for (auto& x : values)
-    s__conj(keys, _1(_2(x)));
+    s__conj(keys, _1(x));
   return LIST_VAL(keys);
 }
 
@@ -518,7 +562,7 @@ d::DValue LHash::keys() const {
 d::DValue LHash::vals() const {
   d::ValVec out;
   for (auto& x : values)
-    s__conj(out, _2(_2(x)));
+    s__conj(out, _2(x));
   return LIST_VAL(out);
 }
 
@@ -528,43 +572,74 @@ stdstr LHash::pr_str(bool p) const {
 
   for (auto& x : values)
     out += (out.empty()?"":",") +
-           _1(_2(x))->pr_str(p) + " " + _2(_2(x))->pr_str(p);
+           _1(x)->pr_str(p) + " " + _2(x)->pr_str(p);
 
   return "{" + out + "}";
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool LHash::equals(d::DValue rhs) const {
+  return match(rhs, false);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool LHash::sameKey(d::DValue rhs) const {
+  return match(rhs, true);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool LHash::match(d::DValue rhs, bool key) const {
 
   if (!d::is_same(rhs,this))
   return 0;
 
-  auto const &rvs = vcast<LHash>(rhs)->values;
+  auto const &rvs = s__cast(LHash,rhs.get())->values;
   auto sz = values.size();
 
   if (sz != rvs.size())
   return 0;
 
-  auto i=0;
-  for (auto p=values.begin(), e=values.end(); p != e; ++p,++i) {
-    if (auto r= rvs.find(_1_(p)); r != rvs.end())
-    { auto ro= *r;
-      if (_1(_2_(p))->equals(_1(_2(ro))) &&
-          _2(_2_(p))->equals(_2(_2(ro)))) continue; }
-    break;
+  for (auto& x : values) {
+    auto r= rvs.find(_1(x));
+    if (r == rvs.end() ||
+        !(key ? _2(x)->sameKey(_2_(r)) : _2(x)->equals(_2_(r)))) return 0;
   }
-  return i >= sz;
+  return 1;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int LHash::compare(d::DValue rhs) const {
-  const LHash* rs= d::is_same(rhs,this) ? vcast<LHash>(rhs) : P_NIL;
-  auto sz = values.size();
-  if (rs)
-  { auto rc= rs->count();
-    if (sz != rc)
-      return sz > rc ? 1 : -1; }
-  return pr_str().compare(rhs->pr_str());
+  const LHash* rs= d::is_same(rhs,this) ? s__cast(LHash,rhs.get()) : P_NIL;
+  auto sz = count();
+  if (E_NIL(rs))
+    return d::compare_types(this, rhs.get());
+  if (auto rc= rs->count(); sz != rc)
+    return sz > rc ? 1 : -1;
+  // unordered, so ordered by hash
+  if (equals(rhs)) return 0;
+  auto h= hash(), rh= rs->hash();
+  return h != rh ? (h > rh ? 1 : -1) : (this > rs ? 1 : -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the same for any order of the entries
+size_t LHash::hash() const {
+  if (_hash == 0) {
+    size_t h= values.size();
+    for (auto& x : values)
+      h += d::hash_combine(_1(x)->hash(), _2(x)->hash());
+    _hash=h;
+  }
+  return _hash;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LHash::trace(d::Tracer& t) const {
+  LValue::trace(t);
+  for (auto& x : values) {
+    t.visit(_1(x));
+    t.visit(_2(x));
+  }
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -585,7 +660,14 @@ bool LNative::equals(d::DValue rhs) const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int LNative::compare(d::DValue rhs) const {
-  return pr_str().compare(rhs->pr_str());
+  return !d::is_same(rhs,this)
+         ? d::compare_types(this, rhs.get())
+         : _name.compare(s__cast(LNative,rhs.get())->_name);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t LNative::hash() const {
+  return std::hash<stdstr>()(_name);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -600,7 +682,6 @@ d::DValue LNative::invoke(Lisper* p) {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static int L_SEED=0;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr LLambda::pr_str(bool) const {
   return "(lambda)@" + _name;
@@ -649,7 +730,7 @@ d::DValue LLambda::invoke(Lisper* p) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 LLambda::LLambda(const StrVec& _args, d::DValue body, d::DFrame env)
-: LFunction("anon#" + N_STR(++L_SEED)) {
+: LFunction("anon#" + N_STR(d::Isolate::current()->nextId())) {
   this->body = body;
   this->env= env;
   s__ccat(params, _args);
@@ -675,7 +756,7 @@ LLambda::LLambda(const LLambda* rhs, d::DValue m) : LFunction(m) {
 bool LLambda::equals(d::DValue rhs) const {
   if (!d::is_same(rhs,this))
   return 0;
-  auto x= vcast<LLambda>(rhs);
+  auto x= s__cast(LLambda,rhs.get());
   return _name == x->_name &&
          a::equals<stdstr>(params, x->params) &&
          body.get() == x->body.get();
@@ -683,7 +764,21 @@ bool LLambda::equals(d::DValue rhs) const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int LLambda::compare(d::DValue rhs) const {
-  return pr_str().compare(rhs->pr_str());
+  return !d::is_same(rhs,this)
+         ? d::compare_types(this, rhs.get())
+         : _name.compare(s__cast(LLambda,rhs.get())->_name);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t LLambda::hash() const {
+  return std::hash<stdstr>()(_name);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LLambda::trace(d::Tracer& t) const {
+  LValue::trace(t);
+  t.visit(body);
+  t.visit(env);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -701,11 +796,6 @@ stdstr LMacro::pr_str(bool) const {
   return "(macro)@" + _name;
 }
 
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-bool lessThan(d::DValue a, d::DValue b) {
-  return a->equals(b) ? false : (a->compare(b) < 0);
-}
-
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 LSet::LSet(d::VSlice more) : LSet() {
   for (auto i = more.begin; i != more.end; ++i)
@@ -720,12 +810,12 @@ LSet::LSet(d::ValVec& v) : LSet(d::VSlice(v)) {}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 LSet::LSet(d::DValue m) : LValue(m) {
-  values=new std::set<d::DValue,SetCompare> { &lessThan };
+  values=new d::ValueSet();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 LSet::LSet() {
-  values=new std::set<d::DValue,SetCompare> { &lessThan };
+  values=new d::ValueSet();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -734,20 +824,18 @@ LSet::~LSet() {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-LSet::LSet(const std::set<d::DValue,SetCompare>& m) : LSet() {
-  for (auto& x : m)
-    values->insert(x);
+LSet::LSet(const d::ValueSet& m) {
+  values=new d::ValueSet(m);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-LSet::LSet(const LSet* rhs, d::DValue m) : LSet(m) {
-  for (auto& x : *(rhs->values))
-    values->insert(x);
+LSet::LSet(const LSet* rhs, d::DValue m) : LValue(m) {
+  values=new d::ValueSet(*(rhs->values));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LSet::conj(d::VSlice more) const {
-  std::set<d::DValue,SetCompare> m(*values);
+  d::ValueSet m(*values);
   for (auto i = more.begin; i != more.end; ++i)
     m.insert(*i);
   return SET_VAL(m);
@@ -755,7 +843,7 @@ d::DValue LSet::conj(d::VSlice more) const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LSet::disj(d::VSlice more) const {
-  std::set<d::DValue,SetCompare> m(*values);
+  d::ValueSet m(*values);
   for (auto i= more.begin; i != more.end; ++i)
     m.erase(*i);
   return SET_VAL(m);
@@ -804,10 +892,7 @@ d::DValue LSet::get(d::DValue key) const {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue LSet::eval(Lisper* p, d::DFrame e) {
-  std::set<d::DValue,SetCompare> out(lessThan);
-  for (auto& it : *values)
-    out.insert(it);
-  return SET_VAL(out);
+  return SET_VAL(*values);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -826,28 +911,46 @@ bool LSet::equals(d::DValue rhs) const {
   if (!d::is_same(rhs,this))
   return 0;
 
-  auto const &rvs = vcast<LSet>(rhs)->values;
+  auto const &rvs = s__cast(LSet,rhs.get())->values;
   auto sz = values->size();
 
   if (sz != rvs->size())
   return 0;
 
-  auto i=0;
-  for (auto p=values->begin(), e=values->end(); p != e; ++p,++i)
-  { auto r= rvs->find(*p);
-    if (r != rvs->end()) continue; else break; }
-  return i >= sz;
+  for (auto& x : *values)
+    if (!s__contains(*rvs, x)) return 0;
+  return 1;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int LSet::compare(d::DValue rhs) const {
-  const LSet* rs= d::is_same(rhs,this) ? vcast<LSet>(rhs) : P_NIL;
-  auto sz = values->size();
-  if (rs)
-  { auto rc = rs->count();
-    if (sz != rc)
-      return sz < rc ? -1 : 1; }
-  return pr_str().compare(rhs->pr_str());
+  const LSet* rs= d::is_same(rhs,this) ? s__cast(LSet,rhs.get()) : P_NIL;
+  auto sz = count();
+  if (E_NIL(rs))
+    return d::compare_types(this, rhs.get());
+  if (auto rc = rs->count(); sz != rc)
+    return sz < rc ? -1 : 1;
+  // unordered, so ordered by hash
+  if (equals(rhs)) return 0;
+  auto h= hash(), rh= rs->hash();
+  return h != rh ? (h > rh ? 1 : -1) : (this > rs ? 1 : -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+size_t LSet::hash() const {
+  if (_hash == 0) {
+    size_t h= values->size();
+    for (auto& x : *values)
+      h += x->hash();
+    _hash=h;
+  }
+  return _hash;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LSet::trace(d::Tracer& t) const {
+  LValue::trace(t);
+  for (auto& x : *values) t.visit(x);
 }
 
 
@@ -16,8 +16,6 @@
 
 #include "../dsl/dsl.h"
 
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-#define HASH_VAL(k,v) std::pair<d::DValue,d::DValue>(k,v)
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 #define MTD_WITH_META(T) \
   d::DValue withMeta(d::DValue m) const { return d::DValue(new T(this, m)); }
@@ -28,8 +26,6 @@ namespace a= czlab::aeon;
 namespace d= czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-typedef bool (*SetCompare) (d::DValue, d::DValue);
-typedef std::pair<d::DValue, d::DValue> VPair;
 struct Lisper;
 typedef d::DValue (*Invoker) (Lisper*, d::VSlice);
 
@@ -109,6 +105,7 @@ struct LValue : public d::Data {
   virtual bool truthy() const { return 1; }
   d::DValue meta() const { return metaObj; }
   d::Addr addr() const { return loc; }
+  virtual void trace(d::Tracer&) const;
   virtual ~LValue() {}
 
   protected:
@@ -160,8 +157,7 @@ struct LFalse : public LValue {
   }
 
   virtual int compare(d::DValue rhs) const {
-    return d::is_same(rhs, this)
-           ? 0 : pr_str().compare(rhs->pr_str());
+    return d::compare_types(this, rhs.get());
   }
 
 
@@ -191,8 +187,7 @@ struct LTrue : public LValue {
   }
 
   virtual int compare(d::DValue rhs) const {
-    return d::is_same(rhs, this)
-           ? 0 : pr_str().compare(rhs->pr_str());
+    return d::compare_types(this, rhs.get());
   }
 
   virtual bool equals(d::DValue rhs) const {
@@ -233,8 +228,7 @@ struct LNil : public LValue {
   }
 
   virtual int compare(d::DValue rhs) const {
-    return d::is_same(rhs, this)
-           ? 0 : pr_str().compare(rhs->pr_str());
+    return d::compare_types(this, rhs.get());
   }
 
   virtual ~LNil() {}
@@ -263,17 +257,19 @@ struct LChar : public LValue {
 
   virtual bool equals(d::DValue rhs) const {
     return d::is_same(rhs, this) &&
-           value == vcast<LChar>(rhs)->value;
+           value == s__cast(LChar,rhs.get())->value;
   }
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs, this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
-    { auto c = vcast<LChar>(rhs)->value;
+    { auto c = s__cast(LChar,rhs.get())->value;
       return value==c ? 0 : value > c ? 1 : -1; }
   }
 
+  virtual size_t hash() const { return std::hash<Tchar>()(value); }
+
   MTD_WITH_META(LChar)
 
   Tchar impl() { return value; }
@@ -316,13 +312,15 @@ struct LAtom : public LValue {
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs, this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
-      return value->compare(vcast<LAtom>(rhs)->value);
+      return value->compare(s__cast(LAtom,rhs.get())->value);
   }
 
   MTD_WITH_META(LAtom)
 
+  virtual void trace(d::Tracer&) const;
+
   LAtom() { value= NIL_VAL();}
   virtual ~LAtom() {}
 
@@ -356,20 +354,36 @@ struct LNumber : public LValue {
     if (!d::is_same(rhs, this))
       return false;
     else
-    { auto p= vcast<LNumber>(rhs);
+    { auto p= s__cast(LNumber,rhs.get());
       return isInt() == p->isInt() &&
              a::fuzzy_equals(getFloat(), p->getFloat()); }
   }
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs, this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
-    { auto f= vcast<LNumber>(rhs)->getFloat();
+    { auto f= s__cast(LNumber,rhs.get())->getFloat();
       auto f2= getFloat();
       return a::fuzzy_equals(f, f2) ? 0 : (f2 > f ? 1 : -1); }
   }
 
+  virtual bool sameKey(d::DValue rhs) const {
+    if (!d::is_same(rhs, this))
+      return false;
+    else
+    { auto p= s__cast(LNumber,rhs.get());
+      return isInt() == p->isInt() &&
+             (isInt() ? num.n == p->num.n
+                      : d::real_key(num.r) == d::real_key(p->num.r)); }
+  }
+
+  virtual size_t hash() const {
+    return isInt()
+           ? std::hash<llong>()(num.n)
+           : std::hash<double>()(d::real_key(num.r));
+  }
+
     MTD_WITH_META(LNumber)
 
     virtual d::DValue eval(Lisper*, d::DFrame) {
@@ -430,16 +444,18 @@ struct LString : public LValue, public LSeqable {
 
   virtual bool equals(d::DValue rhs) const {
     return d::is_same(rhs, this) &&
-           value == vcast<LString>(rhs)->value;
+           value == s__cast(LString,rhs.get())->value;
   }
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs, this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
-      return value.compare(vcast<LString>(rhs)->value);
+      return value.compare(s__cast(LString,rhs.get())->value);
   }
 
+  virtual size_t hash() const;
+
   MTD_WITH_META(LString)
 
   virtual ~LString() {}
@@ -475,13 +491,15 @@ struct LString : public LValue, public LSeqable {
   LString(cstdstr& s) { value=s; }
 
   stdstr value;
+  mutable size_t _hash=0;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct LKeyword : public LValue {
 
+  // a copy, so the hash comes along
   virtual d::DValue eval(Lisper*, d::DFrame) {
-    return WRAP_VAL(LKeyword,value);
+    return WRAP_VAL(LKeyword, this, DVAL_NIL);
   }
 
   static d::DValue make(d::DToken t) {
@@ -497,16 +515,18 @@ struct LKeyword : public LValue {
 
   virtual bool equals(d::DValue rhs) const {
     return d::is_same(rhs, this) &&
-           value == vcast<LKeyword>(rhs)->value;
+           value == s__cast(LKeyword,rhs.get())->value;
   }
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs,this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
-      return value.compare(vcast<LKeyword>(rhs)->value);
+      return value.compare(s__cast(LKeyword,rhs.get())->value);
   }
 
+  virtual size_t hash() const { return _hash; }
+
   stdstr impl() const { return value; }
 
   virtual ~LKeyword() {}
@@ -516,12 +536,15 @@ struct LKeyword : public LValue {
 
   LKeyword(const LKeyword* rhs, d::DValue m) : LValue(m) {
     value=rhs->value;
+    _hash=rhs->_hash;
   }
 
   LKeyword(d::DToken);
   LKeyword(cstdstr&);
 
   stdstr value;
+  // keywords are mostly keys, so hashed as they are made
+  size_t _hash=0;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -543,16 +566,19 @@ struct LSymbol : public LValue {
 
   virtual bool equals(d::DValue rhs) const {
     return d::is_same(rhs,this) &&
-           value == vcast<LSymbol>(rhs)->value;
+           value == s__cast(LSymbol,rhs.get())->value;
   }
 
   virtual int compare(d::DValue rhs) const {
     if (!d::is_same(rhs,this))
-      return pr_str().compare(rhs->pr_str());
+      return d::compare_types(this, rhs.get());
     else
-      return value.compare(vcast<LSymbol>(rhs)->value);
+      return value.compare(s__cast(LSymbol,rhs.get())->value);
   }
 
+  // renamed by macros, so never cached
+  virtual size_t hash() const;
+
   stdstr impl() const { return value; }
   void rename(cstdstr& n) { value=n; }
 
@@ -590,10 +616,15 @@ struct LSequential : public LValue, public LSeqable {
   virtual int count() const { return values.size(); }
 
   virtual bool equals(d::DValue) const;
+  virtual bool sameKey(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual size_t hash() const;
+  virtual void trace(d::Tracer&) const;
 
   protected:
 
+  // element by element, by sameKey() if key
+  bool match(d::DValue, bool key) const;
   virtual ~LSequential() {}
 
   LSequential(const LSequential*, d::DValue);
@@ -602,6 +633,8 @@ struct LSequential : public LValue, public LSeqable {
   LSequential() {}
   LSequential(d::Addr a) : LValue(a) {}
   d::ValVec values;
+  // the values never change after construction
+  mutable size_t _hash=0;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -726,7 +759,7 @@ struct LVec : public LSequential {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct LSet : public LValue, public LSeqable {
 
-  static d::DValue make(const std::set<d::DValue,SetCompare>& s) {
+  static d::DValue make(const d::ValueSet& s) {
     return WRAP_VAL(LSet,s);
   }
 
@@ -763,6 +796,8 @@ struct LSet : public LValue, public LSeqable {
 
   virtual bool equals(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual size_t hash() const;
+  virtual void trace(d::Tracer&) const;
 
   virtual bool isEmpty() const { return values->empty(); }
   virtual int count() const { return values->size(); }
@@ -776,20 +811,21 @@ struct LSet : public LValue, public LSeqable {
 
   protected:
 
-  LSet(const std::set<d::DValue,SetCompare>&);
+  LSet(const d::ValueSet&);
   LSet(const LSet*, d::DValue);
   LSet(d::DValue);
   LSet(d::VSlice);
   LSet(d::Addr, d::ValVec&);
   LSet(d::ValVec&);
 
-  std::set<d::DValue,SetCompare>* values;
+  d::ValueSet* values;
+  mutable size_t _hash=0;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct LHash : public LValue, public LSeqable {
 
-  static d::DValue make(const std::map<stdstr, VPair>& s) {
+  static d::DValue make(const d::ValueMap& s) {
     return WRAP_VAL(LHash,s);
   }
 
@@ -814,7 +850,10 @@ struct LHash : public LValue, public LSeqable {
   d::DValue get(d::DValue) const;
 
   virtual bool equals(d::DValue) const;
+  virtual bool sameKey(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual size_t hash() const;
+  virtual void trace(d::Tracer&) const;
 
   virtual bool isEmpty() const { return values.empty(); }
   virtual int count() const { return values.size(); }
@@ -838,14 +877,18 @@ struct LHash : public LValue, public LSeqable {
 
   protected:
 
-  LHash(const std::map<stdstr, VPair>&);
+  LHash(const d::ValueMap&);
   LHash(const LHash* rhs, d::DValue);
   LHash(d::VSlice);
 
   LHash(d::Addr,d::ValVec&);
   LHash(d::ValVec&);
+  // entry by entry, by sameKey() if key
+  bool match(d::DValue, bool key) const;
 
-  std::map<stdstr,VPair> values;
+  // keyed on the values, see d::ValueHash
+  d::ValueMap values;
+  mutable size_t _hash=0;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -892,6 +935,8 @@ struct LLambda : public LFunction {
 
   virtual bool equals(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual size_t hash() const;
+  virtual void trace(d::Tracer&) const;
 
   d::DFrame bindContext(d::VSlice);
   LLambda() : LFunction("") {}
@@ -967,6 +1012,7 @@ struct LNative : public LFunction {
 
   virtual bool equals(d::DValue) const;
   virtual int compare(d::DValue) const;
+  virtual size_t hash() const;
 
   LNative() : LFunction("") { S_NIL(fn); }
   virtual ~LNative() {}
@@ -0,0 +1,187 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include "../dsl/vm.h"
+#include "parser.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::spi {
+namespace a = czlab::aeon;
+namespace d = czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Bytecode for the nodes, see dsl/vm.h.  Variables are not typed
+// at run time, so only literals have a known kind and most ops
+// are the generic ones that check their args.
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int target(d::Assembler* a, int dst) {
+  return dst < 0 ? a->temp() : dst;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand BinOp::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  auto t= a->top();
+  auto l= lhs->compile(a, -1);
+  auto r= rhs->compile(a, -1);
+  auto ints= l.kind == d::K_INT && r.kind == d::K_INT;
+  int op, out= ints ? d::K_INT : d::K_ANY;
+  switch (token->type()) {
+    case d::T_MINUS: op= ints ? d::OP_SUBI : d::OP_SUB; break;
+    case d::T_PLUS: op= ints ? d::OP_ADDI : d::OP_ADD; break;
+    case d::T_MULT: op= ints ? d::OP_MULI : d::OP_MUL; break;
+    case T_INT_DIV: op= d::OP_QUO; out= d::K_INT; break;
+    case d::T_DIV: op= d::OP_DIV; out= d::K_REAL; break;
+    default:
+      RAISE(d::Unsupported, "No bytecode for op %d", token->type());
+  }
+  a->emit(op, res, l.reg, r.reg);
+  a->release(t);
+  return d::Operand{res, out};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand String::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  a->emit(d::OP_LOADK, res,
+          a->konst(d::Value(d::String::make(token->getStr()))));
+  return d::Operand{res, d::K_STR};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Num::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  if (token->type() == d::T_INT) {
+    auto n= token->getInt();
+    if ((int) n == n) {
+      a->emit(d::OP_LOADI, res, (int) n);
+    } else {
+      a->emit(d::OP_LOADK, res, a->konst(d::Value::of(n)));
+    }
+    return d::Operand{res, d::K_INT};
+  }
+  a->emit(d::OP_LOADK, res, a->konst(d::Value::of(token->getFloat())));
+  return d::Operand{res, d::K_REAL};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand UnaryOp::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  auto t= a->top();
+  auto x= expr->compile(a, -1);
+  a->emit(token->type() == d::T_MINUS ? d::OP_NEG : d::OP_NUM, res, x.reg);
+  a->release(t);
+  return d::Operand{res, x.kind == d::K_STR ? d::K_ANY : x.kind};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Compound::compile(d::Assembler* a, int) {
+  for (auto& s : statements) {
+    auto t= a->top();
+    s->compile(a, -1);
+    a->release(t);
+  }
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Assignment::compile(d::Assembler* a, int) {
+  auto pv= DCAST(Var, lhs);
+  auto& x= pv->addr;
+  if (!x.ok()) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(pv->name()));
+  }
+  a->store(x, rhs->compile(a, x.depth == 0 ? x.slot : -1).reg);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Var::compile(d::Assembler* a, int dst) {
+  if (!addr.ok()) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(name()));
+  }
+  return a->load(addr, d::K_ANY, dst);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Type::compile(d::Assembler*, int) {
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Param::compile(d::Assembler*, int) {
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand VarDecl::compile(d::Assembler* a, int) {
+  // set by name in eval(), so a slot of the current scope
+  auto n= a->code().scope->slot(name());
+  if (n < 0) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(name()));
+  }
+  a->emit(d::OP_NIL, n);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Block::compile(d::Assembler* a, int) {
+  for (auto& x : declarations) {
+    auto t= a->top();
+    x->compile(a, -1);
+    a->release(t);
+  }
+  return compound->compile(a, -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the body goes to its own proto when first called
+d::Operand ProcedureDecl::compile(d::Assembler*, int) {
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand ProcedureCall::compile(d::Assembler* a, int) {
+  auto fs= DCAST(d::FnSymbol, proc_symbol);
+  if (fs->params().size() != args.size() || addr.depth < 0) {
+    // the tree walker reports it
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(name()));
+  }
+  // args belong to the caller, in consecutive registers
+  auto base= a->top();
+  for (auto& x : args) {
+    auto r= a->temp();
+    x->compile(a, r);
+    a->release(r+1);
+  }
+  auto site= a->call(a->proto(proc_symbol),
+                     base, (int) args.size(), addr.depth);
+  a->emit(d::OP_CALL, site);
+  a->release(base);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Program::compile(d::Assembler* a, int) {
+  return block->compile(a, -1);
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
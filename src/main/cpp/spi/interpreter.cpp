@@ -13,6 +13,7 @@
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
 #include <iostream>
+#include "../dsl/isolate.h"
 #include "interpreter.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -20,42 +21,90 @@ namespace czlab::spi {
 namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Interpreter::Interpreter(const Tchar* src) {
+Interpreter::Interpreter(const Tchar* src, bool compiled, cstdstr& cache) {
   source = src;
+  this->compiled= compiled;
+  this->cache= cache;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Interpreter::interpret() {
+  // probes live in the tree, so a profiled run walks it
+  auto vm= compiled && !profiler;
+  d::ProgramCache pc(vm ? cache : "");
+  auto key= pc.on() ? d::ProgramCache::key("spi", source) : "";
+  std::vector<d::Proto> code;
+  if (pc.load(key, code)) {
+    d::VM(code, this).run();
+    return P_NIL;
+  }
   SimplePascalParser p(source);
   auto tree= p.parse();
-  return check(tree), eval(tree);
+  check(tree);
+  folded= d::Folder().run(tree);
+  if (!vm) {
+    return eval(tree);
+  }
+  d::Assembler a;
+  try {
+    a.compile("root", symbols, tree);
+  } catch (const d::Unsupported&) {
+    return eval(tree);
+  }
+  pc.save(key, a.protos);
+  d::VM(a.protos, this).run();
+  return P_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Interpreter::eval(d::DAst tree) {
-  auto res= (pushFrame("root"),tree->eval(this));
+  auto res= (pushFrame("root", symbols, P_NIL),tree->eval(this));
   popFrame();
   return res;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Interpreter::pushFrame(const std::string& name) {
+  callers.push(stack);
   stack= d::Frame::make(name, stack);
   return stack;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DFrame Interpreter::pushFrame(cstdstr& name,
+                                 d::DTable scope, d::DFrame outer) {
+  callers.push(stack);
+  stack= d::Frame::make(name, scope, outer);
+  return stack;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Interpreter::popFrame() {
   if (stack) {
     auto f= stack;
-    std::cout << f->pr_str() << "\n";
-    stack=stack->getOuter();
+    d::Isolate::current()->out() << f->pr_str() << "\n";
+    if (callers.empty()) {
+      stack=stack->getOuter();
+    } else {
+      stack=callers.top();
+      callers.pop();
+    }
     return f;
   } else {
     return P_NIL;
   }
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// prints the frame as popFrame() does
+void Interpreter::leave(const d::Proto& p, const d::Value* slots) {
+  auto f= d::Frame::make(p.name, p.scope, P_NIL);
+  for (auto i=0; i < p.nslots; ++i) {
+    f->store(0, i, slots[i]);
+  }
+  d::Isolate::current()->out() << f->pr_str() << "\n";
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Interpreter::peekFrame() const {
   return stack;
@@ -76,6 +125,16 @@ d::DValue Interpreter::getValue(cstdstr& name) const {
   return stack ? stack->get(name) : P_NIL;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Interpreter::setValue(const d::LexAddr& a, d::DValue v) {
+  return stack ? stack->set(a.depth, a.slot, v) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Interpreter::getValue(const d::LexAddr& a) const {
+  return stack ? stack->get(a.depth, a.slot) : P_NIL;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Interpreter::check(d::DAst tree) {
   symbols= SymTable::make("root");
@@ -98,6 +157,11 @@ d::DSymbol Interpreter::define(d::DSymbol s) {
   return s;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::LexAddr Interpreter::resolve(cstdstr& n) const {
+  return symbols->resolve(n);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DTable Interpreter::pushScope(cstdstr& name) {
   symbols = SymTable::make(name, symbols);
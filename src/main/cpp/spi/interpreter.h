@@ -13,6 +13,9 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include <stack>
+#include "../dsl/cache.h"
+#include "../dsl/fold.h"
 #include "parser.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -20,15 +23,19 @@ namespace czlab::spi {
 namespace d= czlab::dsl;
 //
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-struct Interpreter : public d::IEvaluator, public d::IAnalyzer {
+struct Interpreter : public d::IEvaluator,
+                     public d::IAnalyzer, public d::IHost {
 
   //evaluator
   virtual d::DValue setValueEx(cstdstr&, d::DValue);
   virtual d::DValue setValue(cstdstr&, d::DValue);
 
   virtual d::DValue getValue(cstdstr&) const;
+  virtual d::DValue setValue(const d::LexAddr&, d::DValue);
+  virtual d::DValue getValue(const d::LexAddr&) const;
   //virtual bool contains(const stdstr&) const;
   virtual d::DFrame pushFrame(cstdstr& name);
+  virtual d::DFrame pushFrame(cstdstr&, d::DTable, d::DFrame);
   virtual d::DFrame popFrame();
   virtual d::DFrame peekFrame() const;
 
@@ -40,6 +47,9 @@ struct Interpreter : public d::IEvaluator, public d::IAnalyzer {
   void writeInt(long) {}
   void writeln() {}
 
+  //vm
+  virtual void leave(const d::Proto&, const d::Value*);
+
   //analyzer
   virtual d::DSymbol search(cstdstr&) const;
   virtual d::DSymbol find(cstdstr&) const;
@@ -47,15 +57,26 @@ struct Interpreter : public d::IEvaluator, public d::IAnalyzer {
   virtual d::DTable pushScope(cstdstr& name);
   virtual d::DTable popScope();
   virtual d::DSymbol define(d::DSymbol);
+  virtual d::LexAddr resolve(cstdstr&) const;
 
-  Interpreter(const Tchar* src);
+  // compiled runs the program on the vm, unless under a profiler
+  // or if the program has a node without bytecode, a cache dir
+  // keeps the bytecode across runs, see dsl/cache.h
+  Interpreter(const Tchar* src, bool compiled=false, cstdstr& cache="");
+  // the program's value, nil if it ran compiled
   d::DValue interpret();
+  // node counts around constant folding, zero on a cache hit
+  d::FoldCounts folded;
   virtual ~Interpreter() {}
 
   private:
 
   const char* source;
+  bool compiled;
+  stdstr cache;
   d::DFrame stack;
+  // frames link lexically, so returns go through here
+  std::stack<d::DFrame> callers;
   d::DTable symbols;
 
   void check(d::DAst);
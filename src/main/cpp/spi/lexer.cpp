@@ -21,7 +21,7 @@ namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 // map, keyword-type -> keyword-string
-std::map<int, stdstr> TOKENS {
+constexpr d::Keyword TOKENS[] {
   {T_PROCEDURE, "PROCEDURE"},
   {T_PROGRAM, "PROGRAM"},
   {T_VAR, "VAR"},
@@ -34,13 +34,12 @@ std::map<int, stdstr> TOKENS {
   {T_END, "END"}
 };
 
-auto KEYWORDS=a::map_reflect(TOKENS);
+constexpr d::KeywordTable KEYWORDS(TOKENS);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr typeToString(int type) {
-  return s__contains(TOKENS, type)
-         ? map__val(TOKENS,type)
-         : ("token=" + N_STR(type));
+  auto s= KEYWORDS.name(type);
+  return s.size() ? stdstr(s) : ("token=" + N_STR(type));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -52,7 +51,7 @@ Lexer::Lexer(const Tchar* src) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Lexer::isKeyword(cstdstr& k) const {
-  return s__contains(KEYWORDS, k);
+  return KEYWORDS.contains(k);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -92,9 +91,9 @@ bool filter(Tchar ch, bool first) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Lexer::id() {
   auto res= d::identifier(_ctx, &filter);
-  auto S= a::to_upper(_1(res));
-  return isKeyword(S)
-    ? d::Token::make(KEYWORDS.at(S), S, _2(res))
+  auto t= KEYWORDS.find(_1(res), true);
+  return t >= 0
+    ? d::Token::make(t, a::to_upper(_1(res)), _2(res))
     : d::Token::make(d::T_IDENT, _1(res), _2(res));
 }
 
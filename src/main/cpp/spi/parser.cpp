@@ -12,6 +12,7 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include "../dsl/profiler.h"
 #include "parser.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -42,6 +43,12 @@ d::DValue expected(cstdstr& m, d::DValue v) {
 }
 
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the profiler's name for a node, at the line of its token
+d::Profiler::Site site(const d::DAst& n, cstdstr& what) {
+  return d::Profiler::Site{DCAST(Ast,n)->token->addr().first, what};
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Ast::Ast(d::DToken t) {
   token=t;
@@ -201,6 +208,8 @@ void Compound::visit(d::IAnalyzer* a) {
 d::DValue Compound::eval(d::IEvaluator* e) {
   d::DValue ret;
   for (auto& it : statements) {
+    d::Probe _p(e, it.get(),
+                [&]() { return site(it, DCAST(Ast,it)->name()); });
     ret=it->eval(e);
   }
   return ret;
@@ -223,6 +232,8 @@ void Assignment::visit(d::IAnalyzer* a) {
           v.c_str(),
           d::pr_addr(i).c_str());
   }
+  lhs->visit(a);
+  rhs->visit(a);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -232,7 +243,8 @@ d::DValue Assignment::eval(d::IEvaluator* e) {
   auto r= rhs->eval(e);
   DEBUG("Assigning: %s := %s.",
         C_STR(v), C_STR(r->pr_str(1)));
-  return e->setValueEx(v, r);
+  auto& x= DCAST(Var,lhs)->addr;
+  return x.ok() ? e->setValue(x, r) : e->setValueEx(v, r);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -250,11 +262,12 @@ void Var::visit(d::IAnalyzer* a) {
           n.c_str(),
           d::pr_addr(i).c_str());
   }
+  addr= a->resolve(n);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Var::eval(d::IEvaluator* e) {
-  return e->getValue(token->getStr());
+  return addr.ok() ? e->getValue(addr) : e->getValue(token->getStr());
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -379,7 +392,7 @@ void ProcedureDecl::visit(d::IAnalyzer* a) {
   auto fs= d::FnSymbol::make( name());
   auto fp= DCAST(d::FnSymbol,fs);
   a->define(fs);
-  a->pushScope(name());
+  fp->setScope(a->pushScope(name()));
 
   for (auto& p : params) {
     auto p_ = s__cast(Param,p.get());
@@ -416,6 +429,7 @@ void ProcedureCall::visit(d::IAnalyzer* a) {
   //get the corresponding symbol
   if (auto x = a->search(_name); x) {
     proc_symbol = x;
+    addr= a->resolve(_name);
   } else {
     auto i=token->addr();
     E_SYNTAX(
@@ -432,15 +446,26 @@ d::DValue ProcedureCall::eval(d::IEvaluator* e) {
   auto z= args.size();
 
   ASSERT1(fs->params().size() == z)
-  e->pushFrame(_name);
+  // args belong to the caller's frame
+  d::ValVec vs;
+  for (auto& a : args) {
+    s__conj(vs, a->eval(e));
+  }
+  // link to the frame of the declaring scope, not the caller
+  e->pushFrame(_name,
+               fs->scope(), d::Frame::getOuter(e->peekFrame(), addr.depth));
 
   for (auto i=0; i < z; ++i) {
     auto& p= fs->params()[i];
-    auto v= args[i]->eval(e);
-    e->setValue(DCAST(d::VarSymbol, p)->name(), v);
+    e->setValue(DCAST(d::VarSymbol, p)->name(), vs[i]);
   }
 
-  auto r= fs->body()->eval(e);
+  d::DValue r;
+  {
+    d::Probe _p(e, fs->body().get(),
+                [&]() { return site(fs->body(), _name); });
+    r= fs->body()->eval(e);
+  }
   e->popFrame();
   return r;
 }
@@ -45,6 +45,8 @@ struct BinOp : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
   virtual ~BinOp() {}
 
   d::DAst lhs;
@@ -63,6 +65,8 @@ struct Num : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
   virtual stdstr name() const;
   virtual ~Num() {}
 
@@ -75,6 +79,8 @@ struct String : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST( String,t);
@@ -95,6 +101,8 @@ struct UnaryOp : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
   virtual stdstr name() const;
   virtual ~UnaryOp() {}
   d::DAst expr;
@@ -109,6 +117,8 @@ struct Compound : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Compound() {}
 
   static d::DAst make(d::DToken k) {
@@ -126,12 +136,15 @@ struct Var : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
   virtual ~Var() {}
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST( Var,t);
   }
 
+  d::LexAddr addr;
+
   private:
   Var(d::DToken);
 };
@@ -141,6 +154,7 @@ struct Type : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
   virtual ~Type() {}
 
   static d::DAst make(d::DToken t) {
@@ -160,6 +174,8 @@ struct Assignment : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Assignment() {}
 
   d::DAst lhs;
@@ -181,6 +197,9 @@ struct NoOp : public Ast {
   }
 
   virtual void visit(d::IAnalyzer*) {}
+  virtual d::Operand compile(d::Assembler*, int) {
+    return d::Operand{-1, 0};
+  }
   virtual ~NoOp() {}
 
   private:
@@ -196,6 +215,7 @@ struct Param : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
   virtual ~Param() {}
 
   d::DAst var_node;
@@ -214,6 +234,7 @@ struct VarDecl : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
   virtual ~VarDecl() {}
 
   d::DAst var_node;
@@ -232,6 +253,8 @@ struct Block : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Block() {}
 
   d::DAst compound;
@@ -251,6 +274,8 @@ struct ProcedureDecl : public Ast {
   virtual d::DValue eval(d::IEvaluator*);
   virtual ~ProcedureDecl() {}
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
 
   d::DAst block;
   std::vector<d::DAst> params;
@@ -269,9 +294,12 @@ struct ProcedureCall : public Ast {
   virtual d::DValue eval(d::IEvaluator*);
   virtual ~ProcedureCall() {}
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
 
   d::AstVec args;
   d::DSymbol proc_symbol;
+  d::LexAddr addr;
 
   private:
   ProcedureCall(const stdstr&, d::AstVec&, d::DToken);
@@ -286,6 +314,8 @@ struct Program : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Program() {}
 
   d::DAst block;
@@ -114,6 +114,8 @@ int main(int argc, char* argv[]) {
     Interpreter i(ARG18);
     auto r= i.interpret();
     std::cout << "result = " << r->pr_str() << "\n";
+    std::cout << "nodes " << i.folded.before
+              << " -> " << i.folded.after << " after folding\n";
     //Analyzer z(ARG);
 
   } catch ( const d::SyntaxError& e) {
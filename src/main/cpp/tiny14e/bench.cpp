@@ -0,0 +1,100 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+//////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include "../dsl/isolate.h"
+#include "interpreter.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::tiny14e {
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// one op is one pass of the loop body, on the tree, on the vm, and
+// built as C++, the build being timed apart
+void bench(cstdstr& name, cstdstr& body, int n) {
+  stdstr src= "program B;\n"
+              "var i, s : integer; x : real;\n"
+              "begin\n"
+              "  s := 0; x := 0;\n"
+              "  for i := 1 " + N_STR(n) + "\n"
+              "    " + body + "\n"
+              "  endFor;\n"
+              "end.\n";
+  for (auto vm : {false, true}) {
+    Interpreter p(src.c_str(), vm);
+    auto t= std::chrono::steady_clock::now();
+    p.interpret();
+    std::chrono::duration<double,std::nano> d= std::chrono::steady_clock::now() - t;
+    std::cout << name << (vm ? " vm" : " tree")
+              << " ns/op=" << d.count() / n << "\n";
+  }
+  auto dir= "/tmp/tiny14e-bench-" + N_STR(::time(P_NIL));
+  // the first run builds, the second loads what it built
+  for (auto built : {false, true}) {
+    Interpreter p(src.c_str(), true);
+    p.native= dir;
+    auto t= std::chrono::steady_clock::now();
+    p.interpret();
+    std::chrono::duration<double,std::nano> d= std::chrono::steady_clock::now() - t;
+    std::cout << name
+              << (built ? " native ns/op=" : " native build ms=")
+              << (built ? d.count() / n : d.count() / 1e6)
+              << (p.ranNative ? "" : " (fell back)") << "\n";
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void bench(int n) {
+  bench("int-arith", "s := s + i * 2 - i;", n);
+  bench("real-arith", "x := x + i * 0.5 - i / 3.0;", n);
+  bench("compare", "if ((i > s) && (i <> 7)) s := i; endIf;", n);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// many small scripts, each in its own isolate, on 1 to all cores
+void batch(int scripts) {
+  std::vector<d::Script> v(scripts);
+  for (auto i=0; i < scripts; ++i) {
+    auto src= "program B;\n"
+              "var i, s : integer;\n"
+              "begin\n"
+              "  s := 0;\n"
+              "  for i := 1 " + N_STR(100 + i % 50) + "\n"
+              "    s := s + i * 2 - i;\n"
+              "  endFor;\n"
+              "  writeLn(s);\n"
+              "end.\n";
+    v[i].run= [src]() { Interpreter(src.c_str(), true).interpret(); };
+  }
+  std::cout << d::BatchRunner::scaling(v, std::thread::hardware_concurrency());
+}
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+#if 0
+int main(int ac, char** av) {
+  czlab::tiny14e::bench(1000000);
+  czlab::tiny14e::batch(20000);
+  return 0;
+}
+#endif
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
@@ -0,0 +1,547 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include "../dsl/vm.h"
+#include "../dsl/fold.h"
+#include "types.h"
+#include "parser.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::tiny14e {
+namespace a = czlab::aeon;
+namespace d = czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Bytecode for the nodes, see dsl/vm.h.  Variables always hold
+// their declared type (Assignment casts), so the kinds are known
+// here and the typed ops can be used.  Anything else throws
+// d::Unsupported and the program runs on the tree walker instead.
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int target(d::Assembler* a, int dst) {
+  return dst < 0 ? a->temp() : dst;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool isNumber(const d::Operand& x) {
+  return x.kind == d::K_INT || x.kind == d::K_REAL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void wantNumber(const d::Operand& x) {
+  if (!isNumber(x)) {
+    RAISE(d::Unsupported, "No bytecode for kind %d", x.kind);
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// both sides as ints, or else both as reals
+int numeric(d::Assembler* a, d::Operand& l, d::Operand& r) {
+  wantNumber(l);
+  wantNumber(r);
+  if (l.kind == d::K_INT && r.kind == d::K_INT) {
+    return d::K_INT;
+  }
+  l= d::Operand{a->coerce(l, d::K_REAL), d::K_REAL};
+  r= d::Operand{a->coerce(r, d::K_REAL), d::K_REAL};
+  return d::K_REAL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// an int literal that fits an operand
+bool smallInt(d::DToken t, int& out) {
+  if (t->type() != d::T_INT) { return false; }
+  auto n= t->getInt();
+  out= (int) n;
+  return out == n;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the kind cast() gives, it prints strings quoted so those stay with eval()
+int castKind(d::DSymbol t) {
+  auto k= d::Assembler::kindOf(t);
+  if (k == d::K_STR || k == d::K_ANY) {
+    RAISE(d::Unsupported, "No bytecode for cast to %d", k);
+  }
+  return k;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// copy into the variable, cast to its type
+void assign(d::Assembler* a, Var* v, const d::Operand& x) {
+  auto k= castKind(v->type_symbol);
+  if (v->addr.depth == 0) {
+    a->convert(v->addr.slot, x, k);
+  } else {
+    a->store(v->addr, a->coerce(x, k));
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand BinOp::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  auto t= a->top();
+  auto k= token()->type();
+  auto l= lhs->compile(a, -1);
+  int c;
+
+  if ((k == d::T_PLUS || k == d::T_MINUS) &&
+      l.kind == d::K_INT &&
+      ((typeid(*rhs) == typeid(Num) &&
+        smallInt(DCAST(Num, rhs)->token(), c)) ||
+       d::Literal::smallInt(rhs, c))) {
+    a->emit(d::OP_ADDKI, res, l.reg, k == d::T_PLUS ? c : -c);
+    a->release(t);
+    return d::Operand{res, d::K_INT};
+  }
+
+  auto r= rhs->compile(a, -1);
+  int op, out;
+  switch (k) {
+    case d::T_PLUS:
+      out= numeric(a, l, r);
+      op= out == d::K_INT ? d::OP_ADDI : d::OP_ADDR;
+    break;
+    case d::T_MINUS:
+      out= numeric(a, l, r);
+      op= out == d::K_INT ? d::OP_SUBI : d::OP_SUBR;
+    break;
+    case d::T_MULT:
+      out= numeric(a, l, r);
+      op= out == d::K_INT ? d::OP_MULI : d::OP_MULR;
+    break;
+    case T_INT_DIV:
+      if (numeric(a, l, r) != d::K_INT) {
+        // the tree walker reports it
+        RAISE(d::Unsupported, "No bytecode for %s", "real div");
+      }
+      op= d::OP_DIVI;
+      out= d::K_INT;
+    break;
+    case d::T_DIV:
+      wantNumber(l);
+      wantNumber(r);
+      l= d::Operand{a->coerce(l, d::K_REAL), d::K_REAL};
+      r= d::Operand{a->coerce(r, d::K_REAL), d::K_REAL};
+      op= d::OP_DIVR;
+      out= d::K_REAL;
+    break;
+    default:
+      RAISE(d::Unsupported, "No bytecode for op %d", k);
+  }
+
+  a->emit(op, res, l.reg, r.reg);
+  a->release(t);
+  return d::Operand{res, out};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand String::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  a->emit(d::OP_LOADK, res,
+          a->konst(d::Value(d::String::make(token()->getStr()))));
+  return d::Operand{res, d::K_STR};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Num::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  int n;
+  if (smallInt(token(), n)) {
+    a->emit(d::OP_LOADI, res, n);
+    return d::Operand{res, d::K_INT};
+  }
+  if (token()->type() == d::T_INT) {
+    a->emit(d::OP_LOADK, res, a->konst(d::Value::of(token()->getInt())));
+    return d::Operand{res, d::K_INT};
+  }
+  a->emit(d::OP_LOADK, res, a->konst(d::Value::of(token()->getFloat())));
+  return d::Operand{res, d::K_REAL};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand UnaryOp::compile(d::Assembler* a, int dst) {
+  auto t= a->top();
+  auto x= expr->compile(a, -1);
+  wantNumber(x);
+  if (token()->type() != d::T_MINUS) {
+    a->release(t);
+    if (dst < 0) { return x; }
+    a->convert(dst, x, x.kind);
+    return d::Operand{dst, x.kind};
+  }
+  a->release(t);
+  auto res= target(a, dst);
+  a->emit(x.kind == d::K_INT ? d::OP_NEGI : d::OP_NEGR, res, x.reg);
+  return d::Operand{res, x.kind};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Compound::compile(d::Assembler* a, int) {
+  for (auto& s : statements) {
+    auto t= a->top();
+    s->compile(a, -1);
+    a->release(t);
+  }
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Assignment::compile(d::Assembler* a, int) {
+  auto pv= DCAST(Var, lhs);
+  if (!pv->addr.ok()) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(pv->name()));
+  }
+  auto x= rhs->compile(a, pv->addr.depth == 0 ? pv->addr.slot : -1);
+  assign(a, pv, x);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Var::compile(d::Assembler* a, int dst) {
+  auto k= d::Assembler::kindOf(type_symbol);
+  if (!addr.ok() || k == d::K_ANY) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(name()));
+  }
+  return a->load(addr, k, dst);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Type::compile(d::Assembler*, int) {
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand VarDecl::compile(d::Assembler* a, int) {
+  auto pv= DCAST(Var, var_node);
+  if (!pv->addr.ok()) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(pv->name()));
+  }
+  // same as cast(nil, type)
+  auto k= d::Assembler::kindOf(pv->type_symbol);
+  auto r= pv->addr.depth == 0 ? pv->addr.slot : a->temp();
+  switch (k) {
+    case d::K_INT:
+      a->emit(d::OP_LOADI, r, 0);
+    break;
+    case d::K_REAL:
+      a->emit(d::OP_LOADK, r, a->konst(d::Value::of(0.0)));
+    break;
+    case d::K_STR:
+      a->emit(d::OP_LOADK, r, a->konst(d::Value(d::String::make(""))));
+    break;
+    default:
+      RAISE(d::Unsupported, "No bytecode for %s", C_STR(pv->name()));
+  }
+  a->store(pv->addr, r);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand BoolExpr::compile(d::Assembler* a, int dst) {
+  if (terms.size() == 1) {
+    return terms[0]->compile(a, dst);
+  }
+  // res is written before the later terms are read, so never dst
+  auto res= a->temp();
+  auto t= a->top();
+  std::vector<int> done;
+  a->emit(d::OP_TRUTH, res, terms[0]->compile(a, -1).reg);
+  a->release(t);
+  for (size_t i=0; i < ops.size(); ++i) {
+    if (ops[i]->type() == T_OR) {
+      s__conj(done, a->emit(d::OP_JT, res, 0, -1));
+    }
+    auto x= terms[i+1]->compile(a, -1);
+    if (ops[i]->type() == T_XOR) {
+      auto b= a->temp();
+      a->emit(d::OP_TRUTH, b, x.reg);
+      a->emit(d::OP_NEI, res, res, b);
+    } else {
+      auto j= a->emit(d::OP_JF, x.reg, 0, -1);
+      a->emit(d::OP_LOADI, res, 1);
+      a->patch(j);
+    }
+    a->release(t);
+  }
+  for (auto j : done) { a->patch(j); }
+  if (dst >= 0) {
+    a->emit(d::OP_MOVE, dst, res);
+    res= dst;
+  }
+  return d::Operand{res, d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int BoolExpr::compileJump(d::Assembler* a, bool when) {
+  return terms.size() == 1
+         ? terms[0]->compileJump(a, when) : Ast::compileJump(a, when);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand BoolTerm::compile(d::Assembler* a, int dst) {
+  if (terms.size() == 1) {
+    return terms[0]->compile(a, dst);
+  }
+  auto res= target(a, dst);
+  auto no= terms[0]->compileJump(a, false);
+  auto yes= terms[1]->compileJump(a, true);
+  // evaluated but the answer is already false
+  for (size_t i=2; i < terms.size(); ++i) {
+    auto t= a->top();
+    terms[i]->compile(a, -1);
+    a->release(t);
+  }
+  a->patch(no);
+  a->emit(d::OP_LOADI, res, 0);
+  auto end= a->emit(d::OP_JMP, 0, 0, -1);
+  a->patch(yes);
+  a->emit(d::OP_LOADI, res, 1);
+  a->patch(end);
+  return d::Operand{res, d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int BoolTerm::compileJump(d::Assembler* a, bool when) {
+  return terms.size() == 1
+         ? terms[0]->compileJump(a, when) : Ast::compileJump(a, when);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand NotFactor::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  auto t= a->top();
+  a->emit(d::OP_NOT, res, expr->compile(a, -1).reg);
+  a->release(t);
+  return d::Operand{res, d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int NotFactor::compileJump(d::Assembler* a, bool when) {
+  return expr->compileJump(a, !when);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the op as LT, LE, EQ or NE, swapping the sides for GT and GE
+int relation(int tok, bool& swap) {
+  swap= false;
+  switch (tok) {
+    case d::T_LT: return d::T_LT;
+    case T_LTEQ: return T_LTEQ;
+    case d::T_GT: swap= true; return d::T_LT;
+    case T_GTEQ: swap= true; return T_LTEQ;
+    case T_EQUALS: return T_EQUALS;
+    case T_NOTEQ: return T_NOTEQ;
+  }
+  RAISE(d::Unsupported, "No bytecode for op %d", tok);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand RelationOp::compile(d::Assembler* a, int dst) {
+  auto res= target(a, dst);
+  auto t= a->top();
+  auto l= lhs->compile(a, -1);
+  auto r= rhs->compile(a, -1);
+  auto ints= numeric(a, l, r) == d::K_INT;
+  bool swap;
+  int op;
+  switch (relation(token()->type(), swap)) {
+    case d::T_LT: op= ints ? d::OP_LTI : d::OP_LTR; break;
+    case T_LTEQ: op= ints ? d::OP_LEI : d::OP_LER; break;
+    case T_EQUALS: op= ints ? d::OP_EQI : d::OP_EQR; break;
+    default: op= ints ? d::OP_NEI : d::OP_NER; break;
+  }
+  if (swap) { std::swap(l, r); }
+  a->emit(op, res, l.reg, r.reg);
+  a->release(t);
+  return d::Operand{res, d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// compare and branch in one op
+int RelationOp::compileJump(d::Assembler* a, bool when) {
+  auto t= a->top();
+  auto l= lhs->compile(a, -1);
+  auto r= rhs->compile(a, -1);
+  auto ints= numeric(a, l, r) == d::K_INT;
+  bool swap;
+  auto k= relation(token()->type(), swap);
+  if (swap) { std::swap(l, r); }
+  if (!when) {
+    // not (l < r) is (r <= l), not (l <= r) is (r < l)
+    switch (k) {
+      case d::T_LT: k= T_LTEQ; std::swap(l, r); break;
+      case T_LTEQ: k= d::T_LT; std::swap(l, r); break;
+      case T_EQUALS: k= T_NOTEQ; break;
+      default: k= T_EQUALS; break;
+    }
+  }
+  int op;
+  switch (k) {
+    case d::T_LT: op= ints ? d::OP_BLTI : d::OP_BLTR; break;
+    case T_LTEQ: op= ints ? d::OP_BLEI : d::OP_BLER; break;
+    case T_EQUALS: op= ints ? d::OP_BEQI : d::OP_BEQR; break;
+    default: op= ints ? d::OP_BNEI : d::OP_BNER; break;
+  }
+  a->release(t);
+  return a->emit(op, l.reg, r.reg, -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Block::compile(d::Assembler* a, int) {
+  for (auto& x : declarations) {
+    auto t= a->top();
+    x->compile(a, -1);
+    a->release(t);
+  }
+  return compound->compile(a, -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the body goes to its own proto when first called
+d::Operand ProcedureDecl::compile(d::Assembler*, int) {
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand ProcedureCall::compile(d::Assembler* a, int) {
+  auto fs= DCAST(d::FnSymbol, proc_symbol);
+  auto& ps= fs->params();
+  if (ps.size() != args.size() || addr.depth < 0) {
+    // the tree walker reports it
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(name()));
+  }
+  // args belong to the caller, in consecutive registers
+  auto base= a->top();
+  for (size_t i=0; i < args.size(); ++i) {
+    auto r= a->temp();
+    auto x= args[i]->compile(a, r);
+    a->convert(r, x, castKind(ps[i]->type()));
+    a->release(r+1);
+  }
+  auto site= a->call(a->proto(proc_symbol),
+                     base, (int) args.size(), addr.depth);
+  a->emit(d::OP_CALL, site);
+  a->release(base);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Program::compile(d::Assembler* a, int) {
+  return block->compile(a, -1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand RepeatUntil::compile(d::Assembler* a, int) {
+  // loops for as long as cond holds, as in eval()
+  auto top= a->here();
+  code->compile(a, -1);
+  a->patch(cond->compileJump(a, true), top);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand IfThenElse::compile(d::Assembler* a, int) {
+  auto no= cond->compileJump(a, false);
+  then->compile(a, -1);
+  if (elze) {
+    auto end= a->emit(d::OP_JMP, 0, 0, -1);
+    a->patch(no);
+    elze->compile(a, -1);
+    a->patch(end);
+  } else {
+    a->patch(no);
+  }
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand ForLoop::compile(d::Assembler* a, int) {
+  auto pv= DCAST(Var, var_node);
+  auto vk= d::Assembler::kindOf(pv->type_symbol);
+  if (!pv->addr.ok() || !(vk == d::K_INT || vk == d::K_REAL)) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(pv->name()));
+  }
+  auto t= a->top();
+  assign(a, pv, init->compile(a, -1));
+  a->release(t);
+  // the counter as an int, kept for the whole loop
+  auto i= a->temp();
+  auto u= a->top();
+  auto top= a->here();
+  auto z= term->compile(a, -1);
+  wantNumber(z);
+  auto zr= a->coerce(z, d::K_INT);
+  a->convert(i, pv->compile(a, -1), d::K_INT);
+  auto out= a->emit(d::OP_BLTI, zr, i, -1);
+  a->release(u);
+  code->compile(a, -1);
+  a->emit(d::OP_ADDKI, i, i, 1);
+  assign(a, pv, d::Operand{i, d::K_INT});
+  a->emit(d::OP_JMP, 0, 0, top);
+  a->patch(out);
+  a->release(t);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand WhileLoop::compile(d::Assembler* a, int) {
+  // the test sits at the bottom, one branch per pass
+  auto start= a->emit(d::OP_JMP, 0, 0, -1);
+  auto body= a->here();
+  code->compile(a, -1);
+  a->patch(start);
+  a->patch(cond->compileJump(a, true), body);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand VarInput::compile(d::Assembler* a, int) {
+  auto k= d::Assembler::kindOf(type_symbol);
+  if (!addr.ok() || k == d::K_ANY) {
+    RAISE(d::Unsupported, "No bytecode for %s", C_STR(name()));
+  }
+  auto r= addr.depth == 0 ? addr.slot : a->temp();
+  a->emit(d::OP_READ, r, k);
+  a->store(addr, r);
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Read::compile(d::Assembler* a, int) {
+  var_node->compile(a, -1);
+  if (token()->type() == T_READLN) {
+    a->emit(d::OP_FLUSH, 1);
+  }
+  return d::Operand{-1, d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Operand Write::compile(d::Assembler* a, int) {
+  for (auto& x : terms) {
+    auto t= a->top();
+    a->emit(d::OP_PUT, x->compile(a, -1).reg);
+    a->release(t);
+  }
+  a->emit(d::OP_FLUSH, token()->type() == T_WRITELN ? 1 : 0);
+  return d::Operand{-1, d::K_ANY};
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,184 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <typeinfo>
+#include "../dsl/fold.h"
+#include "types.h"
+#include "parser.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::tiny14e {
+namespace a = czlab::aeon;
+namespace d = czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Folding rules, see dsl/fold.h.  Expressions only read vars,
+// there are no functions, so every operator node is pure.
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a true left side of || is the result, the rest never runs
+d::DAst BoolExpr::fold(d::Folder* f) {
+  f->fold(terms[0]);
+  if (ops.size() > 0 &&
+      ops[0]->type() == T_OR && f->truth(terms[0]) == 1) {
+    return f->eval(this, {terms[0]});
+  }
+  for (size_t i=1; i < terms.size(); ++i) { f->fold(terms[i]); }
+  return f->eval(this, terms);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a false left side of && is the result, the rest never runs
+d::DAst BoolTerm::fold(d::Folder* f) {
+  f->fold(terms[0]);
+  if (terms.size() > 1 && f->truth(terms[0]) == 0) {
+    return f->eval(this, {terms[0]});
+  }
+  for (size_t i=1; i < terms.size(); ++i) { f->fold(terms[i]); }
+  return f->eval(this, terms);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst RelationOp::fold(d::Folder* f) {
+  f->fold(lhs);
+  f->fold(rhs);
+  return f->eval(this, {lhs, rhs});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BinOp::fold(d::Folder* f) {
+  f->fold(lhs);
+  f->fold(rhs);
+  auto t= token()->type();
+  // the check ASSERTs and exits, it cannot be caught
+  if ((t == d::T_DIV || t == T_INT_DIV) && f->zero(rhs)) {
+    return d::DAst();
+  }
+  return f->eval(this, {lhs, rhs});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Num::fold(d::Folder* f) {
+  return f->eval(this, {});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst String::fold(d::Folder* f) {
+  return f->eval(this, {});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst NotFactor::fold(d::Folder* f) {
+  f->fold(expr);
+  return f->eval(this, {expr});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst UnaryOp::fold(d::Folder* f) {
+  f->fold(expr);
+  return f->eval(this, {expr});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Compound::fold(d::Folder* f) {
+  f->fold(statements);
+  // pruned branches leave these behind
+  statements.erase(
+    std::remove_if(statements.begin(), statements.end(),
+                   [](auto& x) { return typeid(*x) == typeid(NoOp); }),
+    statements.end());
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Write::fold(d::Folder* f) {
+  f->fold(terms);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst WhileLoop::fold(d::Folder* f) {
+  f->fold(cond);
+  f->fold(code);
+  return f->truth(cond) == 0 ? NoOp::make() : d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the bounds are evaluated every pass, so only folded
+d::DAst ForLoop::fold(d::Folder* f) {
+  f->fold(init);
+  f->fold(term);
+  f->fold(code);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst IfThenElse::fold(d::Folder* f) {
+  f->fold(cond);
+  f->fold(then);
+  f->fold(elze);
+  switch (f->truth(cond)) {
+    case 1: return then;
+    case 0: return elze ? elze : NoOp::make();
+  }
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the body runs once whatever the condition
+d::DAst RepeatUntil::fold(d::Folder* f) {
+  f->fold(code);
+  f->fold(cond);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Assignment::fold(d::Folder* f) {
+  f->fold(rhs);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Block::fold(d::Folder* f) {
+  f->fold(declarations);
+  f->fold(compound);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the block is the proc symbol's body too, it is changed in place
+d::DAst ProcedureDecl::fold(d::Folder* f) {
+  f->fold(block);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst ProcedureCall::fold(d::Folder* f) {
+  f->fold(args);
+  return d::DAst();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Program::fold(d::Folder* f) {
+  f->fold(block);
+  return d::DAst();
+}
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
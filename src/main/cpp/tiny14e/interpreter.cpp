@@ -13,41 +13,89 @@
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
 #include <iostream>
+#include "../dsl/isolate.h"
 #include "interpreter.h"
+#include "native.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::tiny14e {
 namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Interpreter::Interpreter(const Tchar* src) {
+Interpreter::Interpreter(const Tchar* src, bool compiled, cstdstr& cache) {
   source = src;
+  this->compiled= compiled;
+  this->cache= cache;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Interpreter::interpret() {
+  // probes live in the tree, so a profiled run walks it
+  auto vm= compiled && !profiler;
+  d::ProgramCache pc(vm ? cache : "");
+  auto key= pc.on() ? d::ProgramCache::key("tiny14e", source) : "";
+  std::vector<d::Proto> code;
+  ranNative=false;
+  if (native.empty() && pc.load(key, code)) {
+    d::VM(code, this).run();
+    return P_NIL;
+  }
   CrenshawParser p(source);
   auto tree= p.parse();
-  return check(tree), eval(tree);
+  check(tree);
+  folded= d::Folder().run(tree);
+  if (!native.empty() && !profiler) {
+    try {
+      Native::run(Native::build(Native().lower(tree), native), this);
+      ranNative=true;
+      return P_NIL;
+    } catch (const d::Unsupported&) {}
+  }
+  if (!vm) {
+    return eval(tree);
+  }
+  d::Assembler a;
+  try {
+    a.compile("root", symbols, tree);
+  } catch (const d::Unsupported&) {
+    return eval(tree);
+  }
+  pc.save(key, a.protos);
+  d::VM(a.protos, this).run();
+  return P_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Interpreter::eval(d::DAst tree) {
-  return (pushFrame("root"), tree.get()->eval(this));
+  return (pushFrame("root", symbols, P_NIL), tree.get()->eval(this));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Interpreter::pushFrame(cstdstr& name) {
+  callers.push(stack);
   stack = d::Frame::make(name, stack);
   return stack;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DFrame Interpreter::pushFrame(cstdstr& name,
+                                 d::DTable scope, d::DFrame outer) {
+  callers.push(stack);
+  stack = d::Frame::make(name, scope, outer);
+  return stack;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Interpreter::popFrame() {
   if (stack) {
     auto f= stack;
     //::printf("Frame pop'ed:=\n%s\n", f->pr_str().c_str());
-    stack= stack->getOuter();
+    if (callers.empty()) {
+      stack= stack->getOuter();
+    } else {
+      stack= callers.top();
+      callers.pop();
+    }
     return f;
   } else {
     return P_NIL;
@@ -78,15 +126,28 @@ d::DValue Interpreter::getValue(cstdstr& name) const {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-std::map<stdstr,d::DSymbol> BITS {
-  {"INTEGER", d::Symbol::make("INTEGER")},
-  {"REAL", d::Symbol::make("REAL")},
-  {"STRING", d::Symbol::make("STRING")}
-};
+d::DValue Interpreter::setValue(const d::LexAddr& a, d::DValue v) {
+  return stack ? stack->set(a.depth, a.slot, v) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Interpreter::getValue(const d::LexAddr& a) const {
+  return stack ? stack->get(a.depth, a.slot) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// made per run, symbols are never shared across isolates
+static d::SymbolMap bits() {
+  return d::SymbolMap {
+    {"INTEGER", d::Symbol::make("INTEGER")},
+    {"REAL", d::Symbol::make("REAL")},
+    {"STRING", d::Symbol::make("STRING")}
+  };
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Interpreter::check(d::DAst tree) {
-  symbols= d::Table::make("root", BITS);
+  symbols= d::Table::make("root", bits());
   tree->visit(this);
 }
 
@@ -106,6 +167,11 @@ d::DSymbol Interpreter::define(d::DSymbol s) {
   return s;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::LexAddr Interpreter::resolve(cstdstr& n) const {
+  return symbols ? symbols->resolve(n) : d::LexAddr();
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DTable Interpreter::pushScope(cstdstr& name) {
   symbols= d::Table::make(name, symbols);
@@ -125,43 +191,54 @@ d::DTable Interpreter::popScope() {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Interpreter::readString() {
   stdstr s;
-  std::cin >> s;
+  d::Isolate::current()->in() >> s;
   return s;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 double Interpreter::readFloat() {
   double d;
-  std::cin >> d;
+  d::Isolate::current()->in() >> d;
   return d;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 llong Interpreter::readInt() {
   llong n;
-  std::cin >> n;
+  d::Isolate::current()->in() >> n;
   return n;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Interpreter::writeString(cstdstr& s) {
-  ::printf("%s", s.c_str());
+  d::Isolate::current()->out() << s;
 }
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Interpreter::writeFloat(double d) {
-  ::printf("%lf", d);
+  char buf[64];
+  ::snprintf(buf, sizeof(buf), "%lf", d);
+  d::Isolate::current()->out() << buf;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Interpreter::writeInt(llong n) {
-  std::cout << n;
-  //::printf("%ld", n);
+  d::Isolate::current()->out() << n;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Interpreter::writeln() {
-  ::printf("%s", "\n");
+  d::Isolate::current()->out() << "\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::Value Interpreter::input(int kind) {
+  switch (kind) {
+    case d::K_INT: return d::Value::of(readInt());
+    case d::K_REAL: return d::Value::of(readFloat());
+    case d::K_STR: return d::Value(d::String::make(readString()));
+  }
+  return d::Value();
 }
 
 
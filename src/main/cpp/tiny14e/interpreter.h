@@ -13,6 +13,9 @@
  *
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
+#include <stack>
+#include "../dsl/cache.h"
+#include "../dsl/fold.h"
 #include "parser.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -20,13 +23,17 @@ namespace czlab::tiny14e {
 namespace d= czlab::dsl;
 //
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-struct Interpreter : public EvaluatorAPI, public AnalyzerAPI {
+struct Interpreter : public EvaluatorAPI,
+                     public AnalyzerAPI, public d::IHost {
   //evaluator
   virtual d::DValue setValueEx(cstdstr&, d::DValue);
   virtual d::DValue setValue(cstdstr&, d::DValue);
   virtual d::DValue getValue(cstdstr&) const;
+  virtual d::DValue setValue(const d::LexAddr&, d::DValue);
+  virtual d::DValue getValue(const d::LexAddr&) const;
 
   virtual d::DFrame pushFrame(cstdstr& name);
+  virtual d::DFrame pushFrame(cstdstr&, d::DTable, d::DFrame);
   virtual d::DFrame popFrame();
   virtual d::DFrame peekFrame() const;
 
@@ -39,21 +46,41 @@ struct Interpreter : public EvaluatorAPI, public AnalyzerAPI {
   void writeInt(llong);
   void writeln();
 
+  //vm
+  virtual void write(cstdstr& s) { writeString(s); }
+  virtual d::Value input(int kind);
+
   //analyzer
   virtual d::DSymbol search(cstdstr&) const;
   virtual d::DSymbol find(cstdstr&) const;
   virtual d::DTable pushScope(cstdstr&);
   virtual d::DTable popScope();
   virtual d::DSymbol define(d::DSymbol);
+  virtual d::LexAddr resolve(cstdstr&) const;
 
-  Interpreter(const Tchar* src);
+  // compiled runs the program on the vm, unless under a profiler
+  // or if the program has a node without bytecode, a cache dir
+  // keeps the bytecode across runs, see dsl/cache.h
+  Interpreter(const Tchar* src, bool compiled=false, cstdstr& cache="");
+  // the program's value, nil if it ran compiled
   d::DValue interpret();
+  // node counts around constant folding, zero on a cache hit
+  d::FoldCounts folded;
+  // a dir to build the program into as C++ and run that, see
+  // native.h, the vm or the tree walker if it cannot be
+  stdstr native;
+  // if the last interpret() ran the built program
+  bool ranNative=false;
   virtual ~Interpreter() {}
 
   private:
 
   const Tchar* source;
+  bool compiled;
+  stdstr cache;
   d::DFrame stack;
+  // frames link lexically, so returns go through here
+  std::stack<d::DFrame> callers;
   d::DTable symbols;
   void check(d::DAst);
   d::DValue eval(d::DAst);
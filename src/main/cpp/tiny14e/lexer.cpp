@@ -20,7 +20,7 @@ namespace a = czlab::aeon;
 namespace d = czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-std::map<int, stdstr> TOKENS {
+constexpr d::Keyword TOKENS[] {
   {T_PROCEDURE, "PROCEDURE"},
   {T_PROGRAM, "PROGRAM"},
   {T_WRITELN, "WRITELN"},
@@ -45,13 +45,12 @@ std::map<int, stdstr> TOKENS {
   {T_END, "END"}
 };
 
-auto KEYWORDS= a::map_reflect(TOKENS);
+constexpr d::KeywordTable KEYWORDS(TOKENS);
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr typeToString(int type) {
-  return s__contains(TOKENS, type)
-         ? map__val(TOKENS,type)
-         : ("token-type=" + N_STR(type));
+  auto s= KEYWORDS.name(type);
+  return s.size() ? stdstr(s) : ("token-type=" + N_STR(type));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -63,7 +62,7 @@ Lexer::Lexer(const Tchar* src) {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Lexer::isKeyword(cstdstr& k) const {
-  return s__contains(KEYWORDS, k);
+  return KEYWORDS.contains(k);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -102,112 +101,117 @@ bool lexer_id(Tchar ch, bool first) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Lexer::id() {
   auto res= d::identifier(_ctx, &lexer_id);
-  auto S= a::to_upper(_1(res));
-  return !isKeyword(S)
+  auto t= KEYWORDS.find(_1(res), true);
+  return t < 0
          ? d::Token::make(d::T_IDENT, _1(res), _2(res))
-         : d::Token::make(KEYWORDS.at(S), S, _2(res));
+         : d::Token::make(t, a::to_upper(_1(res)), _2(res));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Lexer::getNextToken() {
-  while (!_ctx.eof) {
-    auto ch= d::peek(_ctx);
-
-    if (::isspace(ch))
-    { d::skipWhitespace(_ctx); continue; }
-
-    if (::isdigit(ch)) return number();
-
-    if (ch == '"') return string();
-
-    if (ch == '*')
-      return d::Token::make(d::T_MULT,
-                            ch, d::mark_advance(_ctx));
-
-    if (ch == '/')
-      return d::Token::make(d::T_DIV,
-                            ch, d::mark_advance(_ctx));
-
-    if (ch == '+')
-      return d::Token::make(d::T_PLUS,
-                            ch,
-                            d::mark_advance(_ctx));
-
-    if (ch == '-')
-      return d::Token::make(d::T_MINUS,
-                            ch, d::mark_advance(_ctx));
-
-    if (ch == '(')
-      return d::Token::make(d::T_LPAREN,
-                            ch, d::mark_advance(_ctx));
-
-    if (ch == ')')
-      return d::Token::make(d::T_RPAREN,
-                            ch, d::mark_advance(_ctx));
-
-    if (lexer_id(ch,true)) return id();
-
-    if (ch== ':' &&
-        '=' == d::peekAhead(_ctx))
-      return d::Token::make(T_ASSIGN,
-                            ":=", d::mark_advance(_ctx,2));
-
-    if (ch== '=' &&
-        '=' == d::peekAhead(_ctx))
-      return d::Token::make(T_EQUALS,
-                            "==", d::mark_advance(_ctx,2));
-
-    if (ch == '{')
-    { d::advance(_ctx);
-      skipComment(); continue; }
-
-    if (ch == '<')
-    { if (d::peekAhead(_ctx) == '=')
-        return d::Token::make(T_LTEQ,
-                              "<=", d::mark_advance(_ctx,2));
-      if (d::peekAhead(_ctx) == '>')
-        return d::Token::make(T_NOTEQ,
-                              "<>", d::mark_advance(_ctx,2));
-      return d::Token::make(d::T_LT, ch, d::mark_advance(_ctx)); }
-
-    if (ch == '>')
-    { if (d::peekAhead(_ctx) == '=')
-        return d::Token::make(T_GTEQ,
-                              ">=", d::mark_advance(_ctx,2));
-      else
-        return d::Token::make(d::T_GT, ch, d::mark_advance(_ctx)); }
-
-    if (ch == '|' &&
-        d::peekAhead(_ctx) == '|')
-      return d::Token::make(T_OR, "||", d::mark_advance(_ctx,2));
-
-    if (ch == '&' &&
-        d::peekAhead(_ctx) == '&')
-      return d::Token::make(T_AND, "&&", d::mark_advance(_ctx,2));
-
-    if (ch == ';')
-      return d::Token::make(d::T_SEMI, ch, d::mark_advance(_ctx));
-
-    if (ch == '!')
-      return d::Token::make(T_NOT, ch, d::mark_advance(_ctx));
-
-    if (ch == '~')
-      return d::Token::make(T_XOR, ch, d::mark_advance(_ctx));
-
-    if (ch == ':')
-      return d::Token::make(d::T_COLON, ch, d::mark_advance(_ctx));
+  skip(_ctx);
+  auto m= _ctx.mark();
+  _one.reset(_ctx.src, _ctx.len);
+  return _one.token(scan(_ctx, _one), m);
+}
 
-    if (ch == ',')
-      return d::Token::make(d::T_COMMA, ch, d::mark_advance(_ctx));
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Lexer::tokenize(d::TokenBuffer& out) {
+  d::Context c;
+  c.src= _ctx.src;
+  c.len= _ctx.len;
+  out.reset(c.src, c.len);
+  int i;
+  do {
+    skip(c);
+    i= scan(c, out);
+  } while (out.types[i] != d::T_EOF);
+}
 
-    if (ch == '.')
-      return d::Token::make(d::T_DOT, ch, d::mark_advance(_ctx));
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Lexer::skip(d::Context& c) {
+  // whitespace and comments
+  while (!c.eof) {
+    auto ch= d::peek(c);
+    if (::isspace(ch)) {
+      d::skipWhitespace(c); }
+    else if (ch == '{') {
+      auto p= c.pos+1;
+      auto e= (const Tchar*) ::memchr(c.src+p, '}', c.len-p);
+      d::advance(c, e ? (int)(e-c.src)-c.pos+1 : (int)c.len-c.pos); }
+    else break; }
+}
 
-    //else
-    return d::Token::make(d::T_ROGUE, ch, d::mark_advance(_ctx));
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static int punct(Tchar ch) {
+  switch (ch) {
+  case '*': return d::T_MULT;
+  case '/': return d::T_DIV;
+  case '+': return d::T_PLUS;
+  case '-': return d::T_MINUS;
+  case '(': return d::T_LPAREN;
+  case ')': return d::T_RPAREN;
+  case '<': return d::T_LT;
+  case '>': return d::T_GT;
+  case ';': return d::T_SEMI;
+  case '!': return T_NOT;
+  case '~': return T_XOR;
+  case ':': return d::T_COLON;
+  case ',': return d::T_COMMA;
+  case '.': return d::T_DOT;
+  default: return d::T_ROGUE;
   }
+}
 
-  return d::Token::make(d::T_EOF, "<EOF>", _ctx.mark());
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static int punct2(Tchar ch, Tchar nx) {
+  if (ch == ':' && nx == '=') return T_ASSIGN;
+  if (ch == '=' && nx == '=') return T_EQUALS;
+  if (ch == '<' && nx == '=') return T_LTEQ;
+  if (ch == '<' && nx == '>') return T_NOTEQ;
+  if (ch == '>' && nx == '=') return T_GTEQ;
+  if (ch == '|' && nx == '|') return T_OR;
+  if (ch == '&' && nx == '&') return T_AND;
+  return 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Lexer::scan(d::Context& c, d::TokenBuffer& out) {
+  // one token at c, whitespace already skipped
+  auto p= c.pos;
+
+  if (c.eof)
+    return out.add(d::T_EOF, p, 0, out.addLit(stdstr("<EOF>")));
+
+  auto ch= d::peek(c);
+
+  if (::isdigit(ch)) {
+    auto v= d::numeric_view(c);
+    stdstr s(v);
+    auto cs= s.c_str();
+    return ::strchr(cs, '.')
+      ? out.add(d::T_REAL, p, c.pos-p, out.addLit(::atof(cs)))
+      : out.add(d::T_INT, p, c.pos-p, out.addLit((llong) ::atol(cs))); }
+
+  if (ch == '"') {
+    auto res = d::str(c);
+    return out.add(d::T_STRING, p, c.pos-p, out.addLit(_1(res))); }
+
+  if (lexer_id(ch,true)) {
+    auto v= d::identifier_view(c, &lexer_id);
+    auto t= KEYWORDS.find(v, true);
+    if (t < 0)
+      return out.add(d::T_IDENT, p, c.pos-p);
+    auto S= a::to_upper(stdstr(v));
+    return out.add(t, p, c.pos-p,
+                   v == S ? -1 : out.addLit(S)); }
+
+  if (auto t= punct2(ch, d::peekAhead(c)); t) {
+    d::advance(c, 2);
+    return out.add(t, p, 2); }
+
+  d::advance(c);
+  return out.add(punct(ch), p, 1);
 }
 
 
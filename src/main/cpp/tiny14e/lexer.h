@@ -71,6 +71,9 @@ struct Lexer : public d::IScanner {
   virtual d::DToken id();
   virtual d::DToken string();
 
+  // the whole source in one go, no heap tokens
+  void tokenize(d::TokenBuffer&);
+
   Lexer(const Tchar* src);
   virtual ~Lexer() {};
 
@@ -78,7 +81,12 @@ struct Lexer : public d::IScanner {
 
   private:
 
+  void skip(d::Context&);
+  int scan(d::Context&, d::TokenBuffer&);
+
   d::Context _ctx;
+  // scratch for getNextToken()
+  d::TokenBuffer _one;
 };
 
 
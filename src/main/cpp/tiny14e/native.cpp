@@ -0,0 +1,662 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#if !defined(WIN32) && !defined(_WIN32)
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+#include "../dsl/cache.h"
+#include "../dsl/fold.h"
+#include "types.h"
+#include "native.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::tiny14e {
+namespace a = czlab::aeon;
+namespace d = czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// The generated source needs no headers, so it builds quickly.
+// The semantics are those of compiler.cpp, node for node.
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// laid out as NativeIO in native.h
+const char* PRELUDE= R"(
+typedef long long llong;
+struct NativeIO {
+  void* host;
+  void (*putInt)(void*, llong);
+  void (*putReal)(void*, double);
+  void (*putStr)(void*, const char*);
+  void (*flush)(void*, int);
+  llong (*readInt)(void*);
+  double (*readReal)(void*);
+  void (*divZero)(void*, int real);
+};
+)";
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+const char* ENTRY= "tiny14e_main";
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void unsupported(cstdstr& what) {
+  RAISE(d::Unsupported, "No C++ for %s", C_STR(what));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr ctype(int kind) {
+  if (kind == d::K_INT) { return "llong"; }
+  if (kind == d::K_REAL) { return "double"; }
+  unsupported("kind " + N_STR(kind));
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool isNumber(const Expr& x) {
+  return x.kind == d::K_INT || x.kind == d::K_REAL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void wantNumber(const Expr& x) {
+  if (!isNumber(x)) { unsupported("kind " + N_STR(x.kind)); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr real(double r) {
+  char buf[40];
+  ::snprintf(buf, sizeof(buf), "%.17g", r);
+  stdstr s(buf);
+  if (s.find_first_of(".e") == stdstr::npos) { s += ".0"; }
+  return s;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a C string literal, octal escapes for anything not plain
+stdstr quote(cstdstr& s) {
+  stdstr out("\"");
+  for (auto c : s) {
+    auto u= (unsigned char) c;
+    if (u < 32 || u > 126 || c == '"' || c == '\\' || c == '?') {
+      char buf[8];
+      ::snprintf(buf, sizeof(buf), "\\%03o", u);
+      out += buf;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int kindOf(cstdstr& type) {
+  return type == "INTEGER" ? d::K_INT
+         : (type == "REAL" ? d::K_REAL : (type == "STRING" ? d::K_STR : d::K_ANY));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Native::lower(d::DAst program) {
+  std::ostringstream main;
+  out= &main;
+  stmt(program);
+  stdstr s= "// tiny14e program " + DCAST(Ast,program)->name() + "\n";
+  s += PRELUDE;
+  s += "struct G {\n  const NativeIO* io;\n";
+  for (auto& x : globals) {
+    s += "  " + ctype(x.second) + " v" + N_STR(x.first) + ";\n";
+  }
+  s += "};\n"
+       "static inline llong quot(G& g, llong a, llong b) {\n"
+       "  if (b == 0) { g.io->divZero(g.io->host, 0); }\n"
+       "  return a / b;\n"
+       "}\n"
+       // zero as a::fuzzy_zero has it
+       "static inline double rquot(G& g, double a, double b) {\n"
+       "  if (b > -1e-12 && b < 1e-12) { g.io->divZero(g.io->host, 1); }\n"
+       "  return a / b;\n"
+       "}\n";
+  s += decls + funcs;
+  s += stdstr("extern \"C\" void ") + ENTRY + "(const NativeIO* io) {\n"
+       "  G g{};\n"
+       "  g.io= io;\n";
+  return s + main.str() + "}\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Native::expr(const d::DAst& x) {
+  if (typeid(*x) != typeid(d::Literal)) {
+    return DCAST(Ast, x)->lower(this);
+  }
+  auto& v= DCAST(d::Literal, x)->value;
+  if (auto p= vcast<d::Number>(v); p) {
+    return p->isInt()
+           ? Expr{"(" + N_STR(p->getInt()) + "LL)", d::K_INT}
+           : Expr{"(" + real(p->getFloat()) + ")", d::K_REAL};
+  }
+  if (auto p= vcast<d::String>(v); p) {
+    return Expr{quote(p->pr_str()), d::K_STR};
+  }
+  unsupported("literal");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Native::stmt(const d::DAst& x) {
+  expr(x);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Native::line(cstdstr& s) {
+  *out << stdstr(2*indent, ' ') << s << "\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the program's own variables, or the current procedure's, as
+// only those two frames are at hand in the C++
+stdstr Native::var(Var* v, int& kind) {
+  if (!v->addr.ok()) { unsupported(v->name()); }
+  auto at= level - v->addr.depth;
+  auto& m= at == 0 ? globals : locals;
+  auto i= m.find(v->addr.slot);
+  if ((at != 0 && at != level) || i == m.end()) {
+    unsupported(v->name());
+  }
+  kind= i->second;
+  return (at == 0 ? "g.v" : "l") + N_STR(v->addr.slot);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// copy into the variable, cast to its type
+stdstr Native::assign(Var* v, const Expr& x) {
+  int k;
+  auto lhs= var(v, k);
+  return lhs + "= " + as(k, x) + ";";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// real to int truncates, as the vm's R2I does
+stdstr Native::as(int kind, const Expr& x) {
+  wantNumber(x);
+  if (kind == x.kind) { return x.code; }
+  return "((" + ctype(kind) + ") " + x.code + ")";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a real is true if its integer part is not zero, see toBool()
+stdstr Native::truth(const Expr& x) {
+  return "(" + as(d::K_INT, x) + " != 0)";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Native::fresh(cstdstr& prefix) {
+  return prefix + N_STR(++temps);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Ast::lower(Native*) {
+  unsupported(name());
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr BinOp::lower(Native* n) {
+  auto k= token()->type();
+  auto l= n->expr(lhs);
+  auto r= n->expr(rhs);
+  wantNumber(l);
+  wantNumber(r);
+  auto ints= l.kind == d::K_INT && r.kind == d::K_INT;
+  auto out= ints ? d::K_INT : d::K_REAL;
+  stdstr op;
+  switch (k) {
+    case d::T_PLUS: op= "+"; break;
+    case d::T_MINUS: op= "-"; break;
+    case d::T_MULT: op= "*"; break;
+    case T_INT_DIV:
+      if (!ints) {
+        // the tree walker reports it
+        unsupported("real div");
+      }
+      return Expr{"quot(g, " + l.code + ", " + r.code + ")", d::K_INT};
+    case d::T_DIV:
+      return Expr{"rquot(g, " + n->as(d::K_REAL, l) +
+                  ", " + n->as(d::K_REAL, r) + ")", d::K_REAL};
+    default:
+      unsupported("op " + N_STR(k));
+  }
+  return Expr{"(" + n->as(out, l) +
+              " " + op + " " + n->as(out, r) + ")", out};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr String::lower(Native*) {
+  return Expr{quote(token()->getStr()), d::K_STR};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Num::lower(Native*) {
+  if (token()->type() == d::T_INT) {
+    return Expr{"(" + N_STR(token()->getInt()) + "LL)", d::K_INT};
+  }
+  return Expr{"(" + real(token()->getFloat()) + ")", d::K_REAL};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr UnaryOp::lower(Native* n) {
+  auto x= n->expr(expr);
+  wantNumber(x);
+  if (token()->type() != d::T_MINUS) { return x; }
+  return Expr{"(-" + x.code + ")", x.kind};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Compound::lower(Native* n) {
+  for (auto& s : statements) { n->stmt(s); }
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr NoOp::lower(Native*) {
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Assignment::lower(Native* n) {
+  n->line(n->assign(DCAST(Var, lhs), n->expr(rhs)));
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Var::lower(Native* n) {
+  int k;
+  auto v= n->var(this, k);
+  return Expr{v, k};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Type::lower(Native*) {
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// same as cast(nil, type), the slot's kind is fixed from here on
+Expr VarDecl::lower(Native* n) {
+  auto pv= DCAST(Var, var_node);
+  auto k= d::Assembler::kindOf(pv->type_symbol);
+  auto t= ctype(k);
+  if (!pv->addr.ok() || pv->addr.depth != 0) { unsupported(name()); }
+  auto s= pv->addr.slot;
+  if (n->level == 0) {
+    n->globals[s]= k;
+    n->line("g.v" + N_STR(s) + "= 0;");
+  } else {
+    n->locals[s]= k;
+    n->line(t + " l" + N_STR(s) + "= 0;");
+  }
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// left to right, an OR that holds ends it, as in eval()
+Expr BoolExpr::lower(Native* n) {
+  if (terms.size() == 1) { return n->expr(terms[0]); }
+  stdstr s= "[&]() -> llong { llong r= " + n->truth(n->expr(terms[0])) + "; ";
+  for (size_t i=0; i < ops.size(); ++i) {
+    auto x= n->truth(n->expr(terms[i+1]));
+    if (ops[i]->type() == T_XOR) {
+      s += "r= (r != " + x + "); ";
+    } else {
+      s += "if (r) { return 1; } r= " + x + "; ";
+    }
+  }
+  return Expr{s + "return r; }()", d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the answer is the first two terms, as in eval()
+Expr BoolTerm::lower(Native* n) {
+  if (terms.size() == 1) { return n->expr(terms[0]); }
+  auto a= n->truth(n->expr(terms[0]));
+  auto b= n->truth(n->expr(terms[1]));
+  for (size_t i=2; i < terms.size(); ++i) {
+    // evaluated but the answer is already false
+    wantNumber(n->expr(terms[i]));
+  }
+  return Expr{"((llong) (" + a + " && " + b + "))", d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr NotFactor::lower(Native* n) {
+  return Expr{"((llong) !" + n->truth(n->expr(expr)) + ")", d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr RelationOp::lower(Native* n) {
+  auto l= n->expr(lhs);
+  auto r= n->expr(rhs);
+  wantNumber(l);
+  wantNumber(r);
+  auto k= l.kind == d::K_INT && r.kind == d::K_INT ? d::K_INT : d::K_REAL;
+  stdstr op;
+  switch (token()->type()) {
+    case d::T_LT: op= "<"; break;
+    case d::T_GT: op= ">"; break;
+    case T_LTEQ: op= "<="; break;
+    case T_GTEQ: op= ">="; break;
+    case T_EQUALS: op= "=="; break;
+    case T_NOTEQ: op= "!="; break;
+    default: unsupported("op " + N_STR(token()->type()));
+  }
+  return Expr{"((llong) (" + n->as(k, l) +
+              " " + op + " " + n->as(k, r) + "))", d::K_INT};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Block::lower(Native* n) {
+  for (auto& x : declarations) { n->stmt(x); }
+  n->stmt(compound);
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a static function of its own, the params are the first slots
+Expr ProcedureDecl::lower(Native* n) {
+  auto fn= "p" + N_STR(n->procs.size()) + "_" + name();
+  stdstr sig= "static void " + fn + "(G& g";
+  std::map<int,int> locals;
+  for (size_t i=0; i < params.size(); ++i) {
+    auto pm= DCAST(VarDecl, params[i]);
+    auto k= kindOf(DCAST(Ast, pm->type_node)->name());
+    sig += ", " + ctype(k) + " l" + N_STR(i);
+    locals[i]= k;
+  }
+  sig += ")";
+  // before the body, which may call itself
+  n->procs[block.get()]= fn;
+
+  std::ostringstream body;
+  auto out= n->out;
+  auto indent= n->indent;
+  std::swap(n->locals, locals);
+  n->out= &body;
+  n->indent= 1;
+  ++n->level;
+  n->stmt(block);
+  --n->level;
+  n->out= out;
+  n->indent= indent;
+  std::swap(n->locals, locals);
+
+  n->decls += sig + ";\n";
+  n->funcs += sig + " {\n" + body.str() + "}\n";
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr ProcedureCall::lower(Native* n) {
+  auto fs= DCAST(d::FnSymbol, proc_symbol);
+  auto& ps= fs->params();
+  auto f= n->procs.find(fs->body().get());
+  if (ps.size() != args.size() || f == n->procs.end()) {
+    // the tree walker reports it
+    unsupported(name());
+  }
+  stdstr s= f->second + "(g";
+  for (size_t i=0; i < args.size(); ++i) {
+    s += ", " + n->as(d::Assembler::kindOf(ps[i]->type()), n->expr(args[i]));
+  }
+  n->line(s + ");");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Program::lower(Native* n) {
+  n->stmt(block);
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// loops for as long as cond holds, as in eval()
+Expr RepeatUntil::lower(Native* n) {
+  n->line("do {");
+  ++n->indent;
+  n->stmt(code);
+  --n->indent;
+  n->line("} while " + n->truth(n->expr(cond)) + ";");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr IfThenElse::lower(Native* n) {
+  n->line("if " + n->truth(n->expr(cond)) + " {");
+  ++n->indent;
+  n->stmt(then);
+  --n->indent;
+  if (elze) {
+    n->line("} else {");
+    ++n->indent;
+    n->stmt(elze);
+    --n->indent;
+  }
+  n->line("}");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the bound and the counter are read again each pass, and the
+// counter goes back into the variable, as in eval()
+Expr ForLoop::lower(Native* n) {
+  auto pv= DCAST(Var, var_node);
+  int k;
+  auto v= n->var(pv, k);
+  wantNumber(Expr{v, k});
+  n->line(n->assign(pv, n->expr(init)));
+  auto z= n->fresh("z");
+  auto i= n->fresh("i");
+  n->line("for (;;) {");
+  ++n->indent;
+  n->line("llong " + z + "= " + n->as(d::K_INT, n->expr(term)) + ";");
+  n->line("llong " + i + "= " + n->as(d::K_INT, Expr{v, k}) + ";");
+  n->line("if (" + z + " < " + i + ") { break; }");
+  n->stmt(code);
+  n->line(n->assign(pv, Expr{"(" + i + " + 1)", d::K_INT}));
+  --n->indent;
+  n->line("}");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr WhileLoop::lower(Native* n) {
+  n->line("while " + n->truth(n->expr(cond)) + " {");
+  ++n->indent;
+  n->stmt(code);
+  --n->indent;
+  n->line("}");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr VarInput::lower(Native* n) {
+  int k;
+  auto v= n->var(this, k);
+  auto f= k == d::K_INT ? "readInt" : "readReal";
+  n->line(v + "= g.io->" + f + "(g.io->host);");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Read::lower(Native* n) {
+  n->stmt(var_node);
+  if (token()->type() == T_READLN) {
+    n->line("g.io->flush(g.io->host, 1);");
+  }
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Expr Write::lower(Native* n) {
+  for (auto& t : terms) {
+    auto x= n->expr(t);
+    auto f= x.kind == d::K_INT ? "putInt"
+            : (x.kind == d::K_REAL ? "putReal" : "putStr");
+    if (x.kind == d::K_ANY) { unsupported(name()); }
+    n->line(stdstr("g.io->") + f + "(g.io->host, " + x.code + ");");
+  }
+  n->line(stdstr("g.io->flush(g.io->host, ") +
+          (token()->type() == T_WRITELN ? "1" : "0") + ");");
+  return Expr{"", d::K_ANY};
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the line buffer of the vm's PUT and FLUSH
+struct Sink {
+  EvaluatorAPI* e;
+  stdstr line;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void putInt(void* h, llong n) { ((Sink*) h)->line += N_STR(n); }
+void putReal(void* h, double r) { ((Sink*) h)->line += N_STR(r); }
+void putStr(void* h, const char* s) { ((Sink*) h)->line += s; }
+llong readInt(void* h) { return ((Sink*) h)->e->readInt(); }
+double readReal(void* h) { return ((Sink*) h)->e->readFloat(); }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void flush(void* h, int nl) {
+  auto s= (Sink*) h;
+  s->e->writeString(s->line);
+  if (nl) { s->e->writeln(); }
+  s->line.clear();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void divZero(void*, int real) {
+  ASSERT(!real, "Div by zero error, %s", "0");
+  ASSERT(false, "Div by int-zero error, %s", "0");
+}
+
+#if defined(WIN32) || defined(_WIN32)
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Native::build(cstdstr&, cstdstr&) {
+  unsupported("this platform");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Native::run(cstdstr&, EvaluatorAPI*) {
+  unsupported("this platform");
+}
+#else
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// args run as is, no shell, stdout and stderr into the log.
+// The exit status, -1 if it could not run.
+int spawn(const std::vector<stdstr>& args, cstdstr& log) {
+  auto fd= ::open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) { return -1; }
+  std::vector<char*> argv;
+  for (auto& s : args) { s__conj(argv, const_cast<char*>(s.c_str())); }
+  s__conj(argv, P_NIL);
+  posix_spawn_file_actions_t fa;
+  ::posix_spawn_file_actions_init(&fa);
+  ::posix_spawn_file_actions_adddup2(&fa, fd, 1);
+  ::posix_spawn_file_actions_adddup2(&fa, fd, 2);
+  pid_t pid;
+  auto rc= ::posix_spawnp(&pid, argv[0], &fa, P_NIL, argv.data(), environ);
+  ::posix_spawn_file_actions_destroy(&fa);
+  if (rc != 0) {
+    ::dprintf(fd, "%s: %s\n", argv[0], ::strerror(rc));
+  }
+  ::close(fd);
+  if (rc != 0) { return -1; }
+  int st;
+  while (::waitpid(pid, &st, 0) < 0) {
+    if (errno != EINTR) { return -1; }
+  }
+  return WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// named after the source, so a rerun loads what was built before.
+// Built to a temp name then renamed, as ProgramCache saves.
+// $CXX if set, else c++, split on blanks as "ccache c++" is.
+stdstr Native::build(cstdstr& cpp, cstdstr& dir) {
+  auto key= d::ProgramCache::key("tiny14e-cpp", cpp.c_str());
+  auto so= dir + "/" + key + ".so";
+  struct stat st;
+  if (::stat(so.c_str(), &st) == 0) { return so; }
+  ::mkdir(dir.c_str(), 0755);
+  auto tmp= dir + "/" + key + "." + N_STR(::getpid()) + "." +
+            N_STR(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  auto src= tmp + ".cpp";
+  {
+    std::ofstream f(src, std::ios::trunc);
+    if (!(f << cpp)) { unsupported("a source file in " + dir); }
+  }
+  auto cxx= ::getenv("CXX");
+  std::istringstream words(cxx && *cxx ? cxx : "c++");
+  std::vector<stdstr> args;
+  for (stdstr w; words >> w;) { s__conj(args, w); }
+  if (args.empty()) { s__conj(args, "c++"); }
+  for (auto x : {"-O2", "-shared", "-fPIC", "-o"}) { s__conj(args, x); }
+  s__conj(args, tmp + ".so");
+  s__conj(args, src);
+  auto rc= spawn(args, tmp + ".log");
+  ::remove(src.c_str());
+  if (rc != 0 || ::rename((tmp + ".so").c_str(), so.c_str()) != 0) {
+    ::remove((tmp + ".so").c_str());
+    // the log is kept, it says why
+    unsupported("a build, see " + tmp + ".log");
+  }
+  ::remove((tmp + ".log").c_str());
+  return so;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Native::run(cstdstr& so, EvaluatorAPI* e) {
+  auto h= ::dlopen(so.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!h) { unsupported(::dlerror()); }
+  auto f= (void (*)(const NativeIO*)) ::dlsym(h, ENTRY);
+  if (!f) {
+    ::dlclose(h);
+    unsupported(ENTRY);
+  }
+  Sink s{e, ""};
+  NativeIO io{&s, putInt, putReal, putStr, flush, readInt, readReal, divZero};
+  try {
+    f(&io);
+  } catch (...) {
+    ::dlclose(h);
+    throw;
+  }
+  ::dlclose(h);
+}
+#endif
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,104 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
+
+#include <map>
+#include <sstream>
+#include "../dsl/vm.h"
+#include "parser.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::tiny14e {
+namespace d= czlab::dsl;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// C++ for an expression, and its kind, see dsl/vm.h
+struct Expr {
+  stdstr code;
+  int kind;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// What the built program calls back into, plain C so it can be
+// spelled out again in the generated source.  Output goes through
+// the host as on the vm, so numbers print the same.
+struct NativeIO {
+  void* host;
+  void (*putInt)(void*, llong);
+  void (*putReal)(void*, double);
+  void (*putStr)(void*, const char*);
+  void (*flush)(void*, int nl);
+  llong (*readInt)(void*);
+  double (*readReal)(void*);
+  void (*divZero)(void*, int real);
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// Ahead of time: the analyzed tree as C++, built by the system
+// compiler into a shared object, then loaded and called.
+//
+// Variables are int or real, as declared (Assignment casts), so
+// they become llong and double.  The program's own variables live
+// in one struct every procedure gets, a procedure's in its C++
+// frame.  A procedure reading the locals of the one around it, a
+// string variable, or anything else without a lowering throws
+// d::Unsupported, before anything is built or run, and the
+// program runs on the vm or the tree walker instead.
+struct Native {
+
+  // the C++ for the program, see NativeIO for the entry point
+  stdstr lower(d::DAst program);
+
+  // the shared object for the source, built once into dir, throws
+  // d::Unsupported if there is no compiler or it fails
+  static stdstr build(cstdstr& cpp, cstdstr& dir);
+  // load and call the entry point, writing and reading through e
+  static void run(cstdstr& so, EvaluatorAPI* e);
+
+  // children, a folded Literal included
+  Expr expr(const d::DAst&);
+  void stmt(const d::DAst&);
+  void line(cstdstr&);
+
+  // the variable as an lvalue, its kind in kind
+  stdstr var(Var*, int& kind);
+  stdstr assign(Var*, const Expr&);
+  // the value as an int, 0 or 1 as C++ sees it
+  stdstr truth(const Expr&);
+  stdstr as(int kind, const Expr&);
+  stdstr fresh(cstdstr& prefix);
+
+  // the program's variables, and the current procedure's
+  std::map<int,int> globals;
+  std::map<int,int> locals;
+  // by the procedure's body, see d::FnSymbol
+  std::map<const d::Node*, stdstr> procs;
+  stdstr decls;
+  stdstr funcs;
+  std::ostringstream* out=P_NIL;
+  int level=0;
+  int indent=1;
+  int temps=0;
+
+  Native() {}
+  ~Native() {}
+};
+
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -13,6 +13,7 @@
  * Copyright © 2013-2020, Kenneth Leung. All rights reserved. */
 
 #include <typeinfo>
+#include "../dsl/profiler.h"
 #include "types.h"
 #include "parser.h"
 
@@ -66,6 +67,13 @@ d::DValue cast(d::DValue v, d::DSymbol t) {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool toBool(d::DValue e) { return toInt(e) != 0L; }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the profiler's name for a node, at the line of its token
+d::Profiler::Site site(const d::DAst& n, cstdstr& what) {
+  auto t= DCAST(Ast,n)->token();
+  return d::Profiler::Site{t ? t->addr().first : 0, what};
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Ast::name() const {
   return DCAST(d::Token,_token)->getStr();
@@ -237,6 +245,8 @@ void Compound::visit(d::IAnalyzer* a) {
 d::DValue Compound::eval(d::IEvaluator* e) {
   d::DValue ret;
   for (auto& it : statements) {
+    d::Probe _p(e, it.get(),
+                [&]() { return site(it, d::Profiler::nameOf(it.get())); });
     ret=it->eval(e);
   }
   return ret;
@@ -262,17 +272,21 @@ void Assignment::visit(d::IAnalyzer* a) {
           C_STR(pn), d::pr_addr(i).c_str());
   }
   s__cast(Var,pl)->type_symbol= s->type();
+  pl->visit(a);
+  rhs->visit(a);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Assignment::eval(d::IEvaluator* e) {
   auto pl= DCAST(Ast,lhs);
   auto v = pl->token()->getStr();
-  auto t= s__cast(Var,pl)->type_symbol;
+  auto pv= s__cast(Var,pl);
+  auto t= pv->type_symbol;
   auto r= rhs->eval(e);
   DEBUG("Assigning value %s to %s.",
         C_STR(r->pr_str()), C_STR(v));
-  return e->setValueEx(v, cast(r,t));
+  return pv->addr.ok()
+         ? e->setValue(pv->addr, cast(r,t)) : e->setValueEx(v, cast(r,t));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -286,17 +300,20 @@ stdstr Var::name() const {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Var::visit(d::IAnalyzer* a) {
   auto n = name();
-  if (auto x= a->search(n); !x) {
+  auto x= a->search(n);
+  if (!x) {
     auto i= token()->addr();
     E_SEMANTIC(
           "Unknown var %s near %s",
           C_STR(n), d::pr_addr(i).c_str());
   }
+  if (!type_symbol) { type_symbol= x->type(); }
+  addr= a->resolve(n);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Var::eval(d::IEvaluator* e) {
-  return e->getValue( name());
+  return addr.ok() ? e->getValue(addr) : e->getValue( name());
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -340,16 +357,20 @@ void VarDecl::visit(d::IAnalyzer* a) {
           C_STR(vname), d::pr_addr(i).c_str());
   }
 
-  DCAST(Var,var_node)->type_symbol= tsym;
+  auto pv= DCAST(Var,var_node);
+  pv->type_symbol= tsym;
   a->define(d::VarSymbol::make(vname, tsym));
+  pv->addr= a->resolve(vname);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue VarDecl::eval(d::IEvaluator* e) {
-  auto t= DCAST(Var,var_node)->type_symbol;
+  auto pv= DCAST(Var,var_node);
+  auto t= pv->type_symbol;
   d::DValue v;
   //std::cout << "var=== " << name() << "\n";
-  return e->setValue(name(), cast(v, t));
+  return pv->addr.ok()
+         ? e->setValue(pv->addr, cast(v, t)) : e->setValue(name(), cast(v, t));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -528,7 +549,7 @@ void ProcedureDecl::visit(d::IAnalyzer* a) {
   auto fs= d::FnSymbol::make( name());
   auto fp= DCAST(d::FnSymbol,fs);
   a->define(fs);
-  a->pushScope(name());
+  fp->setScope(a->pushScope(name()));
 
   for (auto& p : params) {
     auto pm = DCAST(VarDecl,p);
@@ -574,6 +595,7 @@ void ProcedureCall::visit(d::IAnalyzer* a) {
   //get the corresponding symbol
   if (auto x = a->search( name()); x) {
     proc_symbol = x;
+    addr= a->resolve(name());
   } else {
     auto i=token()->addr();
     E_SEMANTIC(
@@ -589,14 +611,26 @@ d::DValue ProcedureCall::eval(d::IEvaluator* e) {
   auto az= args.size();
   ASSERT(fz == az,
          "Mismatch sizes, params= %d, but args= %d.", (int)fz, (int)az);
-  e->pushFrame(name());
-  for (auto i=0; i < args.size(); ++i) {
+  // args belong to the caller's frame
+  d::ValVec vs;
+  for (auto& a : args) {
+    s__conj(vs, a->eval(e));
+  }
+  // link to the frame of the declaring scope, not the caller
+  e->pushFrame(name(),
+               fs->scope(), d::Frame::getOuter(e->peekFrame(), addr.depth));
+  for (auto i=0; i < (int) vs.size(); ++i) {
+    // params are the first slots in the proc's scope
     auto p= DCAST(d::VarSymbol,fs->params()[i]);
-    auto v= args[i]->eval(e);
-    e->setValue(p->name(), cast(v, p->type()));
+    e->setValue(d::LexAddr{0,i}, cast(vs[i], p->type()));
   }
 
-  auto r= fs->body()->eval(e);
+  d::DValue r;
+  {
+    d::Probe _p(e, fs->body().get(),
+                [&]() { return site(fs->body(), name()); });
+    r= fs->body()->eval(e);
+  }
   e->popFrame();
   return r;
 }
@@ -866,22 +900,24 @@ ForLoop::ForLoop(d::DToken t, d::DAst v, d::DAst i, d::DAst e, d::DAst code) : A
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue ForLoop::eval(d::IEvaluator* e) {
-  auto tn= DCAST(Var,var_node)->type_symbol;
-  auto vn= DCAST(Var,var_node)->name();
+  auto pv= DCAST(Var,var_node);
+  auto tn= pv->type_symbol;
   d::DValue ret;
 
   auto _i= init->eval(e);
-  e->setValueEx(vn, cast(_i,tn));
+  pv->addr.ok() ? e->setValue(pv->addr, cast(_i,tn))
+                : e->setValueEx(pv->name(), cast(_i,tn));
   //::printf("ready\n");
   while (1) {
     auto _t= term->eval(e);
     auto z= toInt(_t);
-    auto i= toInt(e->getValue(vn));
+    auto i= toInt(pv->eval(e));
     //::printf("z = %ld, i= %ld\n", z ,i);
     if (z >= i) {
       ret= code->eval(e);
       auto xxx= d::Number::make(i+1);
-      e->setValueEx(vn, cast(xxx, tn));
+      pv->addr.ok() ? e->setValue(pv->addr, cast(xxx, tn))
+                    : e->setValueEx(pv->name(), cast(xxx, tn));
     } else {
       break;
     }
@@ -948,13 +984,14 @@ d::DValue VarInput::eval(d::IEvaluator* e) {
     res = d::String::make( e_->readString());
   }
 
-  return e->setValueEx(name(), res);
+  return addr.ok() ? e->setValue(addr, res) : e->setValueEx(name(), res);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void VarInput::visit(d::IAnalyzer* a) {
   if (auto s = a->search(name()); s) {
     type_symbol= DCAST(d::VarSymbol,s)->type();
+    addr= a->resolve(name());
   } else {
     auto i= DCAST(d::Token,token())->addr();
     E_SEMANTIC(
@@ -1258,8 +1295,9 @@ CrenshawParser::~CrenshawParser() {
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-CrenshawParser::CrenshawParser(const char* src) {
+CrenshawParser::CrenshawParser(const char* src) : cursor(&toks) {
   lex = new Lexer(src);
+  lex->tokenize(toks);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -1269,48 +1307,48 @@ d::DAst CrenshawParser::parse() {
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int CrenshawParser::cur() {
-  return lex->ctx().cur->type();
+  return cursor.type();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Tchar CrenshawParser::peek() {
-  return d::peek(lex->ctx());
+  return cursor.after();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool CrenshawParser::isEof() const {
-  return lex->ctx().cur->type() == d::T_EOF;
+  return cursor.isEof();
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool CrenshawParser::isCur(int type) {
-  return lex->ctx().cur->type() == type;
+  return cursor.isCur(type);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken CrenshawParser::token() {
-  return lex->ctx().cur;
+  if (!curTok) { curTok= toks.token(cursor.pos); }
+  return curTok;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken CrenshawParser::eat() {
   auto t= token();
-  lex->ctx().cur = lex->getNextToken();
+  cursor.eat();
+  curTok=DTKN_NIL;
   return t;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken CrenshawParser::eat(int wanted) {
-  auto t= token();
-  if (t->type() != wanted) {
-    auto i= DCAST(d::Token,t)->addr();
+  if (!cursor.isCur(wanted)) {
+    auto t= token();
     E_SYNTAX(
           "Expected token %s, found %s near %s",
           C_STR(typeToString(wanted)),
-          C_STR(t->pr_str()), d::pr_addr(i).c_str());
+          C_STR(t->pr_str()), d::pr_addr(t->addr()).c_str());
   }
-  lex->ctx().cur= lex->getNextToken();
-  return t;
+  return eat();
 }
 
 /* GRAMMER
@@ -21,6 +21,9 @@ namespace czlab::tiny14e {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace d = czlab::dsl;
 namespace a = czlab::aeon;
+// see native.h
+struct Native;
+struct Expr;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Reader {
@@ -55,6 +58,8 @@ struct Ast : public d::Node {
 
   virtual d::DValue eval(d::IEvaluator* e)=0;
   virtual void visit(d::IAnalyzer*) = 0;
+  // C++ for the node, throws d::Unsupported if it has none
+  virtual Expr lower(Native*);
 
   d::DToken token() const { return _token; }
 
@@ -83,6 +88,10 @@ struct BoolExpr : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
+  virtual int compileJump(d::Assembler*, bool);
   virtual stdstr name() const;
   virtual ~BoolExpr() {}
 
@@ -102,6 +111,10 @@ struct BoolTerm : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
+  virtual int compileJump(d::Assembler*, bool);
   virtual stdstr name() const;
   virtual ~BoolTerm() {}
 
@@ -120,6 +133,10 @@ struct RelationOp : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
+  virtual int compileJump(d::Assembler*, bool);
   virtual ~RelationOp() {}
 
   private:
@@ -138,6 +155,9 @@ struct BinOp : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual stdstr name() const;
   virtual ~BinOp() {}
 
@@ -153,6 +173,9 @@ struct Num : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST( Num,t);
@@ -171,6 +194,9 @@ struct String : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST( String,t);
@@ -193,6 +219,10 @@ struct NotFactor : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
+  virtual int compileJump(d::Assembler*, bool);
   virtual stdstr name() const;
   virtual ~NotFactor() {}
 
@@ -211,6 +241,9 @@ struct UnaryOp : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual stdstr name() const;
   virtual ~UnaryOp() {}
 
@@ -225,6 +258,9 @@ struct Compound : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST(Compound,t);
@@ -244,6 +280,8 @@ struct Compound : public Ast {
 struct Var : public Ast {
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST( Var,t);
@@ -253,6 +291,7 @@ struct Var : public Ast {
   virtual ~Var() {}
 
   d::DSymbol type_symbol;
+  d::LexAddr addr;
 
   protected:
 
@@ -264,6 +303,8 @@ struct VarInput : public Var {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST( VarInput,t);
@@ -282,6 +323,8 @@ struct Type : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
 
   static d::DAst make(d::DToken t) {
     return WRAP_AST( Type,t);
@@ -303,6 +346,9 @@ struct Write : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Write() {}
 
   private:
@@ -320,6 +366,8 @@ struct Read : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
   virtual ~Read() {}
 
   private:
@@ -337,6 +385,9 @@ struct WhileLoop : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~WhileLoop() {}
 
   private:
@@ -355,6 +406,9 @@ struct ForLoop : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~ForLoop() {}
 
   private:
@@ -379,6 +433,9 @@ struct IfThenElse : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~IfThenElse() {}
 
   private:
@@ -400,6 +457,9 @@ struct RepeatUntil : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~RepeatUntil() {}
 
   protected:
@@ -419,6 +479,9 @@ struct Assignment : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Assignment() {}
   virtual stdstr name() const;
 
@@ -434,6 +497,10 @@ struct NoOp : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*) { return P_NIL; }
   virtual void visit(d::IAnalyzer*) {}
+  virtual d::Operand compile(d::Assembler*, int) {
+    return d::Operand{-1, 0};
+  }
+  virtual Expr lower(Native*);
   virtual stdstr name() const { return "709394"; }
   virtual ~NoOp() {}
 
@@ -453,6 +520,8 @@ struct VarDecl : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
   virtual stdstr name() const;
   virtual ~VarDecl() {}
 
@@ -473,6 +542,9 @@ struct Block : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Block() {}
   virtual stdstr name() const;
 
@@ -493,6 +565,9 @@ struct ProcedureDecl : public Ast {
   virtual d::DValue eval(d::IEvaluator*);
   virtual ~ProcedureDecl() {}
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual stdstr name() const;
 
   private:
@@ -512,6 +587,9 @@ struct ProcedureCall : public Ast {
   virtual d::DValue eval(d::IEvaluator*);
   virtual ~ProcedureCall() {}
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual stdstr name() const;
 
   private:
@@ -519,6 +597,7 @@ struct ProcedureCall : public Ast {
   ProcedureCall(d::DToken, const d::AstVec&);
   d::AstVec args;
   d::DSymbol proc_symbol;
+  d::LexAddr addr;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -530,6 +609,9 @@ struct Program : public Ast {
 
   virtual d::DValue eval(d::IEvaluator*);
   virtual void visit(d::IAnalyzer*);
+  virtual d::Operand compile(d::Assembler*, int);
+  virtual Expr lower(Native*);
+  virtual d::DAst fold(d::Folder*);
   virtual ~Program() {}
   virtual stdstr name() const;
 
@@ -561,6 +643,10 @@ struct CrenshawParser : public d::IParser {
   private:
 
   Lexer* lex;
+  d::TokenBuffer toks;
+  d::TokenCursor cursor;
+  // the current token once asked for as a DToken
+  d::DToken curTok;
 };
 
 
@@ -89,14 +89,36 @@ begin { Main }\n\
    Alpha(3 + 5, 7);  { procedure call }\n\
 end.  { Main }\n\
 ";
+
+// the divisions never run, folding must leave them, prints 3
+const char* DEADDIV= "\n\
+program Dead;\n\
+var x : integer;\n\
+begin\n\
+  x := 1;\n\
+  if (0 && (1 / 0))\n\
+    x := 2;\n\
+  endif;\n\
+  if (1 || (4 div 0))\n\
+    x := x + 1;\n\
+  endif;\n\
+  if (0)\n\
+    x := 7 / 0;\n\
+  endif;\n\
+  writeLn(x + 1);\n\
+end.\n\
+";
 namespace czlab::tiny14e {
 namespace a=czlab::aeon;
 
 int main(int argc, char* argv[]) {
   try {
+    Interpreter dead(DEADDIV);
+    dead.interpret();
     auto src= a::read_file("/Users/kenl/Desktop/pas_triangle.pas");
     Interpreter i(src.c_str());
     i.interpret();
+    ::printf("nodes %d -> %d after folding\n", i.folded.before, i.folded.after);
     //::printf("result = %s\n", r.pr_str().c_str());
   } catch ( const d::SyntaxError& e) {
     ::printf("%s", e.what().c_str());